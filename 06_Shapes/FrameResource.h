@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../Common/GeometryGenerator.h"
 #include "../Common/MathHelper.h"
 #include "../Common/UploadBuffer.h"
 #include "../Common/d3dUtil.h"
@@ -29,6 +30,16 @@ struct Vertex {
     DirectX::XMFLOAT4 Color;
 };
 
+// Where the GeometryGenerator::MeshDataSoA streams land inside Vertex.  Color is
+// not a generator attribute, so it is filled in separately.
+inline GeometryGenerator::VertexLayout VertexInterleaveLayout()
+{
+    GeometryGenerator::VertexLayout layout;
+    layout.Stride = sizeof(Vertex);
+    layout.PositionOffset = offsetof(Vertex, Pos);
+    return layout;
+}
+
 // CPUΪÿ֡command listԴ
 class FrameResource {
 public:
@@ -499,90 +499,55 @@ void ShapesApp::BuildShadersAndInputLayout()
 
 void ShapesApp::BuildShapeGeometry()
 {
-    GeometryGenerator geoGen;
-    GeometryGenerator::MeshData box = geoGen.CreateBox(1.5f, 0.5f, 1.5f, 3);
-    GeometryGenerator::MeshData grid = geoGen.CreateGrid(20.0f, 30.0f, 60, 40);
-    GeometryGenerator::MeshData sphere = geoGen.CreateSphere(0.5f, 20, 20);
-    GeometryGenerator::MeshData cylinder = geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20);
+    typedef GeometryGenerator::ShapeDesc ShapeDesc;
 
     //
-    // We are concatenating all the geometry into one big vertex/index buffer.  So
-    // define the regions in the buffer each submesh covers.
+    // We are concatenating all the geometry into one big vertex/index buffer.
+    // CreateShapes builds the meshes in parallel straight into the combined
+    // buffers and reports the region each submesh covers.
     //
 
-    // Cache the vertex offsets to each object in the concatenated vertex buffer.
-    UINT boxVertexOffset = 0;
-    UINT gridVertexOffset = (UINT)box.Vertices.size();
-    UINT sphereVertexOffset = gridVertexOffset + (UINT)grid.Vertices.size();
-    UINT cylinderVertexOffset = sphereVertexOffset + (UINT)sphere.Vertices.size();
-
-    // Cache the starting index for each object in the concatenated index buffer.
-    UINT boxIndexOffset = 0;
-    UINT gridIndexOffset = (UINT)box.Indices32.size();
-    UINT sphereIndexOffset = gridIndexOffset + (UINT)grid.Indices32.size();
-    UINT cylinderIndexOffset = sphereIndexOffset + (UINT)sphere.Indices32.size();
-
-    // Define the SubmeshGeometry that cover different
-    // regions of the vertex/index buffers.
-
-    SubmeshGeometry boxSubmesh;
-    boxSubmesh.IndexCount = (UINT)box.Indices32.size();
-    boxSubmesh.StartIndexLocation = boxIndexOffset;
-    boxSubmesh.BaseVertexLocation = boxVertexOffset;
-
-    SubmeshGeometry gridSubmesh;
-    gridSubmesh.IndexCount = (UINT)grid.Indices32.size();
-    gridSubmesh.StartIndexLocation = gridIndexOffset;
-    gridSubmesh.BaseVertexLocation = gridVertexOffset;
-
-    SubmeshGeometry sphereSubmesh;
-    sphereSubmesh.IndexCount = (UINT)sphere.Indices32.size();
-    sphereSubmesh.StartIndexLocation = sphereIndexOffset;
-    sphereSubmesh.BaseVertexLocation = sphereVertexOffset;
-
-    SubmeshGeometry cylinderSubmesh;
-    cylinderSubmesh.IndexCount = (UINT)cylinder.Indices32.size();
-    cylinderSubmesh.StartIndexLocation = cylinderIndexOffset;
-    cylinderSubmesh.BaseVertexLocation = cylinderVertexOffset;
+    const std::vector<ShapeDesc> shapes = {
+        ShapeDesc::Box(1.5f, 0.5f, 1.5f, 3),
+        ShapeDesc::Grid(20.0f, 30.0f, 60, 40),
+        ShapeDesc::Sphere(0.5f, 20, 20),
+        ShapeDesc::Cylinder(0.5f, 0.3f, 3.0f, 20, 20)
+    };
+    const char* names[] = { "box", "grid", "sphere", "cylinder" };
+    const XMVECTORF32 colors[] = { DirectX::Colors::DarkGreen, DirectX::Colors::ForestGreen,
+        DirectX::Colors::Crimson, DirectX::Colors::SteelBlue };
+
+    GeometryGenerator geoGen;
+    std::vector<GeometryGenerator::SubmeshRange> ranges;
+    GeometryGenerator::MeshDataSoA shapeMesh = geoGen.CreateShapes(shapes, ranges);
 
     //
     // Extract the vertex elements we are interested in and pack the
     // vertices of all the meshes into one vertex buffer.
     //
 
-    auto totalVertexCount = box.Vertices.size() + grid.Vertices.size() + sphere.Vertices.size() + cylinder.Vertices.size();
-
-    std::vector<Vertex> vertices(totalVertexCount);
+    std::vector<Vertex> vertices(shapeMesh.VertexCount());
+    GeometryGenerator::Interleave(shapeMesh, VertexInterleaveLayout(), vertices.data());
 
-    UINT k = 0;
-    for (size_t i = 0; i < box.Vertices.size(); ++i, ++k) {
-        vertices[k].Pos = box.Vertices[i].Position;
-        vertices[k].Color = XMFLOAT4(DirectX::Colors::DarkGreen);
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        Vertex* first = vertices.data() + ranges[i].BaseVertexLocation;
+        for (UINT k = 0; k < ranges[i].VertexCount; ++k)
+            first[k].Color = XMFLOAT4(colors[i]);
     }
 
-    for (size_t i = 0; i < grid.Vertices.size(); ++i, ++k) {
-        vertices[k].Pos = grid.Vertices[i].Position;
-        vertices[k].Color = XMFLOAT4(DirectX::Colors::ForestGreen);
+    // Define the submeshes that cover different regions of the vertex/index
+    // buffers and let the packer pick the index format.
+    std::vector<IndexPacker::Submesh> submeshes(ranges.size());
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        submeshes[i].Name = names[i];
+        submeshes[i].IndexCount = ranges[i].IndexCount;
+        submeshes[i].StartIndexLocation = ranges[i].StartIndexLocation;
+        submeshes[i].BaseVertexLocation = ranges[i].BaseVertexLocation;
     }
 
-    for (size_t i = 0; i < sphere.Vertices.size(); ++i, ++k) {
-        vertices[k].Pos = sphere.Vertices[i].Position;
-        vertices[k].Color = XMFLOAT4(DirectX::Colors::Crimson);
-    }
-
-    for (size_t i = 0; i < cylinder.Vertices.size(); ++i, ++k) {
-        vertices[k].Pos = cylinder.Vertices[i].Position;
-        vertices[k].Color = XMFLOAT4(DirectX::Colors::SteelBlue);
-    }
-
-    std::vector<std::uint16_t> indices;
-    indices.insert(indices.end(), std::begin(box.GetIndices16()), std::end(box.GetIndices16()));
-    indices.insert(indices.end(), std::begin(grid.GetIndices16()), std::end(grid.GetIndices16()));
-    indices.insert(indices.end(), std::begin(sphere.GetIndices16()), std::end(sphere.GetIndices16()));
-    indices.insert(indices.end(), std::begin(cylinder.GetIndices16()), std::end(cylinder.GetIndices16()));
+    IndexPacker::PackedIndices indices = IndexPacker::Pack(shapeMesh.Indices32, submeshes);
 
     const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-    const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
 
     auto geo = std::make_unique<MeshGeometry>();
     geo->Name = "shapeGeo";
@@ -590,24 +555,13 @@ void ShapesApp::BuildShapeGeometry()
     ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
     CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
-    ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-    CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
     geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
         mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
 
-    geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-        mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
-
     geo->VertexByteStride = sizeof(Vertex);
     geo->VertexBufferByteSize = vbByteSize;
-    geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-    geo->IndexBufferByteSize = ibByteSize;
 
-    geo->DrawArgs["box"] = boxSubmesh;
-    geo->DrawArgs["grid"] = gridSubmesh;
-    geo->DrawArgs["sphere"] = sphereSubmesh;
-    geo->DrawArgs["cylinder"] = cylinderSubmesh;
+    geo->SetIndices(md3dDevice.Get(), mCommandList.Get(), indices);
 
     mGeometries[geo->Name] = std::move(geo);
 }
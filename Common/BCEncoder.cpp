@@ -0,0 +1,672 @@
+//***************************************************************************************
+// BCEncoder.cpp
+//***************************************************************************************
+
+#include "BCEncoder.h"
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint8 = BCEncoder::uint8;
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+	using Quality = BCEncoder::Quality;
+
+	struct Color
+	{
+		float R = 0.0f;
+		float G = 0.0f;
+		float B = 0.0f;
+	};
+
+	// The pixels of a block by channel, so four of them load into one vector.
+	// Weight is 0 for pixels the colours don't have to match (BC1 transparent).
+	struct ColorBlock
+	{
+		alignas(16) float R[16];
+		alignas(16) float G[16];
+		alignas(16) float B[16];
+		alignas(16) float Weight[16];
+		int Opaque = 0;
+	};
+
+	struct ColorFit
+	{
+		uint16 C0 = 0;
+		uint16 C1 = 0;
+		bool FourColor = true;
+		uint8 Indices[16] = {};
+		float Error = FLT_MAX;
+	};
+
+	struct ChannelFit
+	{
+		int A0 = 0;
+		int A1 = 0;
+		uint8 Indices[16] = {};
+		float Error = FLT_MAX;
+	};
+
+	XMVECTOR XM_CALLCONV Load4(const float* lanes)
+	{
+		return XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(lanes));
+	}
+
+	float XM_CALLCONV Sum4(FXMVECTOR v)
+	{
+		XMFLOAT4A lanes;
+		XMStoreFloat4A(&lanes, v);
+		return lanes.x + lanes.y + lanes.z + lanes.w;
+	}
+
+	void XM_CALLCONV StoreIndices(FXMVECTOR v, uint8* indices)
+	{
+		XMFLOAT4A lanes;
+		XMStoreFloat4A(&lanes, v);
+		indices[0] = (uint8)lanes.x;
+		indices[1] = (uint8)lanes.y;
+		indices[2] = (uint8)lanes.z;
+		indices[3] = (uint8)lanes.w;
+	}
+
+	ColorBlock LoadColorBlock(const uint8 rgba[64], uint8 alphaThreshold)
+	{
+		ColorBlock block;
+		for (int i = 0; i < 16; ++i)
+		{
+			block.R[i] = rgba[4*i + 0];
+			block.G[i] = rgba[4*i + 1];
+			block.B[i] = rgba[4*i + 2];
+			block.Weight[i] = rgba[4*i + 3] < alphaThreshold ? 0.0f : 1.0f;
+			block.Opaque += (int)block.Weight[i];
+		}
+
+		return block;
+	}
+
+	//-----------------------------------------------------------------------------------
+	// Colour palettes
+	//-----------------------------------------------------------------------------------
+
+	void Expand565(uint16 c, int rgb[3])
+	{
+		int r = (c >> 11) & 31;
+		int g = (c >> 5) & 63;
+		int b = c & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	uint16 Quantize565(const Color& c)
+	{
+		int r = (int)std::lround(std::min(std::max(c.R, 0.0f), 255.0f) * (31.0f / 255.0f));
+		int g = (int)std::lround(std::min(std::max(c.G, 0.0f), 255.0f) * (63.0f / 255.0f));
+		int b = (int)std::lround(std::min(std::max(c.B, 0.0f), 255.0f) * (31.0f / 255.0f));
+		return (uint16)((r << 11) | (g << 5) | b);
+	}
+
+	// palette[k] is RGBA.  The three-colour mode's last entry is transparent black.
+	void ColorPalette(uint16 c0, uint16 c1, bool fourColor, int palette[4][4])
+	{
+		Expand565(c0, palette[0]);
+		Expand565(c1, palette[1]);
+
+		for (int ch = 0; ch < 3; ++ch)
+		{
+			int a = palette[0][ch];
+			int b = palette[1][ch];
+			if (fourColor)
+			{
+				palette[2][ch] = (2*a + b + 1) / 3;
+				palette[3][ch] = (a + 2*b + 1) / 3;
+			}
+			else
+			{
+				palette[2][ch] = (a + b + 1) / 2;
+				palette[3][ch] = 0;
+			}
+		}
+
+		palette[0][3] = palette[1][3] = palette[2][3] = 255;
+		palette[3][3] = fourColor ? 255 : 0;
+	}
+
+	//-----------------------------------------------------------------------------------
+	// Colour endpoints
+	//-----------------------------------------------------------------------------------
+
+	// Matches every pixel to the nearest of the first count palette entries and
+	// returns the weighted squared error.
+	float FitColorIndices(const ColorBlock& block, const int palette[4][4], int count, uint8 indices[16])
+	{
+		XMVECTOR pr[4], pg[4], pb[4], entry[4];
+		for (int k = 0; k < count; ++k)
+		{
+			pr[k] = XMVectorReplicate((float)palette[k][0]);
+			pg[k] = XMVectorReplicate((float)palette[k][1]);
+			pb[k] = XMVectorReplicate((float)palette[k][2]);
+			entry[k] = XMVectorReplicate((float)k);
+		}
+
+		XMVECTOR error = XMVectorZero();
+		for (int i = 0; i < 16; i += 4)
+		{
+			XMVECTOR r = Load4(&block.R[i]);
+			XMVECTOR g = Load4(&block.G[i]);
+			XMVECTOR b = Load4(&block.B[i]);
+
+			XMVECTOR best = XMVectorReplicate(FLT_MAX);
+			XMVECTOR bestIndex = XMVectorZero();
+			for (int k = 0; k < count; ++k)
+			{
+				XMVECTOR dr = XMVectorSubtract(r, pr[k]);
+				XMVECTOR dg = XMVectorSubtract(g, pg[k]);
+				XMVECTOR db = XMVectorSubtract(b, pb[k]);
+				XMVECTOR d = XMVectorMultiplyAdd(dr, dr, XMVectorMultiplyAdd(dg, dg, XMVectorMultiply(db, db)));
+
+				XMVECTOR closer = XMVectorLess(d, best);
+				best = XMVectorSelect(best, d, closer);
+				bestIndex = XMVectorSelect(bestIndex, entry[k], closer);
+			}
+
+			error = XMVectorMultiplyAdd(best, Load4(&block.Weight[i]), error);
+			StoreIndices(bestIndex, &indices[i]);
+		}
+
+		return Sum4(error);
+	}
+
+	void Evaluate(const ColorBlock& block, uint16 c0, uint16 c1, bool fourColor, ColorFit& fit)
+	{
+		int palette[4][4];
+		ColorPalette(c0, c1, fourColor, palette);
+
+		fit.C0 = c0;
+		fit.C1 = c1;
+		fit.FourColor = fourColor;
+		fit.Error = FitColorIndices(block, palette, fourColor ? 4 : 3, fit.Indices);
+	}
+
+	// Endpoints with the least squared error for the given indices, unquantized.
+	// False when the indices don't determine them (every pixel on one entry).
+	bool SolveEndpoints(const ColorBlock& block, const uint8 indices[16], bool fourColor, Color& e0, Color& e1)
+	{
+		// Share of endpoint 0 in each palette entry.
+		static const float FourColorWeights[4] = { 1.0f, 0.0f, 2.0f/3.0f, 1.0f/3.0f };
+		static const float ThreeColorWeights[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+		const float* weights = fourColor ? FourColorWeights : ThreeColorWeights;
+
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		Color ax, bx;
+		for (int i = 0; i < 16; ++i)
+		{
+			if (block.Weight[i] == 0.0f || (!fourColor && indices[i] == 3))
+				continue;
+
+			float a = weights[indices[i]];
+			float b = 1.0f - a;
+			aa += a*a;
+			ab += a*b;
+			bb += b*b;
+			ax.R += a*block.R[i]; ax.G += a*block.G[i]; ax.B += a*block.B[i];
+			bx.R += b*block.R[i]; bx.G += b*block.G[i]; bx.B += b*block.B[i];
+		}
+
+		float det = aa*bb - ab*ab;
+		if (std::fabs(det) < 1e-4f)
+			return false;
+
+		float invDet = 1.0f / det;
+		e0.R = (ax.R*bb - bx.R*ab) * invDet;
+		e0.G = (ax.G*bb - bx.G*ab) * invDet;
+		e0.B = (ax.B*bb - bx.B*ab) * invDet;
+		e1.R = (bx.R*aa - ax.R*ab) * invDet;
+		e1.G = (bx.G*aa - ax.G*ab) * invDet;
+		e1.B = (bx.B*aa - ax.B*ab) * invDet;
+		return true;
+	}
+
+	void Refine(const ColorBlock& block, int iterations, ColorFit& best)
+	{
+		for (int i = 0; i < iterations; ++i)
+		{
+			Color e0, e1;
+			if (!SolveEndpoints(block, best.Indices, best.FourColor, e0, e1))
+				break;
+
+			ColorFit fit;
+			Evaluate(block, Quantize565(e0), Quantize565(e1), best.FourColor, fit);
+			if (fit.Error >= best.Error)
+				break;
+
+			best = fit;
+		}
+	}
+
+	// Steps each channel of both quantized endpoints by one while that lowers
+	// the error; least squares ignores the rounding to 565.
+	void SearchEndpoints(const ColorBlock& block, ColorFit& best)
+	{
+		static const int Shifts[3] = { 11, 5, 0 };
+		static const int Masks[3] = { 31, 63, 31 };
+
+		bool improved = true;
+		for (int pass = 0; pass < 4 && improved; ++pass)
+		{
+			improved = false;
+			for (int e = 0; e < 2; ++e)
+			{
+				for (int ch = 0; ch < 3; ++ch)
+				{
+					for (int step = -1; step <= 1; step += 2)
+					{
+						uint16 c = e == 0 ? best.C0 : best.C1;
+						int v = ((c >> Shifts[ch]) & Masks[ch]) + step;
+						if (v < 0 || v > Masks[ch])
+							continue;
+
+						c = (uint16)((c & ~(Masks[ch] << Shifts[ch])) | (v << Shifts[ch]));
+
+						ColorFit fit;
+						Evaluate(block, e == 0 ? c : best.C0, e == 0 ? best.C1 : c, best.FourColor, fit);
+						if (fit.Error < best.Error)
+						{
+							best = fit;
+							improved = true;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Starting endpoints over the pixels with weight.
+	void InitialEndpoints(const ColorBlock& block, Quality quality, Color& e0, Color& e1)
+	{
+		Color mean;
+		Color lo = { 255.0f, 255.0f, 255.0f };
+		Color hi = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; ++i)
+		{
+			if (block.Weight[i] == 0.0f)
+				continue;
+
+			mean.R += block.R[i]; mean.G += block.G[i]; mean.B += block.B[i];
+			lo.R = std::min(lo.R, block.R[i]); hi.R = std::max(hi.R, block.R[i]);
+			lo.G = std::min(lo.G, block.G[i]); hi.G = std::max(hi.G, block.G[i]);
+			lo.B = std::min(lo.B, block.B[i]); hi.B = std::max(hi.B, block.B[i]);
+		}
+
+		float n = (float)block.Opaque;
+		mean.R /= n; mean.G /= n; mean.B /= n;
+
+		// Covariance: rr, gg, bb, rg, rb, gb.
+		float cov[6] = {};
+		for (int i = 0; i < 16; ++i)
+		{
+			if (block.Weight[i] == 0.0f)
+				continue;
+
+			float r = block.R[i] - mean.R;
+			float g = block.G[i] - mean.G;
+			float b = block.B[i] - mean.B;
+			cov[0] += r*r; cov[1] += g*g; cov[2] += b*b;
+			cov[3] += r*g; cov[4] += r*b; cov[5] += g*b;
+		}
+
+		if (quality == Quality::Fast)
+		{
+			// The bounding box diagonal that follows the colours: channels that fall
+			// as the widest one rises run the other way.
+			e0 = hi;
+			e1 = lo;
+
+			int widest = 0;
+			if (cov[1] > cov[widest]) widest = 1;
+			if (cov[2] > cov[widest]) widest = 2;
+
+			float withWidest[3];
+			withWidest[0] = widest == 0 ? 1.0f : (widest == 1 ? cov[3] : cov[4]);
+			withWidest[1] = widest == 1 ? 1.0f : (widest == 0 ? cov[3] : cov[5]);
+			withWidest[2] = widest == 2 ? 1.0f : (widest == 0 ? cov[4] : cov[5]);
+			if (withWidest[0] < 0.0f) std::swap(e0.R, e1.R);
+			if (withWidest[1] < 0.0f) std::swap(e0.G, e1.G);
+			if (withWidest[2] < 0.0f) std::swap(e0.B, e1.B);
+
+			// Inset, as the extremes are rarely hit exactly.
+			Color inset = { (e0.R - e1.R) / 16.0f, (e0.G - e1.G) / 16.0f, (e0.B - e1.B) / 16.0f };
+			e0.R -= inset.R; e0.G -= inset.G; e0.B -= inset.B;
+			e1.R += inset.R; e1.G += inset.G; e1.B += inset.B;
+			return;
+		}
+
+		// Principal axis by power iteration, starting along the box diagonal.
+		float axis[3] = { hi.R - lo.R, hi.G - lo.G, hi.B - lo.B };
+		if (axis[0] + axis[1] + axis[2] == 0.0f)
+		{
+			e0 = e1 = mean;
+			return;
+		}
+
+		for (int i = 0; i < 8; ++i)
+		{
+			float x = cov[0]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2];
+			float y = cov[3]*axis[0] + cov[1]*axis[1] + cov[5]*axis[2];
+			float z = cov[4]*axis[0] + cov[5]*axis[1] + cov[2]*axis[2];
+
+			float largest = std::max(std::fabs(x), std::max(std::fabs(y), std::fabs(z)));
+			if (largest < 1e-6f)
+				break;
+
+			axis[0] = x / largest;
+			axis[1] = y / largest;
+			axis[2] = z / largest;
+		}
+
+		float length = std::sqrt(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+		axis[0] /= length; axis[1] /= length; axis[2] /= length;
+
+		float tMin = FLT_MAX, tMax = -FLT_MAX;
+		for (int i = 0; i < 16; ++i)
+		{
+			if (block.Weight[i] == 0.0f)
+				continue;
+
+			float t = (block.R[i] - mean.R)*axis[0] + (block.G[i] - mean.G)*axis[1] + (block.B[i] - mean.B)*axis[2];
+			tMin = std::min(tMin, t);
+			tMax = std::max(tMax, t);
+		}
+
+		e0 = { mean.R + axis[0]*tMax, mean.G + axis[1]*tMax, mean.B + axis[2]*tMax };
+		e1 = { mean.R + axis[0]*tMin, mean.G + axis[1]*tMin, mean.B + axis[2]*tMin };
+	}
+
+	ColorFit EncodeColors(const ColorBlock& block, Quality quality, bool allowThreeColor)
+	{
+		ColorFit best;
+		if (block.Opaque == 0)
+		{
+			best.FourColor = false;
+			best.Error = 0.0f;
+			return best;
+		}
+
+		Color e0, e1;
+		InitialEndpoints(block, quality, e0, e1);
+		uint16 c0 = Quantize565(e0);
+		uint16 c1 = Quantize565(e1);
+
+		int iterations = quality == Quality::Fast ? 0 : (quality == Quality::Normal ? 1 : 4);
+
+		// Transparent pixels need the three-colour mode; opaque blocks try it
+		// only at High.
+		bool modes[2] = { true, false };
+		int firstMode = block.Opaque < 16 ? 1 : 0;
+		int lastMode = (block.Opaque < 16 || (quality == Quality::High && allowThreeColor)) ? 1 : 0;
+
+		for (int mode = firstMode; mode <= lastMode; ++mode)
+		{
+			ColorFit fit;
+			Evaluate(block, c0, c1, modes[mode], fit);
+			Refine(block, iterations, fit);
+			if (quality == Quality::High)
+				SearchEndpoints(block, fit);
+
+			if (fit.Error < best.Error)
+				best = fit;
+		}
+
+		return best;
+	}
+
+	// Orders the endpoints for the fit's mode, as BC1 decoders pick the mode
+	// from their order.
+	void PackColors(ColorFit fit, const ColorBlock& block, uint8 out[8])
+	{
+		if (fit.FourColor)
+		{
+			if (fit.C0 < fit.C1)
+			{
+				std::swap(fit.C0, fit.C1);
+				for (uint8& index : fit.Indices)
+					index ^= 1;
+			}
+			else if (fit.C0 == fit.C1)
+			{
+				// Would decode as three colours; every entry is the same colour anyway.
+				for (uint8& index : fit.Indices)
+					index = 0;
+			}
+		}
+		else
+		{
+			if (fit.C0 > fit.C1)
+			{
+				std::swap(fit.C0, fit.C1);
+				for (uint8& index : fit.Indices)
+					index = index < 2 ? index ^ 1 : index;
+			}
+
+			for (int i = 0; i < 16; ++i)
+			{
+				if (block.Weight[i] == 0.0f)
+					fit.Indices[i] = 3;
+			}
+		}
+
+		uint32 bits = 0;
+		for (int i = 0; i < 16; ++i)
+			bits |= (uint32)fit.Indices[i] << (2*i);
+
+		out[0] = (uint8)fit.C0;
+		out[1] = (uint8)(fit.C0 >> 8);
+		out[2] = (uint8)fit.C1;
+		out[3] = (uint8)(fit.C1 >> 8);
+		for (int i = 0; i < 4; ++i)
+			out[4 + i] = (uint8)(bits >> (8*i));
+	}
+
+	void DecodeColors(const uint8 block[8], bool bc1, uint8 rgba[64])
+	{
+		uint16 c0 = (uint16)(block[0] | (block[1] << 8));
+		uint16 c1 = (uint16)(block[2] | (block[3] << 8));
+		uint32 bits = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32)block[7] << 24);
+
+		int palette[4][4];
+		ColorPalette(c0, c1, !bc1 || c0 > c1, palette);
+
+		for (int i = 0; i < 16; ++i)
+		{
+			const int* color = palette[(bits >> (2*i)) & 3];
+			for (int ch = 0; ch < 4; ++ch)
+				rgba[4*i + ch] = (uint8)color[ch];
+		}
+	}
+
+	//-----------------------------------------------------------------------------------
+	// Single channel blocks
+	//-----------------------------------------------------------------------------------
+
+	void ChannelPalette(int a0, int a1, int palette[8])
+	{
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1)
+		{
+			for (int k = 1; k <= 6; ++k)
+				palette[k + 1] = ((7 - k)*a0 + k*a1 + 3) / 7;
+		}
+		else
+		{
+			for (int k = 1; k <= 4; ++k)
+				palette[k + 1] = ((5 - k)*a0 + k*a1 + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	void EvaluateChannel(const float values[16], int a0, int a1, ChannelFit& fit)
+	{
+		int palette[8];
+		ChannelPalette(a0, a1, palette);
+
+		XMVECTOR entry[8], index[8];
+		for (int k = 0; k < 8; ++k)
+		{
+			entry[k] = XMVectorReplicate((float)palette[k]);
+			index[k] = XMVectorReplicate((float)k);
+		}
+
+		XMVECTOR error = XMVectorZero();
+		for (int i = 0; i < 16; i += 4)
+		{
+			XMVECTOR v = Load4(&values[i]);
+
+			XMVECTOR best = XMVectorReplicate(FLT_MAX);
+			XMVECTOR bestIndex = XMVectorZero();
+			for (int k = 0; k < 8; ++k)
+			{
+				XMVECTOR d = XMVectorSubtract(v, entry[k]);
+				d = XMVectorMultiply(d, d);
+
+				XMVECTOR closer = XMVectorLess(d, best);
+				best = XMVectorSelect(best, d, closer);
+				bestIndex = XMVectorSelect(bestIndex, index[k], closer);
+			}
+
+			error = XMVectorAdd(error, best);
+			StoreIndices(bestIndex, &fit.Indices[i]);
+		}
+
+		fit.A0 = a0;
+		fit.A1 = a1;
+		fit.Error = Sum4(error);
+	}
+
+	void EncodeChannel(const uint8* pixels, int stride, Quality quality, uint8 out[8])
+	{
+		alignas(16) float values[16];
+		int lo = 255, hi = 0;
+		int innerLo = 255, innerHi = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			int v = pixels[i*stride];
+			values[i] = (float)v;
+			lo = std::min(lo, v);
+			hi = std::max(hi, v);
+			if (v != 0 && v != 255)
+			{
+				innerLo = std::min(innerLo, v);
+				innerHi = std::max(innerHi, v);
+			}
+		}
+
+		// Eight values between the extremes.
+		ChannelFit best;
+		EvaluateChannel(values, hi, lo, best);
+
+		// Six values between the rest, plus exact 0 and 255.
+		if (quality != Quality::Fast && (lo == 0 || hi == 255))
+		{
+			if (innerLo > innerHi)
+				innerLo = innerHi = 0;
+
+			ChannelFit fit;
+			EvaluateChannel(values, innerLo, innerHi, fit);
+			if (fit.Error < best.Error)
+				best = fit;
+		}
+
+		if (quality == Quality::High && best.Error > 0.0f)
+		{
+			bool eightValues = best.A0 > best.A1;
+			ChannelFit center = best;
+			for (int d0 = -2; d0 <= 2; ++d0)
+			{
+				for (int d1 = -2; d1 <= 2; ++d1)
+				{
+					int a0 = center.A0 + d0;
+					int a1 = center.A1 + d1;
+					if (a0 < 0 || a0 > 255 || a1 < 0 || a1 > 255 || (a0 > a1) != eightValues)
+						continue;
+
+					ChannelFit fit;
+					EvaluateChannel(values, a0, a1, fit);
+					if (fit.Error < best.Error)
+						best = fit;
+				}
+			}
+		}
+
+		uint64 bits = 0;
+		for (int i = 0; i < 16; ++i)
+			bits |= (uint64)best.Indices[i] << (3*i);
+
+		out[0] = (uint8)best.A0;
+		out[1] = (uint8)best.A1;
+		for (int i = 0; i < 6; ++i)
+			out[2 + i] = (uint8)(bits >> (8*i));
+	}
+
+	void DecodeChannel(const uint8 block[8], uint8* pixels, int stride)
+	{
+		int palette[8];
+		ChannelPalette(block[0], block[1], palette);
+
+		uint64 bits = 0;
+		for (int i = 0; i < 6; ++i)
+			bits |= (uint64)block[2 + i] << (8*i);
+
+		for (int i = 0; i < 16; ++i)
+			pixels[i*stride] = (uint8)palette[(bits >> (3*i)) & 7];
+	}
+}
+
+void BCEncoder::EncodeBC1(const uint8 rgba[64], Quality quality, uint8 alphaThreshold, uint8 block[8])
+{
+	ColorBlock colors = LoadColorBlock(rgba, alphaThreshold);
+	PackColors(EncodeColors(colors, quality, true), colors, block);
+}
+
+void BCEncoder::EncodeBC3(const uint8 rgba[64], Quality quality, uint8 block[16])
+{
+	EncodeChannel(rgba + 3, 4, quality, block);
+
+	ColorBlock colors = LoadColorBlock(rgba, 0);
+	PackColors(EncodeColors(colors, quality, false), colors, block + 8);
+}
+
+void BCEncoder::EncodeBC5(const uint8 rgba[64], Quality quality, uint8 block[16])
+{
+	EncodeChannel(rgba + 0, 4, quality, block);
+	EncodeChannel(rgba + 1, 4, quality, block + 8);
+}
+
+void BCEncoder::DecodeBC1(const uint8 block[8], uint8 rgba[64])
+{
+	DecodeColors(block, true, rgba);
+}
+
+void BCEncoder::DecodeBC3(const uint8 block[16], uint8 rgba[64])
+{
+	DecodeColors(block + 8, false, rgba);
+	DecodeChannel(block, rgba + 3, 4);
+}
+
+void BCEncoder::DecodeBC5(const uint8 block[16], uint8 rgba[64])
+{
+	DecodeChannel(block, rgba + 0, 4);
+	DecodeChannel(block + 8, rgba + 1, 4);
+	for (int i = 0; i < 16; ++i)
+	{
+		rgba[4*i + 2] = 0;
+		rgba[4*i + 3] = 255;
+	}
+}
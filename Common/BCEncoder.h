@@ -0,0 +1,59 @@
+//***************************************************************************************
+// BCEncoder.h
+//
+// Encodes and decodes single 4x4 blocks of the BC1, BC3 and BC5 formats on the
+// CPU.  A block is given as 16 RGBA8 pixels, row by row.
+//
+// Colour endpoints lie on the principal axis of the block's colours (Normal,
+// High) or on the diagonal of their bounding box (Fast).  They are then refined
+// by least squares against the chosen indices; High also tries BC1's
+// three-colour mode and nudges the quantized endpoints while the error drops.
+// Single-channel blocks (the alpha of BC3, both channels of BC5) start from the
+// block's range; Normal and above also try the six-value mode, which hits 0 and
+// 255 exactly, and High searches the endpoints around the best pair.
+//
+// Matching pixels to palette entries is the inner loop of every tier; it runs
+// four pixels at a time on DirectXMath vectors.
+//
+// BC3's colour block is written in four-colour order, so it also decodes on
+// hardware that reads it like BC1.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+
+class BCEncoder
+{
+public:
+
+	using uint8 = std::uint8_t;
+
+	enum class Quality
+	{
+		Fast,           // bounding box endpoints, one pass
+		Normal,         // principal axis, one least squares refinement
+		High            // as Normal, iterated, every mode, endpoint search
+	};
+
+	static const int BC1BlockBytes = 8;
+	static const int BC3BlockBytes = 16;
+	static const int BC5BlockBytes = 16;
+
+	///<summary>
+	/// Pixels with alpha below alphaThreshold become transparent black, using
+	/// the three-colour mode; 0 encodes every pixel as opaque.
+	///</summary>
+	static void EncodeBC1(const uint8 rgba[64], Quality quality, uint8 alphaThreshold, uint8 block[8]);
+
+	static void EncodeBC3(const uint8 rgba[64], Quality quality, uint8 block[16]);
+
+	// Stores the red and green channels; blue and alpha are ignored.
+	static void EncodeBC5(const uint8 rgba[64], Quality quality, uint8 block[16]);
+
+	static void DecodeBC1(const uint8 block[8], uint8 rgba[64]);
+	static void DecodeBC3(const uint8 block[16], uint8 rgba[64]);
+
+	// Blue decodes as 0 and alpha as 255.
+	static void DecodeBC5(const uint8 block[16], uint8 rgba[64]);
+};
@@ -0,0 +1,460 @@
+//***************************************************************************************
+// BoundsBuilder.cpp
+//***************************************************************************************
+
+#include "BoundsBuilder.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+using uint16 = BoundsBuilder::uint16;
+using uint32 = BoundsBuilder::uint32;
+
+namespace
+{
+	// Strided position reads.
+	struct PositionStream
+	{
+		const char* Data;
+		size_t Stride;
+
+		const XMFLOAT3& operator[](size_t i)const { return *reinterpret_cast<const XMFLOAT3*>(Data + i*Stride); }
+	};
+
+	PositionStream MakeStream(const XMFLOAT3* positions, size_t positionStride)
+	{
+		PositionStream stream;
+		stream.Data = reinterpret_cast<const char*>(positions);
+		stream.Stride = positionStride;
+		return stream;
+	}
+
+	// Smallest sphere enclosing both the sphere and p (which lies outside).
+	// It contains the old sphere, so points already inside stay inside.
+	inline void XM_CALLCONV Grow(XMVECTOR& center, float& radius, FXMVECTOR p)
+	{
+		XMVECTOR d = p - center;
+		float distanceSq = XMVectorGetX(XMVector3LengthSq(d));
+		if(distanceSq <= radius*radius)
+			return;
+
+		float distance = std::sqrt(distanceSq);
+		float newRadius = 0.5f*(radius + distance);
+		center += d*((newRadius - radius) / distance);
+		radius = newRadius;
+	}
+
+	// Eigen decomposition of the symmetric matrix a by cyclic Jacobi rotations.
+	// a is left (nearly) diagonal; the columns of v are the eigenvectors.
+	void JacobiEigen(double a[3][3], double v[3][3])
+	{
+		for(int i = 0; i < 3; ++i)
+			for(int j = 0; j < 3; ++j)
+				v[i][j] = i == j ? 1.0 : 0.0;
+
+		for(int sweep = 0; sweep < 32; ++sweep)
+		{
+			double off = a[0][1]*a[0][1] + a[0][2]*a[0][2] + a[1][2]*a[1][2];
+			double diagonal = a[0][0]*a[0][0] + a[1][1]*a[1][1] + a[2][2]*a[2][2];
+			if(off <= 1e-24*diagonal)
+				break;
+
+			for(int p = 0; p < 2; ++p)
+			{
+				for(int q = p + 1; q < 3; ++q)
+				{
+					if(a[p][q] == 0.0)
+						continue;
+
+					double theta = (a[q][q] - a[p][p]) / (2.0*a[p][q]);
+					double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta*theta + 1.0));
+					double c = 1.0 / std::sqrt(t*t + 1.0);
+					double s = t*c;
+
+					for(int k = 0; k < 3; ++k)
+					{
+						double akp = a[k][p];
+						double akq = a[k][q];
+						a[k][p] = c*akp - s*akq;
+						a[k][q] = s*akp + c*akq;
+					}
+
+					for(int k = 0; k < 3; ++k)
+					{
+						double apk = a[p][k];
+						double aqk = a[q][k];
+						a[p][k] = c*apk - s*aqk;
+						a[q][k] = s*apk + c*aqk;
+					}
+
+					for(int k = 0; k < 3; ++k)
+					{
+						double vkp = v[k][p];
+						double vkq = v[k][q];
+						v[k][p] = c*vkp - s*vkq;
+						v[k][q] = s*vkp + c*vkq;
+					}
+				}
+			}
+		}
+	}
+
+	// Covariance of the surface of the triangles, each weighted by its area
+	// (Gottschalk et al., OBBTree).  Returns false if the triangles have no area.
+	bool SurfaceCovariance(const PositionStream& positions, const uint32* indices, size_t indexCount, double covariance[3][3])
+	{
+		double totalArea = 0.0;
+		double mean[3] = { 0.0, 0.0, 0.0 };
+		double moments[3][3] = {};
+
+		for(size_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			const XMFLOAT3* corners[3] = { &positions[indices[i]], &positions[indices[i + 1]], &positions[indices[i + 2]] };
+
+			XMVECTOR p0 = XMLoadFloat3(corners[0]);
+			XMVECTOR p1 = XMLoadFloat3(corners[1]);
+			XMVECTOR p2 = XMLoadFloat3(corners[2]);
+			double area = 0.5*XMVectorGetX(XMVector3Length(XMVector3Cross(p1 - p0, p2 - p0)));
+			if(area <= 0.0)
+				continue;
+
+			double p[3][3];
+			double m[3];
+			for(int k = 0; k < 3; ++k)
+			{
+				p[k][0] = corners[k]->x;
+				p[k][1] = corners[k]->y;
+				p[k][2] = corners[k]->z;
+			}
+			for(int j = 0; j < 3; ++j)
+				m[j] = (p[0][j] + p[1][j] + p[2][j]) / 3.0;
+
+			totalArea += area;
+			for(int j = 0; j < 3; ++j)
+			{
+				mean[j] += area*m[j];
+				for(int k = j; k < 3; ++k)
+					moments[j][k] += area/12.0*(9.0*m[j]*m[k] + p[0][j]*p[0][k] + p[1][j]*p[1][k] + p[2][j]*p[2][k]);
+			}
+		}
+
+		if(totalArea <= 0.0)
+			return false;
+
+		for(int j = 0; j < 3; ++j)
+			mean[j] /= totalArea;
+
+		for(int j = 0; j < 3; ++j)
+		{
+			for(int k = j; k < 3; ++k)
+				covariance[j][k] = covariance[k][j] = moments[j][k]/totalArea - mean[j]*mean[k];
+		}
+
+		return true;
+	}
+
+	void PointCovariance(const PositionStream& positions, size_t count, double covariance[3][3])
+	{
+		double mean[3] = { 0.0, 0.0, 0.0 };
+		for(size_t i = 0; i < count; ++i)
+		{
+			mean[0] += positions[i].x;
+			mean[1] += positions[i].y;
+			mean[2] += positions[i].z;
+		}
+		for(int j = 0; j < 3; ++j)
+			mean[j] /= (double)count;
+
+		double sums[3][3] = {};
+		for(size_t i = 0; i < count; ++i)
+		{
+			double d[3] = { positions[i].x - mean[0], positions[i].y - mean[1], positions[i].z - mean[2] };
+			for(int j = 0; j < 3; ++j)
+				for(int k = j; k < 3; ++k)
+					sums[j][k] += d[j]*d[k];
+		}
+
+		for(int j = 0; j < 3; ++j)
+			for(int k = j; k < 3; ++k)
+				covariance[j][k] = covariance[k][j] = sums[j][k] / (double)count;
+	}
+
+	BoundingOrientedBox ToOrientedBox(const BoundingBox& box)
+	{
+		BoundingOrientedBox obb;
+		obb.Center = box.Center;
+		obb.Extents = box.Extents;
+		obb.Orientation = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		return obb;
+	}
+
+	template<typename Index>
+	BoundsBuilder::Volumes ComputeVolumes(const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+		const Index* indices, size_t indexCount, int baseVertex, const BoundsBuilder::Options& options)
+	{
+		PositionStream source = MakeStream(positions, positionStride);
+
+		// Copy the referenced vertices out, once each, and renumber the
+		// triangles to match.
+		std::vector<uint32> localIndex(vertexCount, ~0u);
+		std::vector<XMFLOAT3> points;
+		std::vector<uint32> triangles(indexCount);
+
+		for(size_t i = 0; i < indexCount; ++i)
+		{
+			size_t vertex = (size_t)((long long)indices[i] + baseVertex);
+			if(vertex >= vertexCount)
+			{
+				triangles[i] = ~0u;
+				continue;
+			}
+
+			if(localIndex[vertex] == ~0u)
+			{
+				localIndex[vertex] = (uint32)points.size();
+				points.push_back(source[vertex]);
+			}
+			triangles[i] = localIndex[vertex];
+		}
+
+		// Triangles with an out-of-range corner are dropped from the area weighting.
+		size_t kept = 0;
+		for(size_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			if(triangles[i] == ~0u || triangles[i + 1] == ~0u || triangles[i + 2] == ~0u)
+				continue;
+
+			triangles[kept++] = triangles[i];
+			triangles[kept++] = triangles[i + 1];
+			triangles[kept++] = triangles[i + 2];
+		}
+		triangles.resize(kept);
+
+		BoundsBuilder::Volumes volumes;
+		volumes.Box = BoundsBuilder::ComputeBox(points.data(), sizeof(XMFLOAT3), points.size());
+		volumes.Sphere = BoundsBuilder::ComputeSphere(points.data(), sizeof(XMFLOAT3), points.size(), options.SphereIterations);
+		volumes.OrientedBox = options.OrientedBox ?
+			BoundsBuilder::ComputeOrientedBox(points.data(), sizeof(XMFLOAT3), points.size(), triangles.data(), triangles.size()) :
+			ToOrientedBox(volumes.Box);
+
+		return volumes;
+	}
+}
+
+BoundingBox BoundsBuilder::ComputeBox(const XMFLOAT3* positions, size_t positionStride, size_t count)
+{
+	if(count == 0)
+		return BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+	PositionStream stream = MakeStream(positions, positionStride);
+
+	// Four independent min/max chains so consecutive vertices do not wait on
+	// each other.
+	XMVECTOR lo[4];
+	XMVECTOR hi[4];
+	for(int k = 0; k < 4; ++k)
+		lo[k] = hi[k] = XMLoadFloat3(&stream[0]);
+
+	size_t i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		for(int k = 0; k < 4; ++k)
+		{
+			XMVECTOR p = XMLoadFloat3(&stream[i + k]);
+			lo[k] = XMVectorMin(lo[k], p);
+			hi[k] = XMVectorMax(hi[k], p);
+		}
+	}
+
+	for(; i < count; ++i)
+	{
+		XMVECTOR p = XMLoadFloat3(&stream[i]);
+		lo[0] = XMVectorMin(lo[0], p);
+		hi[0] = XMVectorMax(hi[0], p);
+	}
+
+	XMVECTOR vMin = XMVectorMin(XMVectorMin(lo[0], lo[1]), XMVectorMin(lo[2], lo[3]));
+	XMVECTOR vMax = XMVectorMax(XMVectorMax(hi[0], hi[1]), XMVectorMax(hi[2], hi[3]));
+
+	BoundingBox box;
+	XMStoreFloat3(&box.Center, 0.5f*(vMin + vMax));
+	XMStoreFloat3(&box.Extents, 0.5f*(vMax - vMin));
+	return box;
+}
+
+BoundingSphere BoundsBuilder::ComputeSphere(const XMFLOAT3* positions, size_t positionStride, size_t count,
+	uint32 iterations)
+{
+	if(count == 0)
+		return BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f);
+
+	PositionStream stream = MakeStream(positions, positionStride);
+
+	//
+	// Ritter: start from the most distant pair of axis extremes, then grow over
+	// every vertex.
+	//
+
+	size_t minIndex[3] = { 0, 0, 0 };
+	size_t maxIndex[3] = { 0, 0, 0 };
+	for(size_t i = 1; i < count; ++i)
+	{
+		const float* p = &stream[i].x;
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			if(p[axis] < (&stream[minIndex[axis]].x)[axis]) minIndex[axis] = i;
+			if(p[axis] > (&stream[maxIndex[axis]].x)[axis]) maxIndex[axis] = i;
+		}
+	}
+
+	XMVECTOR a = XMVectorZero();
+	XMVECTOR b = XMVectorZero();
+	float widest = -1.0f;
+	for(int axis = 0; axis < 3; ++axis)
+	{
+		XMVECTOR lo = XMLoadFloat3(&stream[minIndex[axis]]);
+		XMVECTOR hi = XMLoadFloat3(&stream[maxIndex[axis]]);
+		float distanceSq = XMVectorGetX(XMVector3LengthSq(hi - lo));
+		if(distanceSq > widest)
+		{
+			widest = distanceSq;
+			a = lo;
+			b = hi;
+		}
+	}
+
+	XMVECTOR center = 0.5f*(a + b);
+	float radius = 0.5f*std::sqrt(widest);
+	for(size_t i = 0; i < count; ++i)
+		Grow(center, radius, XMLoadFloat3(&stream[i]));
+
+	//
+	// Refinement: shrink the sphere a little and grow it back over the vertices
+	// in a new order.  Ritter's result depends on the order, so this often ends
+	// smaller; the smallest sphere seen is kept.
+	//
+
+	XMVECTOR bestCenter = center;
+	float bestRadius = radius;
+
+	std::vector<uint32> order;
+	if(iterations > 0)
+	{
+		order.resize(count);
+		for(size_t i = 0; i < count; ++i)
+			order[i] = (uint32)i;
+	}
+
+	uint32 seed = 0x9e3779b9u;
+	for(uint32 iteration = 0; iteration < iterations; ++iteration)
+	{
+		for(size_t i = count - 1; i > 0; --i)
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			std::swap(order[i], order[seed % (i + 1)]);
+		}
+
+		radius *= 0.95f;
+		for(size_t i = 0; i < count; ++i)
+			Grow(center, radius, XMLoadFloat3(&stream[order[i]]));
+
+		if(radius < bestRadius)
+		{
+			bestCenter = center;
+			bestRadius = radius;
+		}
+	}
+
+	// Growing is exact only up to round-off; make sure every vertex is inside.
+	float maxDistanceSq = 0.0f;
+	for(size_t i = 0; i < count; ++i)
+		maxDistanceSq = std::max(maxDistanceSq, XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&stream[i]) - bestCenter)));
+
+	BoundingSphere sphere;
+	XMStoreFloat3(&sphere.Center, bestCenter);
+	sphere.Radius = std::max(bestRadius, std::sqrt(maxDistanceSq));
+	return sphere;
+}
+
+BoundingOrientedBox BoundsBuilder::ComputeOrientedBox(const XMFLOAT3* positions, size_t positionStride,
+	size_t count, const uint32* indices, size_t indexCount)
+{
+	BoundingBox box = ComputeBox(positions, positionStride, count);
+	if(count < 3)
+		return ToOrientedBox(box);
+
+	PositionStream stream = MakeStream(positions, positionStride);
+
+	double covariance[3][3];
+	if(indices == nullptr || !SurfaceCovariance(stream, indices, indexCount, covariance))
+		PointCovariance(stream, count, covariance);
+
+	double eigenvectors[3][3];
+	JacobiEigen(covariance, eigenvectors);
+
+	XMVECTOR axes[3];
+	for(int k = 0; k < 2; ++k)
+	{
+		axes[k] = XMVector3Normalize(XMVectorSet((float)eigenvectors[0][k], (float)eigenvectors[1][k],
+			(float)eigenvectors[2][k], 0.0f));
+	}
+
+	// A proper rotation, whatever the sign of the third eigenvector.
+	axes[2] = XMVector3Normalize(XMVector3Cross(axes[0], axes[1]));
+	axes[1] = XMVector3Cross(axes[2], axes[0]);
+
+	XMVECTOR lo = XMVectorReplicate(FLT_MAX);
+	XMVECTOR hi = XMVectorReplicate(-FLT_MAX);
+	for(size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR p = XMLoadFloat3(&stream[i]);
+		XMVECTOR local = XMVectorSet(XMVectorGetX(XMVector3Dot(p, axes[0])),
+			XMVectorGetX(XMVector3Dot(p, axes[1])), XMVectorGetX(XMVector3Dot(p, axes[2])), 0.0f);
+		lo = XMVectorMin(lo, local);
+		hi = XMVectorMax(hi, local);
+	}
+
+	XMFLOAT3 localCenter;
+	XMFLOAT3 extents;
+	XMStoreFloat3(&localCenter, 0.5f*(lo + hi));
+	XMStoreFloat3(&extents, 0.5f*(hi - lo));
+
+	// PCA is not optimal; an axis-aligned box that is already tighter wins.
+	float volume = extents.x*extents.y*extents.z;
+	float boxVolume = box.Extents.x*box.Extents.y*box.Extents.z;
+	if(boxVolume <= volume)
+		return ToOrientedBox(box);
+
+	BoundingOrientedBox obb;
+	XMStoreFloat3(&obb.Center, localCenter.x*axes[0] + localCenter.y*axes[1] + localCenter.z*axes[2]);
+	obb.Extents = extents;
+
+	// Row vectors: the box's local x axis maps to axes[0], and so on.
+	XMMATRIX rotation(axes[0], axes[1], axes[2], XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f));
+	XMStoreFloat4(&obb.Orientation, XMQuaternionNormalize(XMQuaternionRotationMatrix(rotation)));
+	return obb;
+}
+
+BoundsBuilder::Volumes BoundsBuilder::Compute(const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+	const uint16* indices, size_t indexCount, int baseVertex, const Options& options)
+{
+	return ComputeVolumes(positions, positionStride, vertexCount, indices, indexCount, baseVertex, options);
+}
+
+BoundsBuilder::Volumes BoundsBuilder::Compute(const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+	const uint32* indices, size_t indexCount, int baseVertex, const Options& options)
+{
+	return ComputeVolumes(positions, positionStride, vertexCount, indices, indexCount, baseVertex, options);
+}
+
+void BoundsBuilder::Assign(const Volumes& volumes, SubmeshGeometry& submesh)
+{
+	submesh.Bounds = volumes.Box;
+	submesh.SphereBounds = volumes.Sphere;
+	submesh.OrientedBounds = volumes.OrientedBox;
+}
@@ -0,0 +1,71 @@
+//***************************************************************************************
+// BoundsBuilder.h
+//
+// Bounding volumes of a mesh or submesh, computed at load time so culling and
+// level of detail selection can work with tight volumes:
+//
+//   Box          - axis-aligned, a min/max reduction four vertices at a time
+//   Sphere       - Ritter's sphere, then shrunk and regrown over reshuffled
+//                  vertices a few times, keeping the smallest
+//   OrientedBox  - aligned with the principal axes of the surface (area
+//                  weighted, so dense tessellation does not skew it); falls back
+//                  to the axis-aligned box when that is smaller
+//
+// Every volume contains all the vertices exactly; only how tight it is varies.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include <cstdint>
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+
+class BoundsBuilder
+{
+public:
+
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+
+	struct Options
+	{
+		// Shrink and regrow passes after the initial Ritter sphere; 0 keeps it.
+		uint32 SphereIterations = 8;
+
+		bool OrientedBox = true;
+	};
+
+	struct Volumes
+	{
+		DirectX::BoundingBox Box;
+		DirectX::BoundingSphere Sphere;
+		DirectX::BoundingOrientedBox OrientedBox;   // the Box, unrotated, if not requested
+	};
+
+	///<summary>
+	/// Individual volumes over count positions, consecutive positions being
+	/// positionStride bytes apart.  The oriented box weighs the axes by triangle
+	/// area when given the mesh's indices, by vertex otherwise.
+	///</summary>
+	static DirectX::BoundingBox ComputeBox(const DirectX::XMFLOAT3* positions, size_t positionStride, size_t count);
+	static DirectX::BoundingSphere ComputeSphere(const DirectX::XMFLOAT3* positions, size_t positionStride, size_t count,
+		uint32 iterations);
+	static DirectX::BoundingOrientedBox ComputeOrientedBox(const DirectX::XMFLOAT3* positions, size_t positionStride,
+		size_t count, const uint32* indices, size_t indexCount);
+
+	///<summary>
+	/// Volumes of the vertices referenced by indexCount indices, each offset by
+	/// baseVertex as in DrawIndexedInstanced; vertices outside the submesh are
+	/// ignored.
+	///</summary>
+	static Volumes Compute(const DirectX::XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+		const uint16* indices, size_t indexCount, int baseVertex, const Options& options);
+	static Volumes Compute(const DirectX::XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+		const uint32* indices, size_t indexCount, int baseVertex, const Options& options);
+
+	///<summary>
+	/// Stores the volumes in submesh's Bounds, SphereBounds and OrientedBounds.
+	///</summary>
+	static void Assign(const Volumes& volumes, SubmeshGeometry& submesh);
+};
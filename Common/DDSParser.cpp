@@ -0,0 +1,788 @@
+//***************************************************************************************
+// DDSParser.cpp
+//***************************************************************************************
+
+#include "DDSParser.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	using uint32 = DDSParser::uint32;
+	using uint64 = DDSParser::uint64;
+
+	// The D3D12_REQ_* limits, spelled out so parsing needs no Direct3D headers.
+	const uint32 MaxMipLevels = 15;
+	const uint32 MaxTexture1DSize = 16384;
+	const uint32 MaxTexture2DSize = 16384;
+	const uint32 MaxTextureCubeSize = 16384;
+	const uint32 MaxTexture3DSize = 2048;
+	const uint32 MaxArraySize = 2048;
+
+	DDSParser::AlphaMode GetAlphaMode(const DDS_HEADER& header, const DDS_HEADER_DXT10* extension)
+	{
+		if (extension != nullptr)
+		{
+			auto mode = static_cast<DDSParser::AlphaMode>(extension->miscFlags2 & DDS_MISC_FLAGS2_ALPHA_MODE_MASK);
+			switch (mode)
+			{
+			case DDSParser::AlphaMode::Straight:
+			case DDSParser::AlphaMode::Premultiplied:
+			case DDSParser::AlphaMode::Opaque:
+			case DDSParser::AlphaMode::Custom:
+				return mode;
+			default:
+				return DDSParser::AlphaMode::Unknown;
+			}
+		}
+
+		if ((header.ddspf.flags & DDS_FOURCC) &&
+			(MAKEFOURCC('D', 'X', 'T', '2') == header.ddspf.fourCC || MAKEFOURCC('D', 'X', 'T', '4') == header.ddspf.fourCC))
+		{
+			return DDSParser::AlphaMode::Premultiplied;
+		}
+
+		return DDSParser::AlphaMode::Unknown;
+	}
+}
+
+DDSParser::Status DDSParser::Parse(const uint8* data, size_t size, uint32 maxSize, Texture& texture)
+{
+	texture = Texture();
+
+	if (data == nullptr)
+		return Status::InvalidArgument;
+
+	// The headers are copied out rather than cast in place, so data need not be
+	// aligned.
+	uint32 magic = 0;
+	DDS_HEADER header;
+	if (size < sizeof(magic) + sizeof(header))
+		return Status::BadHeader;
+
+	std::memcpy(&magic, data, sizeof(magic));
+	std::memcpy(&header, data + sizeof(magic), sizeof(header));
+
+	if (magic != DDS_MAGIC ||
+		header.size != sizeof(DDS_HEADER) ||
+		header.ddspf.size != sizeof(DDS_PIXELFORMAT))
+	{
+		return Status::BadHeader;
+	}
+
+	uint64 dataOffset = sizeof(magic) + sizeof(header);
+
+	DDS_HEADER_DXT10 extension = {};
+	bool hasExtension = (header.ddspf.flags & DDS_FOURCC) && MAKEFOURCC('D', 'X', '1', '0') == header.ddspf.fourCC;
+	if (hasExtension)
+	{
+		if (size < dataOffset + sizeof(extension))
+			return Status::BadHeader;
+
+		std::memcpy(&extension, data + dataOffset, sizeof(extension));
+		dataOffset += sizeof(extension);
+	}
+
+	uint32 width = header.width;
+	uint32 height = header.height;
+	uint32 depth = header.depth;
+	uint32 arraySize = 1;
+	uint32 mipCount = std::max(header.mipMapCount, 1u);
+
+	TextureDesc desc;
+
+	if (hasExtension)
+	{
+		arraySize = extension.arraySize;
+		if (arraySize == 0)
+			return Status::InvalidData;
+
+		switch (extension.dxgiFormat)
+		{
+		case DXGI_FORMAT_AI44:
+		case DXGI_FORMAT_IA44:
+		case DXGI_FORMAT_P8:
+		case DXGI_FORMAT_A8P8:
+			return Status::NotSupported;
+
+		default:
+			if (BitsPerPixel(extension.dxgiFormat) == 0)
+				return Status::NotSupported;
+		}
+
+		desc.Format = extension.dxgiFormat;
+
+		switch (extension.resourceDimension)
+		{
+		case DDS_DIMENSION_TEXTURE1D:
+			if ((header.flags & DDS_HEIGHT) && height != 1)
+				return Status::InvalidData;
+			height = depth = 1;
+			desc.Dimension = ResourceDimension::Texture1D;
+			break;
+
+		case DDS_DIMENSION_TEXTURE2D:
+			if (extension.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+			{
+				if (arraySize > MaxArraySize / 6)
+					return Status::NotSupported;
+				arraySize *= 6;
+				desc.IsCubeMap = true;
+			}
+			depth = 1;
+			desc.Dimension = ResourceDimension::Texture2D;
+			break;
+
+		case DDS_DIMENSION_TEXTURE3D:
+			if (!(header.flags & DDS_HEADER_FLAGS_VOLUME))
+				return Status::InvalidData;
+			if (arraySize > 1)
+				return Status::NotSupported;
+			desc.Dimension = ResourceDimension::Texture3D;
+			break;
+
+		default:
+			return Status::NotSupported;
+		}
+	}
+	else
+	{
+		desc.Format = GetDXGIFormat(header.ddspf);
+		if (desc.Format == DXGI_FORMAT_UNKNOWN)
+			return Status::NotSupported;
+
+		if (header.flags & DDS_HEADER_FLAGS_VOLUME)
+		{
+			desc.Dimension = ResourceDimension::Texture3D;
+		}
+		else
+		{
+			if (header.caps2 & DDS_CUBEMAP)
+			{
+				// Partial cube maps are not supported.
+				if ((header.caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES)
+					return Status::NotSupported;
+				arraySize = 6;
+				desc.IsCubeMap = true;
+			}
+
+			depth = 1;
+			desc.Dimension = ResourceDimension::Texture2D;
+		}
+	}
+
+	if (width == 0 || height == 0 || depth == 0)
+		return Status::InvalidData;
+
+	// Bound sizes (for security purposes we don't trust DDS file metadata larger
+	// than the D3D 11.x hardware requirements).
+	if (mipCount > MaxMipLevels || arraySize > MaxArraySize)
+		return Status::NotSupported;
+
+	switch (desc.Dimension)
+	{
+	case ResourceDimension::Texture1D:
+		if (width > MaxTexture1DSize)
+			return Status::NotSupported;
+		break;
+
+	case ResourceDimension::Texture2D:
+	{
+		uint32 maxDimension = desc.IsCubeMap ? MaxTextureCubeSize : MaxTexture2DSize;
+		if (width > maxDimension || height > maxDimension)
+			return Status::NotSupported;
+	} break;
+
+	default:
+		if (width > MaxTexture3DSize || height > MaxTexture3DSize || depth > MaxTexture3DSize)
+			return Status::NotSupported;
+		break;
+	}
+
+	// Every array slice holds its whole mip chain; mips over maxSize are walked
+	// past but not listed.
+	Texture result;
+	result.DataOffset = dataOffset;
+	result.Subresources.reserve((size_t)mipCount * arraySize);
+
+	uint64 offset = dataOffset;
+	for (uint32 slice = 0; slice < arraySize; ++slice)
+	{
+		uint32 w = width;
+		uint32 h = height;
+		uint32 d = depth;
+		for (uint32 mip = 0; mip < mipCount; ++mip)
+		{
+			SurfaceInfo surface = GetSurfaceInfo(w, h, desc.Format);
+			uint64 byteSize = surface.NumBytes * d;
+			if (byteSize > size - offset)
+				return Status::Truncated;
+
+			if (mipCount <= 1 || maxSize == 0 || (w <= maxSize && h <= maxSize && d <= maxSize))
+			{
+				if (result.Subresources.empty())
+				{
+					desc.Width = w;
+					desc.Height = h;
+					desc.Depth = d;
+				}
+
+				Subresource subresource;
+				subresource.Offset = offset;
+				subresource.RowPitch = surface.RowBytes;
+				subresource.SlicePitch = surface.NumBytes;
+				subresource.NumRows = (uint32)surface.NumRows;
+				subresource.Width = w;
+				subresource.Height = h;
+				subresource.Depth = d;
+				result.Subresources.push_back(subresource);
+			}
+			else if (slice == 0)
+			{
+				++result.SkippedMips;
+			}
+
+			offset += byteSize;
+
+			w = std::max(w >> 1, 1u);
+			h = std::max(h >> 1, 1u);
+			d = std::max(d >> 1, 1u);
+		}
+	}
+
+	// No mip of the chain fits in maxSize.
+	if (result.Subresources.empty())
+		return Status::NotSupported;
+
+	desc.MipLevels = mipCount - result.SkippedMips;
+	desc.ArraySize = arraySize;
+	desc.Alpha = GetAlphaMode(header, hasExtension ? &extension : nullptr);
+
+	result.Desc = desc;
+	texture = std::move(result);
+
+	return Status::Ok;
+}
+
+const char* DDSParser::StatusString(Status status)
+{
+	switch (status)
+	{
+	case Status::Ok:                return "ok";
+	case Status::InvalidArgument:   return "invalid argument";
+	case Status::BadHeader:         return "not a DDS file";
+	case Status::InvalidData:       return "inconsistent DDS header";
+	case Status::NotSupported:      return "unsupported format, dimension or size";
+	case Status::Truncated:         return "pixel data cut short";
+	default:                        return "unknown";
+	}
+}
+
+DDSParser::SurfaceInfo DDSParser::GetSurfaceInfo(uint64 width, uint64 height, DXGI_FORMAT format)
+{
+	uint64 numBytes = 0;
+	uint64 rowBytes = 0;
+	uint64 numRows = 0;
+
+	bool bc = false;
+	bool packed = false;
+	bool planar = false;
+	uint64 bpe = 0;
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+		bc=true;
+		bpe = 8;
+		break;
+
+	case DXGI_FORMAT_BC2_TYPELESS:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_BC6H_TYPELESS:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		bc = true;
+		bpe = 16;
+		break;
+
+	case DXGI_FORMAT_R8G8_B8G8_UNORM:
+	case DXGI_FORMAT_G8R8_G8B8_UNORM:
+	case DXGI_FORMAT_YUY2:
+		packed = true;
+		bpe = 4;
+		break;
+
+	case DXGI_FORMAT_Y210:
+	case DXGI_FORMAT_Y216:
+		packed = true;
+		bpe = 8;
+		break;
+
+	case DXGI_FORMAT_NV12:
+	case DXGI_FORMAT_420_OPAQUE:
+		planar = true;
+		bpe = 2;
+		break;
+
+	case DXGI_FORMAT_P010:
+	case DXGI_FORMAT_P016:
+		planar = true;
+		bpe = 4;
+		break;
+
+	default:
+		break;
+	}
+
+	if (bc)
+	{
+		uint64 numBlocksWide = 0;
+		if (width > 0)
+		{
+			numBlocksWide = std::max<uint64>( 1, (width + 3) / 4 );
+		}
+		uint64 numBlocksHigh = 0;
+		if (height > 0)
+		{
+			numBlocksHigh = std::max<uint64>( 1, (height + 3) / 4 );
+		}
+		rowBytes = numBlocksWide * bpe;
+		numRows = numBlocksHigh;
+		numBytes = rowBytes * numBlocksHigh;
+	}
+	else if (packed)
+	{
+		rowBytes = ( ( width + 1 ) >> 1 ) * bpe;
+		numRows = height;
+		numBytes = rowBytes * height;
+	}
+	else if ( format == DXGI_FORMAT_NV11 )
+	{
+		rowBytes = ( ( width + 3 ) >> 2 ) * 4;
+		numRows = height * 2; // Direct3D makes this simplifying assumption, although it is larger than the 4:1:1 data
+		numBytes = rowBytes * numRows;
+	}
+	else if (planar)
+	{
+		rowBytes = ( ( width + 1 ) >> 1 ) * bpe;
+		numBytes = ( rowBytes * height ) + ( ( rowBytes * height + 1 ) >> 1 );
+		numRows = height + ( ( height + 1 ) >> 1 );
+	}
+	else
+	{
+		uint64 bpp = BitsPerPixel( format );
+		rowBytes = ( width * bpp + 7 ) / 8; // round up to nearest byte
+		numRows = height;
+		numBytes = rowBytes * height;
+	}
+
+	SurfaceInfo info;
+	info.NumBytes = numBytes;
+	info.RowBytes = rowBytes;
+	info.NumRows = numRows;
+	return info;
+}
+
+DDSParser::uint32 DDSParser::BitsPerPixel(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+	case DXGI_FORMAT_R32G32B32A32_UINT:
+	case DXGI_FORMAT_R32G32B32A32_SINT:
+		return 128;
+
+	case DXGI_FORMAT_R32G32B32_TYPELESS:
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+	case DXGI_FORMAT_R32G32B32_UINT:
+	case DXGI_FORMAT_R32G32B32_SINT:
+		return 96;
+
+	case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+	case DXGI_FORMAT_R16G16B16A16_UINT:
+	case DXGI_FORMAT_R16G16B16A16_SNORM:
+	case DXGI_FORMAT_R16G16B16A16_SINT:
+	case DXGI_FORMAT_R32G32_TYPELESS:
+	case DXGI_FORMAT_R32G32_FLOAT:
+	case DXGI_FORMAT_R32G32_UINT:
+	case DXGI_FORMAT_R32G32_SINT:
+	case DXGI_FORMAT_R32G8X24_TYPELESS:
+	case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+	case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+	case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+	case DXGI_FORMAT_Y416:
+	case DXGI_FORMAT_Y210:
+	case DXGI_FORMAT_Y216:
+		return 64;
+
+	case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+	case DXGI_FORMAT_R10G10B10A2_UNORM:
+	case DXGI_FORMAT_R10G10B10A2_UINT:
+	case DXGI_FORMAT_R11G11B10_FLOAT:
+	case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_R8G8B8A8_UINT:
+	case DXGI_FORMAT_R8G8B8A8_SNORM:
+	case DXGI_FORMAT_R8G8B8A8_SINT:
+	case DXGI_FORMAT_R16G16_TYPELESS:
+	case DXGI_FORMAT_R16G16_FLOAT:
+	case DXGI_FORMAT_R16G16_UNORM:
+	case DXGI_FORMAT_R16G16_UINT:
+	case DXGI_FORMAT_R16G16_SNORM:
+	case DXGI_FORMAT_R16G16_SINT:
+	case DXGI_FORMAT_R32_TYPELESS:
+	case DXGI_FORMAT_D32_FLOAT:
+	case DXGI_FORMAT_R32_FLOAT:
+	case DXGI_FORMAT_R32_UINT:
+	case DXGI_FORMAT_R32_SINT:
+	case DXGI_FORMAT_R24G8_TYPELESS:
+	case DXGI_FORMAT_D24_UNORM_S8_UINT:
+	case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+	case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+	case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+	case DXGI_FORMAT_R8G8_B8G8_UNORM:
+	case DXGI_FORMAT_G8R8_G8B8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+	case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+	case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+	case DXGI_FORMAT_AYUV:
+	case DXGI_FORMAT_Y410:
+	case DXGI_FORMAT_YUY2:
+		return 32;
+
+	case DXGI_FORMAT_P010:
+	case DXGI_FORMAT_P016:
+		return 24;
+
+	case DXGI_FORMAT_R8G8_TYPELESS:
+	case DXGI_FORMAT_R8G8_UNORM:
+	case DXGI_FORMAT_R8G8_UINT:
+	case DXGI_FORMAT_R8G8_SNORM:
+	case DXGI_FORMAT_R8G8_SINT:
+	case DXGI_FORMAT_R16_TYPELESS:
+	case DXGI_FORMAT_R16_FLOAT:
+	case DXGI_FORMAT_D16_UNORM:
+	case DXGI_FORMAT_R16_UNORM:
+	case DXGI_FORMAT_R16_UINT:
+	case DXGI_FORMAT_R16_SNORM:
+	case DXGI_FORMAT_R16_SINT:
+	case DXGI_FORMAT_B5G6R5_UNORM:
+	case DXGI_FORMAT_B5G5R5A1_UNORM:
+	case DXGI_FORMAT_A8P8:
+	case DXGI_FORMAT_B4G4R4A4_UNORM:
+		return 16;
+
+	case DXGI_FORMAT_NV12:
+	case DXGI_FORMAT_420_OPAQUE:
+	case DXGI_FORMAT_NV11:
+		return 12;
+
+	case DXGI_FORMAT_R8_TYPELESS:
+	case DXGI_FORMAT_R8_UNORM:
+	case DXGI_FORMAT_R8_UINT:
+	case DXGI_FORMAT_R8_SNORM:
+	case DXGI_FORMAT_R8_SINT:
+	case DXGI_FORMAT_A8_UNORM:
+	case DXGI_FORMAT_AI44:
+	case DXGI_FORMAT_IA44:
+	case DXGI_FORMAT_P8:
+		return 8;
+
+	case DXGI_FORMAT_R1_UNORM:
+		return 1;
+
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+		return 4;
+
+	case DXGI_FORMAT_BC2_TYPELESS:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_BC6H_TYPELESS:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return 8;
+
+	default:
+		return 0;
+	}
+}
+
+#define ISBITMASK( r,g,b,a ) ( ddpf.RBitMask == r && ddpf.GBitMask == g && ddpf.BBitMask == b && ddpf.ABitMask == a )
+
+DXGI_FORMAT DDSParser::GetDXGIFormat(const DDS_PIXELFORMAT& ddpf)
+{
+	if (ddpf.flags & DDS_RGB)
+	{
+		// Note that sRGB formats are written using the "DX10" extended header
+
+		switch (ddpf.RGBBitCount)
+		{
+		case 32:
+			if (ISBITMASK(0x000000ff,0x0000ff00,0x00ff0000,0xff000000))
+			{
+				return DXGI_FORMAT_R8G8B8A8_UNORM;
+			}
+
+			if (ISBITMASK(0x00ff0000,0x0000ff00,0x000000ff,0xff000000))
+			{
+				return DXGI_FORMAT_B8G8R8A8_UNORM;
+			}
+
+			if (ISBITMASK(0x00ff0000,0x0000ff00,0x000000ff,0x00000000))
+			{
+				return DXGI_FORMAT_B8G8R8X8_UNORM;
+			}
+
+			// No DXGI format maps to ISBITMASK(0x000000ff,0x0000ff00,0x00ff0000,0x00000000) aka D3DFMT_X8B8G8R8
+
+			// Note that many common DDS reader/writers (including D3DX) swap the
+			// the RED/BLUE masks for 10:10:10:2 formats. We assume
+			// below that the 'backwards' header mask is being used since it is most
+			// likely written by D3DX. The more robust solution is to use the 'DX10'
+			// header extension and specify the DXGI_FORMAT_R10G10B10A2_UNORM format directly
+
+			// For 'correct' writers, this should be 0x000003ff,0x000ffc00,0x3ff00000 for RGB data
+			if (ISBITMASK(0x3ff00000,0x000ffc00,0x000003ff,0xc0000000))
+			{
+				return DXGI_FORMAT_R10G10B10A2_UNORM;
+			}
+
+			// No DXGI format maps to ISBITMASK(0x000003ff,0x000ffc00,0x3ff00000,0xc0000000) aka D3DFMT_A2R10G10B10
+
+			if (ISBITMASK(0x0000ffff,0xffff0000,0x00000000,0x00000000))
+			{
+				return DXGI_FORMAT_R16G16_UNORM;
+			}
+
+			if (ISBITMASK(0xffffffff,0x00000000,0x00000000,0x00000000))
+			{
+				// Only 32-bit color channel format in D3D9 was R32F
+				return DXGI_FORMAT_R32_FLOAT; // D3DX writes this out as a FourCC of 114
+			}
+			break;
+
+		case 24:
+			// No 24bpp DXGI formats aka D3DFMT_R8G8B8
+			break;
+
+		case 16:
+			if (ISBITMASK(0x7c00,0x03e0,0x001f,0x8000))
+			{
+				return DXGI_FORMAT_B5G5R5A1_UNORM;
+			}
+			if (ISBITMASK(0xf800,0x07e0,0x001f,0x0000))
+			{
+				return DXGI_FORMAT_B5G6R5_UNORM;
+			}
+
+			// No DXGI format maps to ISBITMASK(0x7c00,0x03e0,0x001f,0x0000) aka D3DFMT_X1R5G5B5
+
+			if (ISBITMASK(0x0f00,0x00f0,0x000f,0xf000))
+			{
+				return DXGI_FORMAT_B4G4R4A4_UNORM;
+			}
+
+			// No DXGI format maps to ISBITMASK(0x0f00,0x00f0,0x000f,0x0000) aka D3DFMT_X4R4G4B4
+
+			// No 3:3:2, 3:3:2:8, or paletted DXGI formats aka D3DFMT_A8R3G3B2, D3DFMT_R3G3B2, D3DFMT_P8, D3DFMT_A8P8, etc.
+			break;
+		}
+	}
+	else if (ddpf.flags & DDS_LUMINANCE)
+	{
+		if (8 == ddpf.RGBBitCount)
+		{
+			if (ISBITMASK(0x000000ff,0x00000000,0x00000000,0x00000000))
+			{
+				return DXGI_FORMAT_R8_UNORM; // D3DX10/11 writes this out as DX10 extension
+			}
+
+			// No DXGI format maps to ISBITMASK(0x0f,0x00,0x00,0xf0) aka D3DFMT_A4L4
+		}
+
+		if (16 == ddpf.RGBBitCount)
+		{
+			if (ISBITMASK(0x0000ffff,0x00000000,0x00000000,0x00000000))
+			{
+				return DXGI_FORMAT_R16_UNORM; // D3DX10/11 writes this out as DX10 extension
+			}
+			if (ISBITMASK(0x000000ff,0x00000000,0x00000000,0x0000ff00))
+			{
+				return DXGI_FORMAT_R8G8_UNORM; // D3DX10/11 writes this out as DX10 extension
+			}
+		}
+	}
+	else if (ddpf.flags & DDS_ALPHA)
+	{
+		if (8 == ddpf.RGBBitCount)
+		{
+			return DXGI_FORMAT_A8_UNORM;
+		}
+	}
+	else if (ddpf.flags & DDS_FOURCC)
+	{
+		if (MAKEFOURCC( 'D', 'X', 'T', '1' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_BC1_UNORM;
+		}
+		if (MAKEFOURCC( 'D', 'X', 'T', '3' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_BC2_UNORM;
+		}
+		if (MAKEFOURCC( 'D', 'X', 'T', '5' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_BC3_UNORM;
+		}
+
+		// While pre-multiplied alpha isn't directly supported by the DXGI formats,
+		// they are basically the same as these BC formats so they can be mapped
+		if (MAKEFOURCC( 'D', 'X', 'T', '2' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_BC2_UNORM;
+		}
+		if (MAKEFOURCC( 'D', 'X', 'T', '4' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_BC3_UNORM;
+		}
+
+		if (MAKEFOURCC( 'A', 'T', 'I', '1' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_BC4_UNORM;
+		}
+		if (MAKEFOURCC( 'B', 'C', '4', 'U' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_BC4_UNORM;
+		}
+		if (MAKEFOURCC( 'B', 'C', '4', 'S' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_BC4_SNORM;
+		}
+
+		if (MAKEFOURCC( 'A', 'T', 'I', '2' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_BC5_UNORM;
+		}
+		if (MAKEFOURCC( 'B', 'C', '5', 'U' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_BC5_UNORM;
+		}
+		if (MAKEFOURCC( 'B', 'C', '5', 'S' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_BC5_SNORM;
+		}
+
+		// BC6H and BC7 are written using the "DX10" extended header
+
+		if (MAKEFOURCC( 'R', 'G', 'B', 'G' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_R8G8_B8G8_UNORM;
+		}
+		if (MAKEFOURCC( 'G', 'R', 'G', 'B' ) == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_G8R8_G8B8_UNORM;
+		}
+
+		if (MAKEFOURCC('Y','U','Y','2') == ddpf.fourCC)
+		{
+			return DXGI_FORMAT_YUY2;
+		}
+
+		// Check for D3DFORMAT enums being set here
+		switch( ddpf.fourCC )
+		{
+		case 36: // D3DFMT_A16B16G16R16
+			return DXGI_FORMAT_R16G16B16A16_UNORM;
+
+		case 110: // D3DFMT_Q16W16V16U16
+			return DXGI_FORMAT_R16G16B16A16_SNORM;
+
+		case 111: // D3DFMT_R16F
+			return DXGI_FORMAT_R16_FLOAT;
+
+		case 112: // D3DFMT_G16R16F
+			return DXGI_FORMAT_R16G16_FLOAT;
+
+		case 113: // D3DFMT_A16B16G16R16F
+			return DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+		case 114: // D3DFMT_R32F
+			return DXGI_FORMAT_R32_FLOAT;
+
+		case 115: // D3DFMT_G32R32F
+			return DXGI_FORMAT_R32G32_FLOAT;
+
+		case 116: // D3DFMT_A32B32G32R32F
+			return DXGI_FORMAT_R32G32B32A32_FLOAT;
+		}
+	}
+
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+#undef ISBITMASK
+
+DXGI_FORMAT DDSParser::MakeSRGB(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+		return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+
+	case DXGI_FORMAT_BC1_UNORM:
+		return DXGI_FORMAT_BC1_UNORM_SRGB;
+
+	case DXGI_FORMAT_BC2_UNORM:
+		return DXGI_FORMAT_BC2_UNORM_SRGB;
+
+	case DXGI_FORMAT_BC3_UNORM:
+		return DXGI_FORMAT_BC3_UNORM_SRGB;
+
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+		return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+		return DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+
+	case DXGI_FORMAT_BC7_UNORM:
+		return DXGI_FORMAT_BC7_UNORM_SRGB;
+
+	default:
+		return format;
+	}
+}
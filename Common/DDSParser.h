@@ -0,0 +1,218 @@
+//***************************************************************************************
+// DDSParser.h
+//
+// Device independent DDS parsing.  Validates the headers of a DDS file held in
+// memory and works out where each subresource is in it, without touching
+// Direct3D, Win32 or the file system.  The D3D12 path of DDSTextureLoader builds
+// its upload from this table; headless tools that inspect or process DDS files
+// on the CPU get exactly the same layout.
+//
+// Subresources are listed in D3D12 order, every mip of array slice 0 first
+// (index = mip + slice*MipLevels).  Offsets count from the start of the buffer
+// given to Parse, so they stay valid however the file was brought into memory.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <dxgiformat.h>
+#include <vector>
+
+//--------------------------------------------------------------------------------------
+// DDS file structure definitions
+//
+// See DDS.h in the 'Texconv' sample and the 'DirectXTex' library
+//--------------------------------------------------------------------------------------
+#ifndef MAKEFOURCC
+    #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
+                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
+                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
+#endif /* defined(MAKEFOURCC) */
+
+#pragma pack(push,1)
+
+const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+
+struct DDS_PIXELFORMAT
+{
+    uint32_t    size;
+    uint32_t    flags;
+    uint32_t    fourCC;
+    uint32_t    RGBBitCount;
+    uint32_t    RBitMask;
+    uint32_t    GBitMask;
+    uint32_t    BBitMask;
+    uint32_t    ABitMask;
+};
+
+#define DDS_FOURCC      0x00000004  // DDPF_FOURCC
+#define DDS_RGB         0x00000040  // DDPF_RGB
+#define DDS_LUMINANCE   0x00020000  // DDPF_LUMINANCE
+#define DDS_ALPHA       0x00000002  // DDPF_ALPHA
+
+#define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
+
+#define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
+#define DDS_WIDTH  0x00000004 // DDSD_WIDTH
+
+#define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
+#define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
+#define DDS_CUBEMAP_POSITIVEY 0x00001200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
+#define DDS_CUBEMAP_NEGATIVEY 0x00002200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
+#define DDS_CUBEMAP_POSITIVEZ 0x00004200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
+#define DDS_CUBEMAP_NEGATIVEZ 0x00008200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
+
+#define DDS_CUBEMAP_ALLFACES ( DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |\
+                               DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |\
+                               DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
+
+#define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
+
+// D3D10_RESOURCE_DIMENSION and D3D10_RESOURCE_MISC_TEXTURECUBE values, as stored
+// in DDS_HEADER_DXT10.
+#define DDS_DIMENSION_TEXTURE1D 2
+#define DDS_DIMENSION_TEXTURE2D 3
+#define DDS_DIMENSION_TEXTURE3D 4
+
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4
+
+enum DDS_MISC_FLAGS2
+{
+    DDS_MISC_FLAGS2_ALPHA_MODE_MASK = 0x7L,
+};
+
+struct DDS_HEADER
+{
+    uint32_t        size;
+    uint32_t        flags;
+    uint32_t        height;
+    uint32_t        width;
+    uint32_t        pitchOrLinearSize;
+    uint32_t        depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
+    uint32_t        mipMapCount;
+    uint32_t        reserved1[11];
+    DDS_PIXELFORMAT ddspf;
+    uint32_t        caps;
+    uint32_t        caps2;
+    uint32_t        caps3;
+    uint32_t        caps4;
+    uint32_t        reserved2;
+};
+
+struct DDS_HEADER_DXT10
+{
+    DXGI_FORMAT     dxgiFormat;
+    uint32_t        resourceDimension;
+    uint32_t        miscFlag; // see D3D11_RESOURCE_MISC_FLAG
+    uint32_t        arraySize;
+    uint32_t        miscFlags2;
+};
+
+#pragma pack(pop)
+
+class DDSParser
+{
+public:
+
+	using uint8 = std::uint8_t;
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	enum class Status
+	{
+		Ok,
+		InvalidArgument,
+		BadHeader,      // not a DDS file, or its headers are cut short
+		InvalidData,    // the headers contradict each other
+		NotSupported,   // a format, dimension or size D3D12 can't create
+		Truncated       // the pixel data ends before the last subresource
+	};
+
+	// Values match D3D12_RESOURCE_DIMENSION.
+	enum class ResourceDimension
+	{
+		Unknown = 0,
+		Texture1D = 2,
+		Texture2D = 3,
+		Texture3D = 4
+	};
+
+	// Values match DirectX::DDS_ALPHA_MODE.
+	enum class AlphaMode
+	{
+		Unknown = 0,
+		Straight = 1,
+		Premultiplied = 2,
+		Opaque = 3,
+		Custom = 4
+	};
+
+	struct TextureDesc
+	{
+		ResourceDimension Dimension = ResourceDimension::Unknown;
+		DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+		uint32 Width = 0;
+		uint32 Height = 1;
+		uint32 Depth = 1;
+		uint32 MipLevels = 1;
+		uint32 ArraySize = 1;       // 2D slices; six per cube of a cube map
+		bool IsCubeMap = false;
+		AlphaMode Alpha = AlphaMode::Unknown;
+	};
+
+	struct Subresource
+	{
+		uint64 Offset = 0;          // from the start of the file
+		uint64 RowPitch = 0;        // bytes per row of pixels, or of 4x4 blocks
+		uint64 SlicePitch = 0;      // bytes per depth slice
+		uint32 NumRows = 0;         // rows of pixels or blocks per depth slice
+		uint32 Width = 0;
+		uint32 Height = 0;
+		uint32 Depth = 0;
+
+		uint64 ByteSize()const { return SlicePitch * Depth; }
+	};
+
+	struct Texture
+	{
+		TextureDesc Desc;
+		uint32 SkippedMips = 0;     // top mips dropped to honour maxSize
+		uint64 DataOffset = 0;      // first byte after the headers
+		std::vector<Subresource> Subresources;
+
+		size_t SubresourceIndex(uint32 mip, uint32 arraySlice)const { return mip + (size_t)arraySlice * Desc.MipLevels; }
+	};
+
+	struct SurfaceInfo
+	{
+		uint64 NumBytes = 0;
+		uint64 RowBytes = 0;
+		uint64 NumRows = 0;
+	};
+
+	///<summary>
+	/// Parses the DDS file in data[0, size).  Mips larger than maxSize in any
+	/// dimension are left out, as long as smaller ones remain; 0 keeps them all.
+	/// Rejects anything D3D12 couldn't create, so a texture parsed here can be
+	/// handed to the device as is.  Nothing is copied: texture only describes
+	/// where things are in data.
+	///</summary>
+	static Status Parse(const uint8* data, size_t size, uint32 maxSize, Texture& texture);
+
+	///<summary>
+	/// Size and pitch of one width by height surface of format, as DDS files
+	/// store it (rows tightly packed, no D3D12 pitch alignment).
+	///</summary>
+	static SurfaceInfo GetSurfaceInfo(uint64 width, uint64 height, DXGI_FORMAT format);
+
+	// 0 for formats DDS files can't hold.
+	static uint32 BitsPerPixel(DXGI_FORMAT format);
+
+	// The DXGI format a legacy (non DX10) pixel format maps to, or DXGI_FORMAT_UNKNOWN.
+	static DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT& pixelFormat);
+
+	static DXGI_FORMAT MakeSRGB(DXGI_FORMAT format);
+
+	static const char* StatusString(Status status);
+};
@@ -3,11 +3,238 @@
 //***************************************************************************************
 
 #include "GeometryGenerator.h"
+#include "ThreadPool.h"
 #include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <mutex>
 
 using namespace DirectX;
 
-GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions)
+namespace
+{
+	const std::uint64_t EmptyEdgeKey = ~0ull;
+
+	// Open-addressing table that maps an undirected edge (min,max vertex index) to
+	// the index of its midpoint vertex.  Keys and values live in two flat arrays so
+	// a lookup touches at most a couple of cache lines.
+	class EdgeMidpointCache
+	{
+	public:
+		explicit EdgeMidpointCache(size_t maxEdges)
+		{
+			// Keep the load factor at or below 50%.
+			size_t capacity = 16;
+			while(capacity < maxEdges*2)
+				capacity <<= 1;
+
+			mMask = capacity - 1;
+			mKeys.assign(capacity, EmptyEdgeKey);
+			mValues.resize(capacity);
+		}
+
+		// Returns the midpoint index of edge (a,b), assigning nextIndex to it if the
+		// edge has not been seen yet.
+		std::uint32_t FindOrInsert(std::uint32_t a, std::uint32_t b, std::uint32_t& nextIndex)
+		{
+			std::uint64_t key = a < b ?
+				(std::uint64_t(a) << 32) | b :
+				(std::uint64_t(b) << 32) | a;
+
+			size_t slot = Hash(key) & mMask;
+			while(mKeys[slot] != EmptyEdgeKey)
+			{
+				if(mKeys[slot] == key)
+					return mValues[slot];
+
+				slot = (slot + 1) & mMask;
+			}
+
+			mKeys[slot] = key;
+			mValues[slot] = nextIndex;
+			return nextIndex++;
+		}
+
+		template<typename Fn>
+		void ForEach(Fn fn) const
+		{
+			for(size_t i = 0; i < mKeys.size(); ++i)
+			{
+				if(mKeys[i] != EmptyEdgeKey)
+					fn(std::uint32_t(mKeys[i] >> 32), std::uint32_t(mKeys[i]), mValues[i]);
+			}
+		}
+
+	private:
+		static std::uint64_t Hash(std::uint64_t key)
+		{
+			key ^= key >> 33;
+			key *= 0xff51afd7ed558ccdull;
+			key ^= key >> 33;
+			return key;
+		}
+
+		size_t mMask = 0;
+		std::vector<std::uint64_t> mKeys;
+		std::vector<std::uint32_t> mValues;
+	};
+
+	// Returns (j, j+1, j+2, j+3) as floats.
+	inline XMVECTOR XM_CALLCONV LaneIndices(std::uint32_t j)
+	{
+		return XMVectorAdd(XMVectorReplicate((float)j), XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f));
+	}
+
+	inline XMVECTOR XM_CALLCONV LoadFloat4(const float* src)
+	{
+		return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(src));
+	}
+
+	// Writes four XMFLOAT3s given as one vector per component.  Four packed
+	// XMFLOAT3s are exactly three 16-byte vectors:
+	//   x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+	inline void XM_CALLCONV StoreFloat3x4(XMFLOAT3* dst, FXMVECTOR x, FXMVECTOR y, FXMVECTOR z)
+	{
+		XMVECTOR xy01 = XMVectorMergeXY(x, y); // x0 y0 x1 y1
+		XMVECTOR xy23 = XMVectorMergeZW(x, y); // x2 y2 x3 y3
+
+		XMVECTOR r0 = XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_0Y, XM_PERMUTE_1X, XM_PERMUTE_0Z>(xy01, z);
+		XMVECTOR yz = XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0X>(xy01, z);
+		XMVECTOR r1 = XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_0Y, XM_PERMUTE_1X, XM_PERMUTE_1Y>(yz, xy23);
+		XMVECTOR r2 = XMVectorPermute<XM_PERMUTE_1Z, XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1W>(xy23, z);
+
+		XMFLOAT4* out = reinterpret_cast<XMFLOAT4*>(dst);
+		XMStoreFloat4(&out[0], r0);
+		XMStoreFloat4(&out[1], r1);
+		XMStoreFloat4(&out[2], r2);
+	}
+
+	// Inverse of StoreFloat3x4: reads four packed XMFLOAT3s as one vector per
+	// component.
+	inline void XM_CALLCONV LoadFloat3x4(const XMFLOAT3* src, XMVECTOR& x, XMVECTOR& y, XMVECTOR& z)
+	{
+		const XMFLOAT4* in = reinterpret_cast<const XMFLOAT4*>(src);
+		XMVECTOR r0 = XMLoadFloat4(&in[0]); // x0 y0 z0 x1
+		XMVECTOR r1 = XMLoadFloat4(&in[1]); // y1 z1 x2 y2
+		XMVECTOR r2 = XMLoadFloat4(&in[2]); // z2 x3 y3 z3
+
+		x = XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_0Y, XM_PERMUTE_0Z, XM_PERMUTE_1Y>(
+			XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_1Z>(r0, r1), r2);
+		y = XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_0Y, XM_PERMUTE_0Z, XM_PERMUTE_1Z>(
+			XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_1X, XM_PERMUTE_1W, XM_PERMUTE_1W>(r0, r1), r2);
+		z = XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_0Y, XM_PERMUTE_1X, XM_PERMUTE_1W>(
+			XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_1Y, XM_PERMUTE_1Y, XM_PERMUTE_1Y>(r0, r1), r2);
+	}
+
+	// Writes four XMFLOAT2s given as one vector per component.
+	inline void XM_CALLCONV StoreFloat2x4(XMFLOAT2* dst, FXMVECTOR u, FXMVECTOR v)
+	{
+		XMFLOAT4* out = reinterpret_cast<XMFLOAT4*>(dst);
+		XMStoreFloat4(&out[0], XMVectorMergeXY(u, v));
+		XMStoreFloat4(&out[1], XMVectorMergeZW(u, v));
+	}
+
+	// cos/sin of j*step for j in [0, count), padded to a multiple of four so the
+	// tables can always be read a whole vector at a time.
+	void BuildSinCosTable(float step, std::uint32_t count, std::vector<float>& cosTable, std::vector<float>& sinTable)
+	{
+		size_t padded = (count + 3) & ~size_t(3);
+		cosTable.resize(padded);
+		sinTable.resize(padded);
+
+		for(std::uint32_t j = 0; j < padded; j += 4)
+		{
+			XMVECTOR s;
+			XMVECTOR c;
+			XMVectorSinCos(&s, &c, LaneIndices(j)*step);
+
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&cosTable[j]), c);
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&sinTable[j]), s);
+		}
+	}
+
+	// The icosahedron that geospheres are tessellated from.
+	const float IcosahedronX = 0.525731f;
+	const float IcosahedronZ = 0.850651f;
+
+	const XMFLOAT3 IcosahedronPositions[12] =
+	{
+		XMFLOAT3(-IcosahedronX, 0.0f, IcosahedronZ),  XMFLOAT3(IcosahedronX, 0.0f, IcosahedronZ),
+		XMFLOAT3(-IcosahedronX, 0.0f, -IcosahedronZ), XMFLOAT3(IcosahedronX, 0.0f, -IcosahedronZ),
+		XMFLOAT3(0.0f, IcosahedronZ, IcosahedronX),   XMFLOAT3(0.0f, IcosahedronZ, -IcosahedronX),
+		XMFLOAT3(0.0f, -IcosahedronZ, IcosahedronX),  XMFLOAT3(0.0f, -IcosahedronZ, -IcosahedronX),
+		XMFLOAT3(IcosahedronZ, IcosahedronX, 0.0f),   XMFLOAT3(-IcosahedronZ, IcosahedronX, 0.0f),
+		XMFLOAT3(IcosahedronZ, -IcosahedronX, 0.0f),  XMFLOAT3(-IcosahedronZ, -IcosahedronX, 0.0f)
+	};
+
+	const std::uint32_t IcosahedronFaces[60] =
+	{
+		1,4,0,  4,9,0,  4,5,9,  8,5,4,  1,8,4,
+		1,10,8, 10,3,8, 8,3,5,  3,2,5,  3,7,2,
+		3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0,
+		10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7
+	};
+
+	// The 30 icosahedron edges as (lower, higher) corner index, and the edge
+	// joining any two adjacent corners.
+	struct IcosahedronEdgeTable
+	{
+		std::uint32_t Corners[30][2];
+		std::uint8_t EdgeOf[12][12];
+
+		IcosahedronEdgeTable()
+		{
+			std::memset(EdgeOf, 0xff, sizeof(EdgeOf));
+
+			std::uint32_t edgeCount = 0;
+			for(std::uint32_t i = 0; i < 60; ++i)
+			{
+				std::uint32_t a = IcosahedronFaces[i];
+				std::uint32_t b = IcosahedronFaces[i % 3 == 2 ? i - 2 : i + 1];
+				if(EdgeOf[a][b] != 0xff)
+					continue;
+
+				Corners[edgeCount][0] = std::min(a, b);
+				Corners[edgeCount][1] = std::max(a, b);
+				EdgeOf[a][b] = EdgeOf[b][a] = (std::uint8_t)edgeCount;
+				++edgeCount;
+			}
+
+			assert(edgeCount == 30);
+		}
+	};
+
+	const IcosahedronEdgeTable& IcosahedronEdges()
+	{
+		static const IcosahedronEdgeTable table;
+		return table;
+	}
+
+	// Scatters one SoA stream into the interleaved vertices at dst.
+	template<typename T>
+	void InterleaveStream(const std::vector<T>& stream, size_t vertexCount, int offset, std::uint32_t stride, std::uint8_t* dst)
+	{
+		if(offset < 0)
+			return;
+
+		dst += offset;
+		if(stream.empty())
+		{
+			for(size_t i = 0; i < vertexCount; ++i)
+				std::memset(dst + i*stride, 0, sizeof(T));
+		}
+		else
+		{
+			for(size_t i = 0; i < vertexCount; ++i)
+				std::memcpy(dst + i*stride, &stream[i], sizeof(T));
+		}
+	}
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions,
+														  SubdivisionMode mode, std::vector<SubdivisionStats>* stats)
 {
     MeshData meshData;
 
@@ -94,8 +321,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float heig
     // Put a cap on the number of subdivisions.
     numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
 
-    for(uint32 i = 0; i < numSubdivisions; ++i)
-        Subdivide(meshData);
+    Subdivide(meshData, numSubdivisions, mode, stats);
 
     return meshData;
 }
@@ -211,7 +437,86 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
     return meshData;
 }
  
-void GeometryGenerator::Subdivide(MeshData& meshData)
+void GeometryGenerator::Subdivide(MeshData& meshData, uint32 numSubdivisions, SubdivisionMode mode,
+								  std::vector<SubdivisionStats>* stats)
+{
+	for(uint32 i = 0; i < numSubdivisions; ++i)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		if(mode == SubdivisionMode::SharedEdges)
+			SubdivideShared(meshData);
+		else
+			SubdivideSplit(meshData);
+
+		if(stats != nullptr)
+		{
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+			SubdivisionStats levelStats;
+			levelStats.Level = i + 1;
+			levelStats.VertexCount = (uint32)meshData.Vertices.size();
+			levelStats.TriangleCount = (uint32)meshData.Indices32.size() / 3;
+			levelStats.Milliseconds = elapsed.count();
+			stats->push_back(levelStats);
+		}
+	}
+}
+
+void GeometryGenerator::SubdivideShared(MeshData& meshData)
+{
+	/*
+	       v1
+	       *
+	      / \
+	     /   \
+	  m0*-----*m1
+	   / \   / \
+	  /   \ /   \
+	 *-----*-----*
+	 v0    m2     v2
+	*/
+
+	// Same split as SubdivideSplit, except that the original vertices are kept in
+	// place and each edge midpoint is created once and shared by both triangles
+	// of the edge.  Edges are keyed by vertex index, so seams (vertices duplicated
+	// for differing normals/texture coordinates) stay seams.
+
+	uint32 numTris = (uint32)meshData.Indices32.size()/3;
+	uint32 nextIndex = (uint32)meshData.Vertices.size();
+
+	// 3 edges per triangle is the upper bound (no sharing at all).
+	EdgeMidpointCache midpoints((size_t)numTris*3);
+
+	std::vector<uint32> indices(meshData.Indices32.size()*4);
+	for(uint32 i = 0; i < numTris; ++i)
+	{
+		uint32 i0 = meshData.Indices32[i*3+0];
+		uint32 i1 = meshData.Indices32[i*3+1];
+		uint32 i2 = meshData.Indices32[i*3+2];
+
+		uint32 m0 = midpoints.FindOrInsert(i0, i1, nextIndex);
+		uint32 m1 = midpoints.FindOrInsert(i1, i2, nextIndex);
+		uint32 m2 = midpoints.FindOrInsert(i0, i2, nextIndex);
+
+		uint32* tri = &indices[i*12];
+		tri[0] = i0; tri[1]  = m0; tri[2]  = m2;
+		tri[3] = m0; tri[4]  = m1; tri[5]  = m2;
+		tri[6] = m2; tri[7]  = m1; tri[8]  = i2;
+		tri[9] = m0; tri[10] = i1; tri[11] = m1;
+	}
+
+	// The number of unique edges is now known, so the vertex array grows once.
+	meshData.Vertices.resize(nextIndex);
+	midpoints.ForEach([&](uint32 a, uint32 b, uint32 m)
+	{
+		meshData.Vertices[m] = MidPoint(meshData.Vertices[a], meshData.Vertices[b]);
+	});
+
+	meshData.Indices32.swap(indices);
+}
+
+void GeometryGenerator::SubdivideSplit(MeshData& meshData)
 {
 	// Save a copy of the input geometry.
 	MeshData inputCopy = meshData;
@@ -220,15 +525,17 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	meshData.Vertices.resize(0);
 	meshData.Indices32.resize(0);
 
-	//       v1
-	//       *
-	//      / \
-	//     /   \
-	//  m0*-----*m1
-	//   / \   / \
-	//  /   \ /   \
-	// *-----*-----*
-	// v0    m2     v2
+	/*
+	       v1
+	       *
+	      / \
+	     /   \
+	  m0*-----*m1
+	   / \   / \
+	  /   \ /   \
+	 *-----*-----*
+	 v0    m2     v2
+	*/
 
 	uint32 numTris = (uint32)inputCopy.Indices32.size()/3;
 	for(uint32 i = 0; i < numTris; ++i)
@@ -304,7 +611,8 @@ GeometryGenerator::Vertex GeometryGenerator::MidPoint(const Vertex& v0, const Ve
     return v;
 }
 
-GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uint32 numSubdivisions)
+GeometryGenerator::MeshData GeometryGenerator::CreateIcosahedron(uint32 numSubdivisions,
+																  SubdivisionMode mode, std::vector<SubdivisionStats>* stats)
 {
     MeshData meshData;
 
@@ -313,35 +621,21 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
 
 	// Approximate a sphere by tessellating an icosahedron.
 
-	const float X = 0.525731f; 
-	const float Z = 0.850651f;
-
-	XMFLOAT3 pos[12] = 
-	{
-		XMFLOAT3(-X, 0.0f, Z),  XMFLOAT3(X, 0.0f, Z),  
-		XMFLOAT3(-X, 0.0f, -Z), XMFLOAT3(X, 0.0f, -Z),    
-		XMFLOAT3(0.0f, Z, X),   XMFLOAT3(0.0f, Z, -X), 
-		XMFLOAT3(0.0f, -Z, X),  XMFLOAT3(0.0f, -Z, -X),    
-		XMFLOAT3(Z, X, 0.0f),   XMFLOAT3(-Z, X, 0.0f), 
-		XMFLOAT3(Z, -X, 0.0f),  XMFLOAT3(-Z, -X, 0.0f)
-	};
-
-    uint32 k[60] =
-	{
-		1,4,0,  4,9,0,  4,5,9,  8,5,4,  1,8,4,    
-		1,10,8, 10,3,8, 8,3,5,  3,2,5,  3,7,2,    
-		3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0, 
-		10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7 
-	};
-
     meshData.Vertices.resize(12);
-    meshData.Indices32.assign(&k[0], &k[60]);
+    meshData.Indices32.assign(&IcosahedronFaces[0], &IcosahedronFaces[60]);
 
 	for(uint32 i = 0; i < 12; ++i)
-		meshData.Vertices[i].Position = pos[i];
+		meshData.Vertices[i].Position = IcosahedronPositions[i];
 
-	for(uint32 i = 0; i < numSubdivisions; ++i)
-		Subdivide(meshData);
+	Subdivide(meshData, numSubdivisions, mode, stats);
+
+    return meshData;
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uint32 numSubdivisions,
+																SubdivisionMode mode, std::vector<SubdivisionStats>* stats)
+{
+    MeshData meshData = CreateIcosahedron(numSubdivisions, mode, stats);
 
 	// Project vertices onto sphere and scale.
 	for(uint32 i = 0; i < meshData.Vertices.size(); ++i)
@@ -591,26 +885,30 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float dep
 	//
 
 	meshData.Indices32.resize(faceCount*3); // 3 indices per face
+	WriteGridIndices(meshData.Indices32.data(), m, n);
 
+    return meshData;
+}
+
+void GeometryGenerator::WriteGridIndices(uint32* indices, uint32 m, uint32 n)
+{
 	// Iterate over each quad and compute indices.
 	uint32 k = 0;
 	for(uint32 i = 0; i < m-1; ++i)
 	{
 		for(uint32 j = 0; j < n-1; ++j)
 		{
-			meshData.Indices32[k]   = i*n+j;
-			meshData.Indices32[k+1] = i*n+j+1;
-			meshData.Indices32[k+2] = (i+1)*n+j;
+			indices[k]   = i*n+j;
+			indices[k+1] = i*n+j+1;
+			indices[k+2] = (i+1)*n+j;
 
-			meshData.Indices32[k+3] = (i+1)*n+j;
-			meshData.Indices32[k+4] = i*n+j+1;
-			meshData.Indices32[k+5] = (i+1)*n+j+1;
+			indices[k+3] = (i+1)*n+j;
+			indices[k+4] = i*n+j+1;
+			indices[k+5] = (i+1)*n+j+1;
 
 			k += 6; // next quad
 		}
 	}
-
-    return meshData;
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, float w, float h, float depth)
@@ -655,3 +953,819 @@ GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, floa
 
     return meshData;
 }
+
+
+GeometryGenerator::MeshDataSoA GeometryGenerator::CreateSphereSoA(float radius, uint32 sliceCount, uint32 stackCount)
+{
+    return CreateShapeSoA(ShapeDesc::Sphere(radius, sliceCount, stackCount));
+}
+
+void GeometryGenerator::WriteSphere(const SoASlice& dst, float radius, uint32 sliceCount, uint32 stackCount)
+{
+	// Same layout as CreateSphere: top pole, stackCount-1 rings of sliceCount+1
+	// vertices, bottom pole.
+    uint32 ringVertexCount = sliceCount + 1;
+    uint32 vertexCount = (stackCount-1)*ringVertexCount + 2;
+
+    XMFLOAT3* positions = dst.Positions;
+    XMFLOAT3* normals = dst.Normals;
+    XMFLOAT3* tangents = dst.TangentUs;
+    XMFLOAT2* texCs = dst.TexCs;
+
+	positions[0] = XMFLOAT3(0.0f, +radius, 0.0f);
+	normals[0]   = XMFLOAT3(0.0f, +1.0f, 0.0f);
+	tangents[0]  = XMFLOAT3(1.0f, 0.0f, 0.0f);
+	texCs[0]     = XMFLOAT2(0.0f, 0.0f);
+
+	float phiStep   = XM_PI/stackCount;
+	float thetaStep = 2.0f*XM_PI/sliceCount;
+
+	// Every ring uses the same theta values, so their sines and cosines are
+	// computed once and each ring only scales them by sin(phi)/cos(phi).
+	std::vector<float> cosTable;
+	std::vector<float> sinTable;
+	BuildSinCosTable(thetaStep, ringVertexCount, cosTable, sinTable);
+
+	for(uint32 i = 1; i <= stackCount-1; ++i)
+	{
+		float phi = i*phiStep;
+		float sinPhi = sinf(phi);
+		float cosPhi = cosf(phi);
+
+		XMVECTOR rSinPhi = XMVectorReplicate(radius*sinPhi);
+		XMVECTOR vSinPhi = XMVectorReplicate(sinPhi);
+		XMVECTOR y  = XMVectorReplicate(radius*cosPhi);
+		XMVECTOR ny = XMVectorReplicate(cosPhi);
+		XMVECTOR v  = XMVectorReplicate(phi / XM_PI);
+
+		uint32 base = 1 + (i-1)*ringVertexCount;
+		uint32 j = 0;
+		for(; j + 4 <= ringVertexCount; j += 4)
+		{
+			XMVECTOR c = LoadFloat4(&cosTable[j]);
+			XMVECTOR s = LoadFloat4(&sinTable[j]);
+			XMVECTOR theta = LaneIndices(j)*thetaStep;
+
+			// The normal is the unit position and the tangent is dP/dtheta
+			// normalized, both of which have closed forms on a sphere.
+			StoreFloat3x4(&positions[base+j], rSinPhi*c, y, rSinPhi*s);
+			StoreFloat3x4(&normals[base+j], vSinPhi*c, ny, vSinPhi*s);
+			StoreFloat3x4(&tangents[base+j], -s, XMVectorZero(), c);
+			StoreFloat2x4(&texCs[base+j], theta / XM_2PI, v);
+		}
+
+		for(; j < ringVertexCount; ++j)
+		{
+			float c = cosTable[j];
+			float s = sinTable[j];
+
+			positions[base+j] = XMFLOAT3(radius*sinPhi*c, radius*cosPhi, radius*sinPhi*s);
+			normals[base+j]   = XMFLOAT3(sinPhi*c, cosPhi, sinPhi*s);
+			tangents[base+j]  = XMFLOAT3(-s, 0.0f, c);
+			texCs[base+j]     = XMFLOAT2(j*thetaStep / XM_2PI, phi / XM_PI);
+		}
+	}
+
+	uint32 southPoleIndex = vertexCount-1;
+	positions[southPoleIndex] = XMFLOAT3(0.0f, -radius, 0.0f);
+	normals[southPoleIndex]   = XMFLOAT3(0.0f, -1.0f, 0.0f);
+	tangents[southPoleIndex]  = XMFLOAT3(1.0f, 0.0f, 0.0f);
+	texCs[southPoleIndex]     = XMFLOAT2(0.0f, 1.0f);
+
+    uint32* indices = dst.Indices;
+    uint32 k = 0;
+
+    for(uint32 i = 1; i <= sliceCount; ++i)
+	{
+		indices[k++] = 0;
+		indices[k++] = i+1;
+		indices[k++] = i;
+	}
+
+    uint32 baseIndex = 1;
+	for(uint32 i = 0; i < stackCount-2; ++i)
+	{
+		for(uint32 j = 0; j < sliceCount; ++j)
+		{
+			indices[k++] = baseIndex + i*ringVertexCount + j;
+			indices[k++] = baseIndex + i*ringVertexCount + j+1;
+			indices[k++] = baseIndex + (i+1)*ringVertexCount + j;
+
+			indices[k++] = baseIndex + (i+1)*ringVertexCount + j;
+			indices[k++] = baseIndex + i*ringVertexCount + j+1;
+			indices[k++] = baseIndex + (i+1)*ringVertexCount + j+1;
+		}
+	}
+
+	baseIndex = southPoleIndex - ringVertexCount;
+	for(uint32 i = 0; i < sliceCount; ++i)
+	{
+		indices[k++] = southPoleIndex;
+		indices[k++] = baseIndex+i;
+		indices[k++] = baseIndex+i+1;
+	}
+}
+
+GeometryGenerator::MeshDataSoA GeometryGenerator::CreateGeosphereSoA(float radius, uint32 numSubdivisions)
+{
+    return CreateShapeSoA(ShapeDesc::Geosphere(radius, numSubdivisions));
+}
+
+std::shared_ptr<const GeometryGenerator::MeshDataSoA> GeometryGenerator::GetUnitGeosphere(uint32 numSubdivisions)
+{
+    const uint32 LevelCount = 7;
+    static std::once_flag built[LevelCount];
+    static std::shared_ptr<const MeshDataSoA> meshes[LevelCount];
+
+    uint32 level = std::min<uint32>(numSubdivisions, LevelCount - 1);
+    std::call_once(built[level], [level]()
+    {
+        uint32 vertexCount = 0;
+        uint32 indexCount = 0;
+        ShapeCounts(ShapeDesc::Geosphere(1.0f, level), vertexCount, indexCount);
+
+        auto meshData = std::make_shared<MeshDataSoA>();
+        meshData->ResizeVertices(vertexCount);
+        meshData->Indices32.resize(indexCount);
+        WriteUnitGeosphere(SliceOf(*meshData, 0, 0), level);
+
+        meshes[level] = meshData;
+    });
+
+    return meshes[level];
+}
+
+void GeometryGenerator::WriteGeosphere(const SoASlice& dst, float radius, uint32 numSubdivisions)
+{
+    std::shared_ptr<const MeshDataSoA> unit = GetUnitGeosphere(numSubdivisions);
+    CopyToSlice(*unit, dst);
+
+	// On the unit sphere position and normal coincide.
+	for(size_t i = 0; i < unit->VertexCount(); ++i)
+		XMStoreFloat3(&dst.Positions[i], radius*XMLoadFloat3(&unit->Normals[i]));
+}
+
+void GeometryGenerator::WriteUnitGeosphere(const SoASlice& dst, uint32 numSubdivisions)
+{
+	// Subdividing a triangle numSubdivisions times cuts each of its edges into
+	// n = 2^numSubdivisions segments and leaves a triangular grid of points
+	// a + (i/n)(b-a) + (j/n)(c-a), i+j <= n.  Those are written directly, one
+	// icosahedron face at a time.  Vertices are numbered corners first, then the
+	// n-1 inner points of each edge (from its lower corner up), then the inner
+	// points of each face, so the faces on either side of an edge share its
+	// vertices without any lookup.
+	const IcosahedronEdgeTable& edges = IcosahedronEdges();
+
+	uint32 n = 1u << std::min<uint32>(numSubdivisions, 6u);
+	uint32 edgeBase = 12;
+	uint32 faceBase = edgeBase + 30*(n - 1);
+	uint32 faceInnerCount = (n - 1)*(n - 2)/2;
+	float step = 1.0f / n;
+
+	XMFLOAT3* positions = dst.Positions;
+
+	for(uint32 i = 0; i < 12; ++i)
+		positions[i] = IcosahedronPositions[i];
+
+	for(uint32 e = 0; e < 30; ++e)
+	{
+		XMVECTOR a = XMLoadFloat3(&IcosahedronPositions[edges.Corners[e][0]]);
+		XMVECTOR b = XMLoadFloat3(&IcosahedronPositions[edges.Corners[e][1]]);
+		for(uint32 t = 1; t < n; ++t)
+			XMStoreFloat3(&positions[edgeBase + e*(n - 1) + t - 1], XMVectorLerp(a, b, t*step));
+	}
+
+	// Grid point (i, j) of the face being written, row by row in j, mapped to
+	// its vertex.
+	std::vector<uint32> grid((n + 1)*(n + 2)/2);
+	auto rowStart = [n](uint32 j) { return j*(n + 1) - j*(j - 1)/2; };
+
+	// Inner point t of the edge from corner a to corner b.
+	auto edgeVertex = [&](uint32 a, uint32 b, uint32 t)
+	{
+		uint32 e = edges.EdgeOf[a][b];
+		return edgeBase + e*(n - 1) + (a < b ? t : n - t) - 1;
+	};
+
+	uint32* indices = dst.Indices;
+	uint32 k = 0;
+
+	for(uint32 f = 0; f < 20; ++f)
+	{
+		uint32 c0 = IcosahedronFaces[3*f + 0];
+		uint32 c1 = IcosahedronFaces[3*f + 1];
+		uint32 c2 = IcosahedronFaces[3*f + 2];
+
+		XMVECTOR p0 = XMLoadFloat3(&IcosahedronPositions[c0]);
+		XMVECTOR u = (XMLoadFloat3(&IcosahedronPositions[c1]) - p0)*step;
+		XMVECTOR v = (XMLoadFloat3(&IcosahedronPositions[c2]) - p0)*step;
+
+		uint32 inner = faceBase + f*faceInnerCount;
+		for(uint32 j = 0; j <= n; ++j)
+		{
+			uint32* row = &grid[rowStart(j)];
+			for(uint32 i = 0; i + j <= n; ++i)
+			{
+				if(i == 0 && j == 0)
+					row[i] = c0;
+				else if(j == 0)
+					row[i] = i == n ? c1 : edgeVertex(c0, c1, i);
+				else if(i == 0)
+					row[i] = j == n ? c2 : edgeVertex(c0, c2, j);
+				else if(i + j == n)
+					row[i] = edgeVertex(c1, c2, j);
+				else
+				{
+					row[i] = inner++;
+					XMStoreFloat3(&positions[row[i]], p0 + (float)i*u + (float)j*v);
+				}
+			}
+		}
+
+		// Same winding as the face: (i,j) (i+1,j) (i,j+1) points the way
+		// c0 c1 c2 does.
+		for(uint32 j = 0; j < n; ++j)
+		{
+			const uint32* row = &grid[rowStart(j)];
+			const uint32* next = &grid[rowStart(j + 1)];
+			for(uint32 i = 0; i + j < n; ++i)
+			{
+				indices[k++] = row[i];
+				indices[k++] = row[i+1];
+				indices[k++] = next[i];
+
+				if(i + j + 1 < n)
+				{
+					indices[k++] = row[i+1];
+					indices[k++] = next[i+1];
+					indices[k++] = next[i];
+				}
+			}
+		}
+	}
+
+	assert(k == 60*n*n);
+
+	ProjectToUnitSphere(dst, 10*n*n + 2);
+}
+
+void GeometryGenerator::ProjectToUnitSphere(const SoASlice& dst, uint32 vertexCount)
+{
+	// Normalize, then derive the texture coordinates from spherical coordinates
+	// and the tangent from dP/dtheta, which normalizes to (-sin, 0, cos) of
+	// theta.  Four vertices at a time, the rest one by one.
+	XMVECTOR vTwoPi = XMVectorReplicate(XM_2PI);
+	XMVECTOR vOne = XMVectorSplatOne();
+
+	uint32 i = 0;
+	for(; i + 4 <= vertexCount; i += 4)
+	{
+		XMVECTOR x, y, z;
+		LoadFloat3x4(&dst.Positions[i], x, y, z);
+
+		XMVECTOR invLength = XMVectorReciprocalSqrt(x*x + y*y + z*z);
+		x *= invLength;
+		y *= invLength;
+		z *= invLength;
+
+		XMVECTOR theta = XMVectorATan2(z, x);
+		theta = XMVectorSelect(theta, theta + vTwoPi, XMVectorLess(theta, XMVectorZero()));
+		XMVECTOR phi = XMVectorACos(XMVectorClamp(y, -vOne, vOne));
+
+		XMVECTOR s, c;
+		XMVectorSinCos(&s, &c, theta);
+
+		StoreFloat3x4(&dst.Positions[i], x, y, z);
+		StoreFloat3x4(&dst.Normals[i], x, y, z);
+		StoreFloat3x4(&dst.TangentUs[i], -s, XMVectorZero(), c);
+		StoreFloat2x4(&dst.TexCs[i], theta / XM_2PI, phi / XM_PI);
+	}
+
+	for(; i < vertexCount; ++i)
+	{
+		XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&dst.Positions[i]));
+		XMStoreFloat3(&dst.Positions[i], n);
+		XMStoreFloat3(&dst.Normals[i], n);
+
+		XMFLOAT3 p = dst.Positions[i];
+		float theta = atan2f(p.z, p.x);
+		if(theta < 0.0f)
+			theta += XM_2PI;
+
+		float phi = acosf(std::max(-1.0f, std::min(1.0f, p.y)));
+
+		dst.TexCs[i] = XMFLOAT2(theta/XM_2PI, phi/XM_PI);
+		dst.TangentUs[i] = XMFLOAT3(-sinf(theta), 0.0f, cosf(theta));
+	}
+}
+
+GeometryGenerator::MeshDataSoA GeometryGenerator::CreateCylinderSoA(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
+{
+    return CreateShapeSoA(ShapeDesc::Cylinder(bottomRadius, topRadius, height, sliceCount, stackCount));
+}
+
+void GeometryGenerator::WriteCylinder(const SoASlice& dst, float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
+{
+    uint32 ringCount = stackCount+1;
+    uint32 ringVertexCount = sliceCount+1;
+    uint32 sideVertexCount = ringCount*ringVertexCount;
+    uint32 capVertexCount = ringVertexCount + 1;
+    uint32 sideIndexCount = 6*sliceCount*stackCount;
+    uint32 capIndexCount = 3*sliceCount;
+
+    XMFLOAT3* positions = dst.Positions;
+    XMFLOAT3* normals = dst.Normals;
+    XMFLOAT3* tangents = dst.TangentUs;
+    XMFLOAT2* texCs = dst.TexCs;
+
+	float stackHeight = height / stackCount;
+	float radiusStep = (topRadius - bottomRadius) / stackCount;
+	float dTheta = 2.0f*XM_PI/sliceCount;
+
+	std::vector<float> cosTable;
+	std::vector<float> sinTable;
+	BuildSinCosTable(dTheta, ringVertexCount, cosTable, sinTable);
+
+	// Normalizing cross(T, B) from CreateCylinder gives (h*cos, r0-r1, h*sin)
+	// divided by sqrt(h^2 + (r0-r1)^2), which is the same for every ring.
+	float dr = bottomRadius-topRadius;
+	float invLength = 1.0f / sqrtf(height*height + dr*dr);
+	float nxz = height*invLength;
+	float ny = dr*invLength;
+
+	for(uint32 i = 0; i < ringCount; ++i)
+	{
+		float y = -0.5f*height + i*stackHeight;
+		float r = bottomRadius + i*radiusStep;
+		float v = 1.0f - (float)i/stackCount;
+
+		XMVECTOR vR   = XMVectorReplicate(r);
+		XMVECTOR vY   = XMVectorReplicate(y);
+		XMVECTOR vNxz = XMVectorReplicate(nxz);
+		XMVECTOR vNy  = XMVectorReplicate(ny);
+		XMVECTOR vV   = XMVectorReplicate(v);
+
+		uint32 base = i*ringVertexCount;
+		uint32 j = 0;
+		for(; j + 4 <= ringVertexCount; j += 4)
+		{
+			XMVECTOR c = LoadFloat4(&cosTable[j]);
+			XMVECTOR s = LoadFloat4(&sinTable[j]);
+
+			StoreFloat3x4(&positions[base+j], vR*c, vY, vR*s);
+			StoreFloat3x4(&normals[base+j], vNxz*c, vNy, vNxz*s);
+			StoreFloat3x4(&tangents[base+j], -s, XMVectorZero(), c);
+			StoreFloat2x4(&texCs[base+j], LaneIndices(j) / (float)sliceCount, vV);
+		}
+
+		for(; j < ringVertexCount; ++j)
+		{
+			float c = cosTable[j];
+			float s = sinTable[j];
+
+			positions[base+j] = XMFLOAT3(r*c, y, r*s);
+			normals[base+j]   = XMFLOAT3(nxz*c, ny, nxz*s);
+			tangents[base+j]  = XMFLOAT3(-s, 0.0f, c);
+			texCs[base+j]     = XMFLOAT2((float)j/sliceCount, v);
+		}
+	}
+
+    uint32* indices = dst.Indices;
+    uint32 k = 0;
+	for(uint32 i = 0; i < stackCount; ++i)
+	{
+		for(uint32 j = 0; j < sliceCount; ++j)
+		{
+			indices[k++] = i*ringVertexCount + j;
+			indices[k++] = (i+1)*ringVertexCount + j;
+			indices[k++] = (i+1)*ringVertexCount + j+1;
+
+			indices[k++] = i*ringVertexCount + j;
+			indices[k++] = (i+1)*ringVertexCount + j+1;
+			indices[k++] = i*ringVertexCount + j+1;
+		}
+	}
+
+	WriteCylinderCap(dst, topRadius, +0.5f*height, +1.0f, height, sliceCount, cosTable.data(), sinTable.data(),
+		sideVertexCount, sideIndexCount);
+	WriteCylinderCap(dst, bottomRadius, -0.5f*height, -1.0f, height, sliceCount, cosTable.data(), sinTable.data(),
+		sideVertexCount + capVertexCount, sideIndexCount + capIndexCount);
+}
+
+void GeometryGenerator::WriteCylinderCap(const SoASlice& dst, float radius, float y, float normalY, float height, uint32 sliceCount,
+										 const float* cosTable, const float* sinTable, uint32 baseVertex, uint32 baseIndex)
+{
+    XMFLOAT3* positions = dst.Positions + baseVertex;
+    XMFLOAT3* normals = dst.Normals + baseVertex;
+    XMFLOAT3* tangents = dst.TangentUs + baseVertex;
+    XMFLOAT2* texCs = dst.TexCs + baseVertex;
+
+	// Scale down by the height to try and make top cap texture coord area
+	// proportional to base.
+	XMVECTOR vR      = XMVectorReplicate(radius);
+	XMVECTOR vY      = XMVectorReplicate(y);
+	XMVECTOR vHeight = XMVectorReplicate(height);
+	XMVECTOR vHalf   = XMVectorReplicate(0.5f);
+	XMVECTOR normal  = XMVectorSet(0.0f, normalY, 0.0f, 0.0f);
+	XMVECTOR tangent = XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+
+	uint32 ringVertexCount = sliceCount + 1;
+	uint32 i = 0;
+	for(; i + 4 <= ringVertexCount; i += 4)
+	{
+		XMVECTOR x = vR*LoadFloat4(&cosTable[i]);
+		XMVECTOR z = vR*LoadFloat4(&sinTable[i]);
+
+		StoreFloat3x4(&positions[i], x, vY, z);
+		StoreFloat3x4(&normals[i], XMVectorSplatX(normal), XMVectorSplatY(normal), XMVectorSplatZ(normal));
+		StoreFloat3x4(&tangents[i], XMVectorSplatX(tangent), XMVectorSplatY(tangent), XMVectorSplatZ(tangent));
+		StoreFloat2x4(&texCs[i], x/vHeight + vHalf, z/vHeight + vHalf);
+	}
+
+	for(; i < ringVertexCount; ++i)
+	{
+		float x = radius*cosTable[i];
+		float z = radius*sinTable[i];
+
+		positions[i] = XMFLOAT3(x, y, z);
+		normals[i]   = XMFLOAT3(0.0f, normalY, 0.0f);
+		tangents[i]  = XMFLOAT3(1.0f, 0.0f, 0.0f);
+		texCs[i]     = XMFLOAT2(x/height + 0.5f, z/height + 0.5f);
+	}
+
+	uint32 centerIndex = baseVertex + ringVertexCount;
+	dst.Positions[centerIndex] = XMFLOAT3(0.0f, y, 0.0f);
+	dst.Normals[centerIndex]   = XMFLOAT3(0.0f, normalY, 0.0f);
+	dst.TangentUs[centerIndex] = XMFLOAT3(1.0f, 0.0f, 0.0f);
+	dst.TexCs[centerIndex]     = XMFLOAT2(0.5f, 0.5f);
+
+	// The top cap faces up and the bottom cap faces down, so their windings differ.
+	uint32* indices = dst.Indices + baseIndex;
+	for(uint32 k = 0; k < sliceCount; ++k)
+	{
+		indices[3*k+0] = centerIndex;
+		indices[3*k+1] = normalY > 0.0f ? baseVertex + k+1 : baseVertex + k;
+		indices[3*k+2] = normalY > 0.0f ? baseVertex + k : baseVertex + k+1;
+	}
+}
+
+GeometryGenerator::MeshDataSoA GeometryGenerator::CreateGridSoA(float width, float depth, uint32 m, uint32 n)
+{
+    return CreateShapeSoA(ShapeDesc::Grid(width, depth, m, n));
+}
+
+void GeometryGenerator::WriteGrid(const SoASlice& dst, float width, float depth, uint32 m, uint32 n)
+{
+	uint32 vertexCount = m*n;
+
+	float halfWidth = 0.5f*width;
+	float halfDepth = 0.5f*depth;
+
+	float dx = width / (n-1);
+	float dz = depth / (m-1);
+
+	float du = 1.0f / (n-1);
+	float dv = 1.0f / (m-1);
+
+	std::fill_n(dst.Normals, vertexCount, XMFLOAT3(0.0f, 1.0f, 0.0f));
+	std::fill_n(dst.TangentUs, vertexCount, XMFLOAT3(1.0f, 0.0f, 0.0f));
+
+	XMVECTOR vHalfWidth = XMVectorReplicate(halfWidth);
+
+	for(uint32 i = 0; i < m; ++i)
+	{
+		float z = halfDepth - i*dz;
+		float v = i*dv;
+
+		XMFLOAT3* positions = dst.Positions + i*n;
+		XMFLOAT2* texCs = dst.TexCs + i*n;
+
+		uint32 j = 0;
+		for(; j + 4 <= n; j += 4)
+		{
+			XMVECTOR column = LaneIndices(j);
+			StoreFloat3x4(&positions[j], column*dx - vHalfWidth, XMVectorZero(), XMVectorReplicate(z));
+			StoreFloat2x4(&texCs[j], column*du, XMVectorReplicate(v));
+		}
+
+		for(; j < n; ++j)
+		{
+			positions[j] = XMFLOAT3(-halfWidth + j*dx, 0.0f, z);
+			texCs[j] = XMFLOAT2(j*du, v);
+		}
+	}
+
+	WriteGridIndices(dst.Indices, m, n);
+}
+
+GeometryGenerator::MeshDataSoA GeometryGenerator::ToSoA(const MeshData& meshData)
+{
+    MeshDataSoA soa;
+    soa.ResizeVertices(meshData.Vertices.size());
+
+    for(size_t i = 0; i < meshData.Vertices.size(); ++i)
+    {
+        const Vertex& v = meshData.Vertices[i];
+        soa.Positions[i] = v.Position;
+        soa.Normals[i]   = v.Normal;
+        soa.TangentUs[i] = v.TangentU;
+        soa.TexCs[i]     = v.TexC;
+    }
+
+    soa.Indices32 = meshData.Indices32;
+
+    return soa;
+}
+
+GeometryGenerator::MeshData GeometryGenerator::ToAoS(const MeshDataSoA& meshData)
+{
+    MeshData aos;
+    aos.Vertices.resize(meshData.VertexCount());
+
+    // Streams may be absent (e.g. a positions-only mesh); those attributes stay zero.
+    for(size_t i = 0; i < aos.Vertices.size(); ++i)
+    {
+        Vertex& v = aos.Vertices[i];
+        v.Position = meshData.Positions[i];
+        v.Normal   = i < meshData.Normals.size() ? meshData.Normals[i] : XMFLOAT3(0.0f, 0.0f, 0.0f);
+        v.TangentU = i < meshData.TangentUs.size() ? meshData.TangentUs[i] : XMFLOAT3(0.0f, 0.0f, 0.0f);
+        v.TexC     = i < meshData.TexCs.size() ? meshData.TexCs[i] : XMFLOAT2(0.0f, 0.0f);
+    }
+
+    aos.Indices32 = meshData.Indices32;
+
+    return aos;
+}
+
+void GeometryGenerator::Interleave(const MeshDataSoA& meshData, const VertexLayout& layout, void* dst)
+{
+    std::uint8_t* bytes = static_cast<std::uint8_t*>(dst);
+    size_t vertexCount = meshData.VertexCount();
+
+    // One stream at a time, so each source array is read sequentially.
+    InterleaveStream(meshData.Positions, vertexCount, layout.PositionOffset, layout.Stride, bytes);
+    InterleaveStream(meshData.Normals, vertexCount, layout.NormalOffset, layout.Stride, bytes);
+    InterleaveStream(meshData.TangentUs, vertexCount, layout.TangentUOffset, layout.Stride, bytes);
+    InterleaveStream(meshData.TexCs, vertexCount, layout.TexCOffset, layout.Stride, bytes);
+}
+
+void GeometryGenerator::ComputeBounds(const MeshDataSoA& meshData, XMFLOAT3& vMin, XMFLOAT3& vMax)
+{
+    if(meshData.Positions.empty())
+    {
+        vMin = vMax = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        return;
+    }
+
+    XMVECTOR lo = XMLoadFloat3(&meshData.Positions[0]);
+    XMVECTOR hi = lo;
+    for(const XMFLOAT3& p : meshData.Positions)
+    {
+        XMVECTOR P = XMLoadFloat3(&p);
+        lo = XMVectorMin(lo, P);
+        hi = XMVectorMax(hi, P);
+    }
+
+    XMStoreFloat3(&vMin, lo);
+    XMStoreFloat3(&vMax, hi);
+}
+
+void GeometryGenerator::TransformPositions(MeshDataSoA& meshData, FXMMATRIX M)
+{
+    for(XMFLOAT3& p : meshData.Positions)
+        XMStoreFloat3(&p, XMVector3TransformCoord(XMLoadFloat3(&p), M));
+}
+
+float GeometryGenerator::MaxAttributeError(const MeshData& reference, const MeshDataSoA& meshData)
+{
+    if(reference.Vertices.size() != meshData.VertexCount() || reference.Indices32 != meshData.Indices32)
+        return FLT_MAX;
+
+    float maxError = 0.0f;
+    auto track3 = [&maxError](const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        maxError = std::max(maxError, fabsf(a.x - b.x));
+        maxError = std::max(maxError, fabsf(a.y - b.y));
+        maxError = std::max(maxError, fabsf(a.z - b.z));
+    };
+
+    for(size_t i = 0; i < reference.Vertices.size(); ++i)
+    {
+        const Vertex& v = reference.Vertices[i];
+        track3(v.Position, meshData.Positions[i]);
+        track3(v.Normal, meshData.Normals[i]);
+        track3(v.TangentU, meshData.TangentUs[i]);
+        maxError = std::max(maxError, fabsf(v.TexC.x - meshData.TexCs[i].x));
+        maxError = std::max(maxError, fabsf(v.TexC.y - meshData.TexCs[i].y));
+    }
+
+    return maxError;
+}
+
+GeometryGenerator::ShapeDesc GeometryGenerator::ShapeDesc::Box(float width, float height, float depth, uint32 numSubdivisions)
+{
+    ShapeDesc desc;
+    desc.Type = ShapeType::Box;
+    desc.Width = width;
+    desc.Height = height;
+    desc.Depth = depth;
+    desc.NumSubdivisions = numSubdivisions;
+    return desc;
+}
+
+GeometryGenerator::ShapeDesc GeometryGenerator::ShapeDesc::Sphere(float radius, uint32 sliceCount, uint32 stackCount)
+{
+    ShapeDesc desc;
+    desc.Type = ShapeType::Sphere;
+    desc.Radius = radius;
+    desc.SliceCount = sliceCount;
+    desc.StackCount = stackCount;
+    return desc;
+}
+
+GeometryGenerator::ShapeDesc GeometryGenerator::ShapeDesc::Geosphere(float radius, uint32 numSubdivisions)
+{
+    ShapeDesc desc;
+    desc.Type = ShapeType::Geosphere;
+    desc.Radius = radius;
+    desc.NumSubdivisions = numSubdivisions;
+    return desc;
+}
+
+GeometryGenerator::ShapeDesc GeometryGenerator::ShapeDesc::Cylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount)
+{
+    ShapeDesc desc;
+    desc.Type = ShapeType::Cylinder;
+    desc.Radius = bottomRadius;
+    desc.TopRadius = topRadius;
+    desc.Height = height;
+    desc.SliceCount = sliceCount;
+    desc.StackCount = stackCount;
+    return desc;
+}
+
+GeometryGenerator::ShapeDesc GeometryGenerator::ShapeDesc::Grid(float width, float depth, uint32 m, uint32 n)
+{
+    ShapeDesc desc;
+    desc.Type = ShapeType::Grid;
+    desc.Width = width;
+    desc.Depth = depth;
+    desc.M = m;
+    desc.N = n;
+    return desc;
+}
+
+void GeometryGenerator::ShapeCounts(const ShapeDesc& shape, uint32& vertexCount, uint32& indexCount)
+{
+    uint32 levels = std::min<uint32>(shape.NumSubdivisions, 6u);
+
+    switch(shape.Type)
+    {
+    case ShapeType::Box:
+    {
+        // Each face is two triangles sharing a diagonal; with shared edges that
+        // subdivides into a (2^n+1)x(2^n+1) grid of vertices per face.
+        uint32 side = (1u << levels) + 1;
+        vertexCount = 6*side*side;
+        indexCount = 36u << (2*levels);
+        break;
+    }
+    case ShapeType::Geosphere:
+        vertexCount = (10u << (2*levels)) + 2;
+        indexCount = 60u << (2*levels);
+        break;
+    case ShapeType::Sphere:
+        vertexCount = (shape.StackCount-1)*(shape.SliceCount+1) + 2;
+        indexCount = 6*shape.SliceCount*(shape.StackCount-1);
+        break;
+    case ShapeType::Cylinder:
+        vertexCount = (shape.StackCount+1)*(shape.SliceCount+1) + 2*(shape.SliceCount+2);
+        indexCount = 6*shape.SliceCount*shape.StackCount + 6*shape.SliceCount;
+        break;
+    case ShapeType::Grid:
+        vertexCount = shape.M*shape.N;
+        indexCount = 6*(shape.M-1)*(shape.N-1);
+        break;
+    default:
+        vertexCount = 0;
+        indexCount = 0;
+        break;
+    }
+}
+
+GeometryGenerator::SoASlice GeometryGenerator::SliceOf(MeshDataSoA& meshData, size_t firstVertex, size_t firstIndex)
+{
+    SoASlice slice;
+    slice.Positions = meshData.Positions.data() + firstVertex;
+    slice.Normals = meshData.Normals.data() + firstVertex;
+    slice.TangentUs = meshData.TangentUs.data() + firstVertex;
+    slice.TexCs = meshData.TexCs.data() + firstVertex;
+    slice.Indices = meshData.Indices32.data() + firstIndex;
+    return slice;
+}
+
+void GeometryGenerator::CopyToSlice(const MeshData& meshData, const SoASlice& dst)
+{
+    for(size_t i = 0; i < meshData.Vertices.size(); ++i)
+    {
+        const Vertex& v = meshData.Vertices[i];
+        dst.Positions[i] = v.Position;
+        dst.Normals[i]   = v.Normal;
+        dst.TangentUs[i] = v.TangentU;
+        dst.TexCs[i]     = v.TexC;
+    }
+
+    std::copy(meshData.Indices32.begin(), meshData.Indices32.end(), dst.Indices);
+}
+
+void GeometryGenerator::CopyToSlice(const MeshDataSoA& meshData, const SoASlice& dst)
+{
+    std::copy(meshData.Positions.begin(), meshData.Positions.end(), dst.Positions);
+    std::copy(meshData.Normals.begin(), meshData.Normals.end(), dst.Normals);
+    std::copy(meshData.TangentUs.begin(), meshData.TangentUs.end(), dst.TangentUs);
+    std::copy(meshData.TexCs.begin(), meshData.TexCs.end(), dst.TexCs);
+    std::copy(meshData.Indices32.begin(), meshData.Indices32.end(), dst.Indices);
+}
+
+void GeometryGenerator::WriteShape(const ShapeDesc& shape, const SoASlice& dst)
+{
+    switch(shape.Type)
+    {
+    case ShapeType::Box:
+        // Subdivision needs scratch space, so the box is built on the side and
+        // copied into its slice.
+        CopyToSlice(CreateBox(shape.Width, shape.Height, shape.Depth, shape.NumSubdivisions), dst);
+        break;
+    case ShapeType::Geosphere:
+        WriteGeosphere(dst, shape.Radius, shape.NumSubdivisions);
+        break;
+    case ShapeType::Sphere:
+        WriteSphere(dst, shape.Radius, shape.SliceCount, shape.StackCount);
+        break;
+    case ShapeType::Cylinder:
+        WriteCylinder(dst, shape.Radius, shape.TopRadius, shape.Height, shape.SliceCount, shape.StackCount);
+        break;
+    case ShapeType::Grid:
+        WriteGrid(dst, shape.Width, shape.Depth, shape.M, shape.N);
+        break;
+    }
+}
+
+GeometryGenerator::MeshDataSoA GeometryGenerator::CreateShapeSoA(const ShapeDesc& shape)
+{
+    uint32 vertexCount = 0;
+    uint32 indexCount = 0;
+    ShapeCounts(shape, vertexCount, indexCount);
+
+    MeshDataSoA meshData;
+    meshData.ResizeVertices(vertexCount);
+    meshData.Indices32.resize(indexCount);
+
+    WriteShape(shape, SliceOf(meshData, 0, 0));
+
+    return meshData;
+}
+
+GeometryGenerator::MeshDataSoA GeometryGenerator::CreateShapes(const std::vector<ShapeDesc>& shapes, std::vector<SubmeshRange>& submeshes)
+{
+    //
+    // Lay out every mesh in the combined buffers from the closed-form counts, so
+    // the buffers are allocated once and no mesh waits on another.
+    //
+
+    submeshes.resize(shapes.size());
+
+    uint32 totalVertexCount = 0;
+    uint32 totalIndexCount = 0;
+    for(size_t i = 0; i < shapes.size(); ++i)
+    {
+        uint32 vertexCount = 0;
+        uint32 indexCount = 0;
+        ShapeCounts(shapes[i], vertexCount, indexCount);
+
+        submeshes[i].IndexCount = indexCount;
+        submeshes[i].StartIndexLocation = totalIndexCount;
+        submeshes[i].BaseVertexLocation = (int)totalVertexCount;
+        submeshes[i].VertexCount = vertexCount;
+
+        totalVertexCount += vertexCount;
+        totalIndexCount += indexCount;
+    }
+
+    MeshDataSoA meshData;
+    meshData.ResizeVertices(totalVertexCount);
+    meshData.Indices32.resize(totalIndexCount);
+
+    //
+    // Generate each mesh straight into its slice.  Indices stay local to the
+    // mesh, which is what drawing with BaseVertexLocation expects.
+    //
+
+    ThreadPool::Default().ParallelFor((uint32)shapes.size(), [&](uint32 i)
+    {
+        const SubmeshRange& range = submeshes[i];
+        WriteShape(shapes[i], SliceOf(meshData, range.BaseVertexLocation, range.StartIndexLocation));
+    });
+
+    return meshData;
+}
@@ -14,8 +14,10 @@
 
 #pragma once
 
+#include <cassert>
 #include <cstdint>
 #include <DirectXMath.h>
+#include <memory>
 #include <vector>
 
 class GeometryGenerator
@@ -25,6 +27,27 @@ public:
     using uint16 = std::uint16_t;
     using uint32 = std::uint32_t;
 
+	///<summary>
+	/// Fills indices16 from indices32 the first time it is asked for and returns
+	/// it.  Backs MeshData::GetIndices16 and MeshDataSoA::GetIndices16.
+	///</summary>
+	static std::vector<uint16>& ToIndices16(const std::vector<uint32>& indices32, std::vector<uint16>& indices16)
+	{
+		if(indices16.empty())
+		{
+			indices16.resize(indices32.size());
+			for(size_t i = 0; i < indices32.size(); ++i)
+			{
+				// Truncation would silently corrupt the mesh; use IndexPacker
+				// to rebase or split meshes with more than 65535 vertices.
+				assert(indices32[i] <= 0xffff);
+				indices16[i] = static_cast<uint16>(indices32[i]);
+			}
+		}
+
+		return indices16;
+	}
+
 	struct Vertex
 	{
 		Vertex(){}
@@ -60,25 +83,123 @@ public:
 
         std::vector<uint16>& GetIndices16()
         {
-			if(mIndices16.empty())
-			{
-				mIndices16.resize(Indices32.size());
-				for(size_t i = 0; i < Indices32.size(); ++i)
-					mIndices16[i] = static_cast<uint16>(Indices32[i]);
-			}
-
-			return mIndices16;
+			return ToIndices16(Indices32, mIndices16);
         }
 
 	private:
 		std::vector<uint16> mIndices16;
 	};
 
+	// Structure-of-arrays counterpart of MeshData.  Every attribute lives in its own
+	// contiguous stream, so passes that only need positions (bounds, projection,
+	// transforms) read 12 bytes per vertex instead of a whole 44-byte Vertex.
+	struct MeshDataSoA
+	{
+		std::vector<DirectX::XMFLOAT3> Positions;
+		std::vector<DirectX::XMFLOAT3> Normals;
+		std::vector<DirectX::XMFLOAT3> TangentUs;
+		std::vector<DirectX::XMFLOAT2> TexCs;
+		std::vector<uint32> Indices32;
+
+		size_t VertexCount()const { return Positions.size(); }
+
+		void ResizeVertices(size_t vertexCount)
+		{
+			Positions.resize(vertexCount);
+			Normals.resize(vertexCount);
+			TangentUs.resize(vertexCount);
+			TexCs.resize(vertexCount);
+		}
+
+		std::vector<uint16>& GetIndices16()
+		{
+			return ToIndices16(Indices32, mIndices16);
+		}
+
+	private:
+		std::vector<uint16> mIndices16;
+	};
+
+	// Byte offsets of the MeshDataSoA streams inside an interleaved vertex.  An
+	// offset of -1 leaves that attribute out of the packed vertex.
+	struct VertexLayout
+	{
+		uint32 Stride = 0;
+		int PositionOffset = -1;
+		int NormalOffset = -1;
+		int TangentUOffset = -1;
+		int TexCOffset = -1;
+	};
+
+	enum class ShapeType
+	{
+		Box,
+		Sphere,
+		Geosphere,
+		Cylinder,
+		Grid
+	};
+
+	// One mesh of a CreateShapes batch.  Build it with the factory functions; only
+	// the fields used by Type are read.
+	struct ShapeDesc
+	{
+		ShapeType Type = ShapeType::Box;
+		float Width = 1.0f;          // box, grid
+		float Height = 1.0f;         // box, cylinder
+		float Depth = 1.0f;          // box, grid
+		float Radius = 1.0f;         // sphere, geosphere, cylinder bottom
+		float TopRadius = 1.0f;      // cylinder
+		uint32 SliceCount = 0;       // sphere, cylinder
+		uint32 StackCount = 0;       // sphere, cylinder
+		uint32 NumSubdivisions = 0;  // box, geosphere
+		uint32 M = 0;                // grid rows
+		uint32 N = 0;                // grid columns
+
+		static ShapeDesc Box(float width, float height, float depth, uint32 numSubdivisions);
+		static ShapeDesc Sphere(float radius, uint32 sliceCount, uint32 stackCount);
+		static ShapeDesc Geosphere(float radius, uint32 numSubdivisions);
+		static ShapeDesc Cylinder(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount);
+		static ShapeDesc Grid(float width, float depth, uint32 m, uint32 n);
+	};
+
+	// Where one mesh of a CreateShapes batch landed in the combined buffers.  The
+	// first three fields map one-to-one onto SubmeshGeometry.
+	struct SubmeshRange
+	{
+		uint32 IndexCount = 0;
+		uint32 StartIndexLocation = 0;
+		int BaseVertexLocation = 0;
+		uint32 VertexCount = 0;
+	};
+
+	// How Subdivide treats the midpoints of edges shared by two triangles.
+	enum class SubdivisionMode
+	{
+		// Every input triangle emits its own 3 corners and 3 midpoints, so vertices
+		// on shared edges are duplicated.
+		Split,
+
+		// Midpoints are keyed on the (min,max) index edge and reused by both
+		// triangles of the edge.  Same surface as Split with about half the vertices.
+		SharedEdges
+	};
+
+	// Per-level report filled by the subdivision passes.
+	struct SubdivisionStats
+	{
+		uint32 Level = 0;
+		uint32 VertexCount = 0;
+		uint32 TriangleCount = 0;
+		double Milliseconds = 0.0;
+	};
+
 	///<summary>
 	/// Creates a box centered at the origin with the given dimensions, where each
     /// face has m rows and n columns of vertices.
 	///</summary>
-    MeshData CreateBox(float width, float height, float depth, uint32 numSubdivisions);
+    MeshData CreateBox(float width, float height, float depth, uint32 numSubdivisions,
+        SubdivisionMode mode = SubdivisionMode::SharedEdges, std::vector<SubdivisionStats>* stats = nullptr);
 
 	///<summary>
 	/// Creates a sphere centered at the origin with the given radius.  The
@@ -90,7 +211,8 @@ public:
 	/// Creates a geosphere centered at the origin with the given radius.  The
 	/// depth controls the level of tessellation.
 	///</summary>
-    MeshData CreateGeosphere(float radius, uint32 numSubdivisions);
+    MeshData CreateGeosphere(float radius, uint32 numSubdivisions,
+        SubdivisionMode mode = SubdivisionMode::SharedEdges, std::vector<SubdivisionStats>* stats = nullptr);
 
 	///<summary>
 	/// Creates a cylinder parallel to the y-axis, and centered about the origin.  
@@ -105,15 +227,109 @@ public:
 	///</summary>
     MeshData CreateGrid(float width, float depth, uint32 m, uint32 n);
 
+	///<summary>
+	/// Writes the 6*(m-1)*(n-1) indices of an mxn grid.  They depend only on m
+	/// and n, so grids of the same size can share one copy; see
+	/// IndexPatternCache.
+	///</summary>
+    static void WriteGridIndices(uint32* indices, uint32 m, uint32 n);
+
 	///<summary>
 	/// Creates a quad aligned with the screen.  This is useful for postprocessing and screen effects.
 	///</summary>
     MeshData CreateQuad(float x, float y, float w, float h, float depth);
 
+	///<summary>
+	/// SoA versions of the generators above.  They write each attribute stream
+	/// directly into pre-sized arrays and produce the same indices as their
+	/// MeshData counterparts.  Sphere, cylinder and grid vertices are generated
+	/// four at a time from a per-ring sin/cos table with DirectXMath (SSE/NEON, or
+	/// scalar under _XM_NO_INTRINSICS_), so they match the scalar MeshData
+	/// generators to within float round-off; see MaxAttributeError.
+	///
+	/// The geosphere is the exception: it is written straight at its final level
+	/// rather than subdivided, face by face, so it has the same vertices as
+	/// CreateGeosphere in a different order.
+	///</summary>
+    MeshDataSoA CreateSphereSoA(float radius, uint32 sliceCount, uint32 stackCount);
+    MeshDataSoA CreateGeosphereSoA(float radius, uint32 numSubdivisions);
+    MeshDataSoA CreateCylinderSoA(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount);
+    MeshDataSoA CreateGridSoA(float width, float depth, uint32 m, uint32 n);
+
+	///<summary>
+	/// The radius 1 geosphere at numSubdivisions (capped at 6).  Each level is
+	/// generated on first use and shared from then on; the mesh is immutable, so
+	/// the pointer may be kept and read from any thread.  CreateGeosphereSoA and
+	/// CreateShapes copy it and scale the positions by the radius.
+	///</summary>
+    static std::shared_ptr<const MeshDataSoA> GetUnitGeosphere(uint32 numSubdivisions);
+
+	///<summary>
+	/// Generates all the shapes concurrently on ThreadPool::Default() into one
+	/// combined vertex/index buffer.  The buffer is sized from closed-form counts
+	/// up front and each mesh is written straight into its own slice.  Indices are
+	/// local to each mesh; submeshes receives the offsets to draw each one with.
+	///</summary>
+    MeshDataSoA CreateShapes(const std::vector<ShapeDesc>& shapes, std::vector<SubmeshRange>& submeshes);
+
+	///<summary>
+	/// Lossless conversion between the AoS and SoA mesh representations.
+	///</summary>
+    static MeshDataSoA ToSoA(const MeshData& meshData);
+    static MeshData ToAoS(const MeshDataSoA& meshData);
+
+	///<summary>
+	/// Packs the SoA streams into vertexCount interleaved vertices at dst, using
+	/// the offsets in layout.  Attributes whose stream is empty are zeroed.
+	///</summary>
+    static void Interleave(const MeshDataSoA& meshData, const VertexLayout& layout, void* dst);
+
+	///<summary>
+	/// Position-only passes over SoA meshes.
+	///</summary>
+    static void ComputeBounds(const MeshDataSoA& meshData, DirectX::XMFLOAT3& vMin, DirectX::XMFLOAT3& vMax);
+    static void TransformPositions(MeshDataSoA& meshData, DirectX::FXMMATRIX M);
+
+	///<summary>
+	/// Largest absolute per-component difference between the attributes of the
+	/// two meshes, or FLT_MAX if their vertex counts or indices differ.  Used to
+	/// check the vectorized generators against the scalar reference path.
+	///</summary>
+    static float MaxAttributeError(const MeshData& reference, const MeshDataSoA& meshData);
+
 private:
-	void Subdivide(MeshData& meshData);
+    MeshData CreateIcosahedron(uint32 numSubdivisions, SubdivisionMode mode, std::vector<SubdivisionStats>* stats);
+	void Subdivide(MeshData& meshData, uint32 numSubdivisions, SubdivisionMode mode, std::vector<SubdivisionStats>* stats);
+	void SubdivideSplit(MeshData& meshData);
+	void SubdivideShared(MeshData& meshData);
     Vertex MidPoint(const Vertex& v0, const Vertex& v1);
     void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
     void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
+
+	// Start of one mesh's slice inside a set of SoA streams.  The Write* functions
+	// fill exactly the number of vertices and indices ShapeCounts reports.
+	struct SoASlice
+	{
+		DirectX::XMFLOAT3* Positions = nullptr;
+		DirectX::XMFLOAT3* Normals = nullptr;
+		DirectX::XMFLOAT3* TangentUs = nullptr;
+		DirectX::XMFLOAT2* TexCs = nullptr;
+		uint32* Indices = nullptr;
+	};
+
+    static void ShapeCounts(const ShapeDesc& shape, uint32& vertexCount, uint32& indexCount);
+    static SoASlice SliceOf(MeshDataSoA& meshData, size_t firstVertex, size_t firstIndex);
+    static void CopyToSlice(const MeshData& meshData, const SoASlice& dst);
+    static void CopyToSlice(const MeshDataSoA& meshData, const SoASlice& dst);
+    MeshDataSoA CreateShapeSoA(const ShapeDesc& shape);
+    void WriteShape(const ShapeDesc& shape, const SoASlice& dst);
+    void WriteSphere(const SoASlice& dst, float radius, uint32 sliceCount, uint32 stackCount);
+    void WriteCylinder(const SoASlice& dst, float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount);
+    void WriteCylinderCap(const SoASlice& dst, float radius, float y, float normalY, float height, uint32 sliceCount,
+        const float* cosTable, const float* sinTable, uint32 baseVertex, uint32 baseIndex);
+    void WriteGrid(const SoASlice& dst, float width, float depth, uint32 m, uint32 n);
+    static void WriteGeosphere(const SoASlice& dst, float radius, uint32 numSubdivisions);
+    static void WriteUnitGeosphere(const SoASlice& dst, uint32 numSubdivisions);
+    static void ProjectToUnitSphere(const SoASlice& dst, uint32 vertexCount);
 };
 
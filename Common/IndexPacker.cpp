@@ -0,0 +1,147 @@
+//***************************************************************************************
+// IndexPacker.cpp
+//***************************************************************************************
+
+#include "IndexPacker.h"
+#include <algorithm>
+#include <cassert>
+
+using uint32 = IndexPacker::uint32;
+
+namespace
+{
+	// A run of whole triangles of one submesh, in absolute vertex numbers.
+	struct Cluster
+	{
+		size_t Submesh;
+		uint32 FirstIndex;          // into the source index list
+		uint32 IndexCount;
+		uint32 MinVertex;
+		uint32 MaxVertex;
+	};
+
+	// Splits one submesh into runs of consecutive triangles whose vertex span
+	// stays within maxSpan.  A single triangle wider than that still gets a
+	// cluster of its own, which the caller then treats as not fitting.
+	void SplitSubmesh(const std::vector<uint32>& indices, const IndexPacker::Submesh& submesh, size_t submeshIndex,
+		uint32 maxSpan, std::vector<Cluster>& clusters)
+	{
+		assert(submesh.IndexCount % 3 == 0);
+
+		Cluster current = { submeshIndex, submesh.StartIndexLocation, 0, ~0u, 0 };
+
+		for(uint32 i = 0; i < submesh.IndexCount; i += 3)
+		{
+			uint32 triMin = ~0u;
+			uint32 triMax = 0;
+			for(uint32 c = 0; c < 3; ++c)
+			{
+				uint32 v = (uint32)(submesh.BaseVertexLocation + (int)indices[submesh.StartIndexLocation + i + c]);
+				triMin = std::min(triMin, v);
+				triMax = std::max(triMax, v);
+			}
+
+			uint32 newMin = std::min(current.MinVertex, triMin);
+			uint32 newMax = std::max(current.MaxVertex, triMax);
+			if(current.IndexCount > 0 && newMax - newMin + 1 > maxSpan)
+			{
+				clusters.push_back(current);
+				current.FirstIndex += current.IndexCount;
+				current.IndexCount = 0;
+				newMin = triMin;
+				newMax = triMax;
+			}
+
+			current.IndexCount += 3;
+			current.MinVertex = newMin;
+			current.MaxVertex = newMax;
+		}
+
+		if(current.IndexCount > 0)
+			clusters.push_back(current);
+	}
+}
+
+IndexPacker::PackedIndices IndexPacker::Pack(const std::vector<uint32>& indices, const std::vector<Submesh>& submeshes, bool allowSplit)
+{
+	//
+	// Cut every submesh into clusters.  Without splitting, each submesh is one
+	// cluster however wide it is.
+	//
+
+	std::vector<Cluster> clusters;
+	clusters.reserve(submeshes.size());
+
+	uint32 maxSpan = allowSplit ? MaxClusterVertices : ~0u;
+	for(size_t s = 0; s < submeshes.size(); ++s)
+		SplitSubmesh(indices, submeshes[s], s, maxSpan, clusters);
+
+	bool use16Bit = true;
+	for(const Cluster& cluster : clusters)
+	{
+		if(cluster.MaxVertex - cluster.MinVertex + 1 > MaxClusterVertices)
+			use16Bit = false;
+	}
+
+	// A 32-bit buffer gains nothing from splitting, so keep submeshes whole.
+	if(!use16Bit && allowSplit)
+	{
+		clusters.clear();
+		for(size_t s = 0; s < submeshes.size(); ++s)
+			SplitSubmesh(indices, submeshes[s], s, ~0u, clusters);
+	}
+
+	//
+	// Emit the clusters back to back, each rebased against its lowest vertex.
+	//
+
+	PackedIndices packed;
+	packed.Use16Bit = use16Bit;
+	if(use16Bit)
+		packed.Indices16.reserve(indices.size());
+	else
+		packed.Indices32.reserve(indices.size());
+
+	std::vector<uint32> clusterNumber(submeshes.size(), 0);
+	std::vector<uint32> clusterCount(submeshes.size(), 0);
+	for(const Cluster& cluster : clusters)
+		clusterCount[cluster.Submesh]++;
+
+	uint32 nextIndex = 0;
+	for(const Cluster& cluster : clusters)
+	{
+		const Submesh& submesh = submeshes[cluster.Submesh];
+
+		PackedSubmesh range;
+		range.Name = submesh.Name;
+		if(clusterCount[cluster.Submesh] > 1)
+			range.Name += "_" + std::to_string(clusterNumber[cluster.Submesh]++);
+		range.IndexCount = cluster.IndexCount;
+		range.StartIndexLocation = nextIndex;
+		range.BaseVertexLocation = (int)cluster.MinVertex;
+		range.VertexSpan = cluster.MaxVertex - cluster.MinVertex + 1;
+
+		for(uint32 i = 0; i < cluster.IndexCount; ++i)
+		{
+			uint32 v = (uint32)(submesh.BaseVertexLocation + (int)indices[cluster.FirstIndex + i]) - cluster.MinVertex;
+			if(use16Bit)
+				packed.Indices16.push_back((uint16)v);
+			else
+				packed.Indices32.push_back(v);
+		}
+
+		nextIndex += cluster.IndexCount;
+		packed.Submeshes.push_back(range);
+	}
+
+	return packed;
+}
+
+IndexPacker::PackedIndices IndexPacker::Pack(const std::vector<uint32>& indices, const std::string& name, bool allowSplit)
+{
+	Submesh submesh;
+	submesh.Name = name;
+	submesh.IndexCount = (uint32)indices.size();
+
+	return Pack(indices, std::vector<Submesh>(1, submesh), allowSplit);
+}
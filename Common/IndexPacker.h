@@ -0,0 +1,78 @@
+//***************************************************************************************
+// IndexPacker.h
+//
+// Packs the index lists of the submeshes sharing one index buffer into the
+// smallest index format they allow.  Each submesh is rebased against its lowest
+// vertex, so BaseVertexLocation absorbs the offset and the local indices fit in
+// 16 bits whenever the submesh touches at most MaxClusterVertices vertices.
+// Larger submeshes are split into clusters that do fit.
+//
+// One index buffer view has one format, so 16-bit is chosen only when every
+// cluster of the buffer fits; otherwise everything falls back to 32-bit.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class IndexPacker
+{
+public:
+
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+
+	// Largest vertex span a 16-bit cluster may cover.  One short of 65536 so
+	// 0xffff, the strip cut value, never appears as an index.
+	static const uint32 MaxClusterVertices = 0xffff;
+
+	// One submesh of the source index list.  Vertex BaseVertexLocation + i is
+	// the one referenced by index i, as for SubmeshGeometry.
+	struct Submesh
+	{
+		std::string Name;
+		uint32 IndexCount = 0;
+		uint32 StartIndexLocation = 0;
+		int BaseVertexLocation = 0;
+	};
+
+	// One drawable range of the packed buffer.  A submesh that had to be split
+	// becomes Name_0, Name_1, ...; otherwise it keeps its own name.
+	struct PackedSubmesh
+	{
+		std::string Name;
+		uint32 IndexCount = 0;
+		uint32 StartIndexLocation = 0;
+		int BaseVertexLocation = 0;
+		uint32 VertexSpan = 0;      // highest minus lowest local index, plus one
+	};
+
+	struct PackedIndices
+	{
+		bool Use16Bit = false;
+		std::vector<uint16> Indices16;
+		std::vector<uint32> Indices32;
+		std::vector<PackedSubmesh> Submeshes;
+
+		uint32 IndexCount()const { return (uint32)(Use16Bit ? Indices16.size() : Indices32.size()); }
+		uint32 IndexSize()const { return Use16Bit ? sizeof(uint16) : sizeof(uint32); }
+		uint32 ByteSize()const { return IndexCount()*IndexSize(); }
+
+		const void* Data()const
+		{
+			return Use16Bit ? (const void*)Indices16.data() : (const void*)Indices32.data();
+		}
+	};
+
+	///<summary>
+	/// Packs the submeshes of indices into one new index list, 16-bit when it
+	/// fits.  With allowSplit false, submeshes are never split and a single
+	/// oversized one forces the whole buffer to 32-bit.
+	///</summary>
+	static PackedIndices Pack(const std::vector<uint32>& indices, const std::vector<Submesh>& submeshes, bool allowSplit = true);
+
+	// Convenience overload for a buffer holding a single submesh.
+	static PackedIndices Pack(const std::vector<uint32>& indices, const std::string& name, bool allowSplit = true);
+};
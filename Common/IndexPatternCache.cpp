@@ -0,0 +1,70 @@
+//***************************************************************************************
+// IndexPatternCache.cpp
+//***************************************************************************************
+
+#include "IndexPatternCache.h"
+#include "GeometryGenerator.h"
+#include <cassert>
+#include <cstring>
+
+using uint32 = IndexPatternCache::uint32;
+
+std::uint64_t IndexPatternCache::MakeKey(PatternKind kind, uint32 a, uint32 b, uint32 c, uint32 d)
+{
+	assert(a < (1u << 24) && b < (1u << 24) && c < (1u << 13) && d < 2);
+
+	return ((std::uint64_t)kind << 62) | ((std::uint64_t)a << 38) | ((std::uint64_t)b << 14)
+		| ((std::uint64_t)c << 1) | d;
+}
+
+IndexPatternCache::Region IndexPatternCache::Grid(uint32 m, uint32 n)
+{
+	return Find(MakeKey(PatternKind::Grid, m, n, 0, 0), [&](std::vector<uint32>& indices)
+	{
+		if(m < 2 || n < 2)
+			return;
+
+		size_t first = indices.size();
+		indices.resize(first + 6*(size_t)(m - 1)*(n - 1));
+		GeometryGenerator::WriteGridIndices(indices.data() + first, m, n);
+	});
+}
+
+size_t IndexPatternCache::IndexCount()const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mIndices.size();
+}
+
+uint32 IndexPatternCache::PatternCount()const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return (uint32)mRegions.size();
+}
+
+uint32 IndexPatternCache::MaxIndex()const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mMaxIndex;
+}
+
+void IndexPatternCache::CopyIndices(size_t first, size_t count, uint32* dst)const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	assert(first + count <= mIndices.size());
+	std::memcpy(dst, mIndices.data() + first, count*sizeof(uint32));
+}
+
+IndexPacker::PackedIndices IndexPatternCache::Pack()const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	IndexPacker::PackedIndices packed;
+	packed.Use16Bit = mMaxIndex < IndexPacker::MaxClusterVertices;
+	if(packed.Use16Bit)
+		packed.Indices16.assign(mIndices.begin(), mIndices.end());
+	else
+		packed.Indices32 = mIndices;
+
+	return packed;
+}
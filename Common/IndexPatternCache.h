@@ -0,0 +1,121 @@
+//***************************************************************************************
+// IndexPatternCache.h
+//
+// Index lists that depend only on a mesh's topology, built once and shared.  A
+// grid's indices are the same for every grid of that size, whatever its
+// positions, and likewise for terrain chunks at a given LOD and stitching.  The
+// cache keeps one copy of each pattern, back to back in a single index list.
+// Upload that list as one index buffer (Pack() and MeshGeometry::SetIndices)
+// and draw any number of patches that share a pattern from the same region of
+// it.  The cache belongs to whoever draws from it, e.g. TerrainStreamer, which
+// adds its own patterns through Find.
+//
+// Patterns are appended and never change or move, so a Region stays valid for
+// the cache's lifetime.  All members may be called from several threads.
+//***************************************************************************************
+
+#pragma once
+
+#include "IndexPacker.h"
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class IndexPatternCache
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	// Where a pattern lives in Indices().  Vertex indices start at 0 for every
+	// pattern; pass each patch's first vertex as BaseVertexLocation.
+	struct Region
+	{
+		uint32 StartIndexLocation = 0;
+		uint32 IndexCount = 0;
+	};
+
+	// Tells the users of one cache apart; the top two bits of every key.
+	enum class PatternKind : std::uint64_t
+	{
+		Grid = 1,
+		TerrainPatch = 2
+	};
+
+	///<summary>
+	/// Packs a pattern's parameters into a key: a and b below 2^24, c below
+	/// 2^13 and d below 2.
+	///</summary>
+	static std::uint64_t MakeKey(PatternKind kind, uint32 a, uint32 b, uint32 c, uint32 d);
+
+	///<summary>
+	/// The region of the pattern with key, first calling build(indices) to
+	/// append it if the cache doesn't hold it yet.
+	///</summary>
+	template<typename BuildFn>
+	Region Find(std::uint64_t key, const BuildFn& build);
+
+	///<summary>
+	/// The indices of GeometryGenerator::CreateGrid(width, depth, m, n).
+	///</summary>
+	Region Grid(uint32 m, uint32 n);
+
+	// Number of indices and patterns so far.  An index buffer holding the first
+	// IndexCount() indices serves every Region handed out until now.
+	size_t IndexCount()const;
+	uint32 PatternCount()const;
+
+	// Largest vertex index in any pattern, to choose between 16- and 32-bit
+	// index buffers.
+	uint32 MaxIndex()const;
+
+	///<summary>
+	/// Copies count indices starting at first, e.g. the ones added since the
+	/// last upload.
+	///</summary>
+	void CopyIndices(size_t first, size_t count, uint32* dst)const;
+
+	///<summary>
+	/// Every index so far, 16-bit when MaxIndex() allows, ready for
+	/// MeshGeometry::SetIndices.  No submeshes are named; draw the Regions.
+	///</summary>
+	IndexPacker::PackedIndices Pack()const;
+
+	///<summary>
+	/// The shared list itself.  Only safe while no other thread adds patterns.
+	///</summary>
+	const std::vector<uint32>& Indices()const { return mIndices; }
+
+private:
+	mutable std::mutex mMutex;
+	std::unordered_map<std::uint64_t, Region> mRegions;
+	std::vector<uint32> mIndices;
+	uint32 mMaxIndex = 0;
+};
+
+template<typename BuildFn>
+IndexPatternCache::Region IndexPatternCache::Find(std::uint64_t key, const BuildFn& build)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto it = mRegions.find(key);
+	if(it != mRegions.end())
+		return it->second;
+
+	// Patterns are small next to the vertex data that uses them, so building
+	// one under the lock is fine.
+	Region region;
+	region.StartIndexLocation = (uint32)mIndices.size();
+	build(mIndices);
+	region.IndexCount = (uint32)mIndices.size() - region.StartIndexLocation;
+
+	if(region.IndexCount > 0)
+	{
+		mMaxIndex = std::max(mMaxIndex, *std::max_element(mIndices.begin() + region.StartIndexLocation, mIndices.end()));
+	}
+
+	mRegions[key] = region;
+	return region;
+}
@@ -0,0 +1,119 @@
+//***************************************************************************************
+// LodSelector.cpp
+//***************************************************************************************
+
+#include "LodSelector.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace DirectX;
+
+namespace
+{
+	// Largest axis scale of the upper 3x3 of world, so non-uniform scaling never
+	// underestimates the error.
+	float MaxScale(FXMMATRIX world)
+	{
+		float sx = XMVectorGetX(XMVector3Length(world.r[0]));
+		float sy = XMVectorGetX(XMVector3Length(world.r[1]));
+		float sz = XMVectorGetX(XMVector3Length(world.r[2]));
+		return std::max(sx, std::max(sy, sz));
+	}
+}
+
+LodSelector::LodSet LodSelector::MakeLodSet(const MeshGeometry& geo, const std::string& name)
+{
+	LodSet set;
+
+	auto it = geo.DrawArgs.find(name);
+	if(it == geo.DrawArgs.end())
+		return set;
+
+	set.Levels.push_back(it->second);
+	set.Bounds = it->second.SphereBounds;
+
+	while((int)set.Levels.size() < MaxLevels)
+	{
+		it = geo.DrawArgs.find(name + "_lod" + std::to_string(set.Levels.size()));
+		if(it == geo.DrawArgs.end())
+			break;
+		set.Levels.push_back(it->second);
+	}
+
+	return set;
+}
+
+float LodSelector::ProjectionScale(const XMFLOAT4X4& proj, float renderTargetHeight)
+{
+	return 0.5f * renderTargetHeight * proj(1, 1);
+}
+
+float LodSelector::ProjectedError(const LodSet& set, int level,
+	FXMMATRIX world, CXMMATRIX view, float projectionScale)
+{
+	float error = set.Levels[level].GeometricError;
+	if(error <= 0.0f)
+		return 0.0f;
+
+	float scale = MaxScale(world);
+
+	XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&set.Bounds.Center), world * view);
+	float distance = XMVectorGetX(XMVector3Length(center)) - set.Bounds.Radius*scale;
+	if(distance <= 0.0f)
+		return std::numeric_limits<float>::infinity();
+
+	return error * scale * projectionScale / distance;
+}
+
+int LodSelector::SelectLevel(const LodSet& set, int currentLevel,
+	FXMMATRIX world, CXMMATRIX view, float projectionScale,
+	const Settings& settings)
+{
+	int levelCount = (int)set.Levels.size();
+	if(levelCount == 0)
+		return -1;
+
+	// No history: the coarsest level under the budget itself.
+	if(currentLevel < 0 || currentLevel >= levelCount)
+	{
+		int level = 0;
+		while(level + 1 < levelCount &&
+			ProjectedError(set, level + 1, world, view, projectionScale) <= settings.PixelError)
+			++level;
+		return level;
+	}
+
+	float refineAbove = settings.PixelError * (1.0f + settings.Hysteresis);
+	float coarsenBelow = settings.PixelError * (1.0f - settings.Hysteresis);
+
+	int level = currentLevel;
+	if(level > 0 && ProjectedError(set, level, world, view, projectionScale) > refineAbove)
+	{
+		do
+		{
+			--level;
+		} while(level > 0 && ProjectedError(set, level, world, view, projectionScale) > refineAbove);
+		return level;
+	}
+
+	while(level + 1 < levelCount &&
+		ProjectedError(set, level + 1, world, view, projectionScale) <= coarsenBelow)
+		++level;
+
+	return level;
+}
+
+void LodSelector::Record(const LodSet& set, int previousLevel, int level, Stats& stats)
+{
+	if(level < 0 || level >= (int)set.Levels.size())
+		return;
+
+	stats.Objects++;
+	if(previousLevel >= 0 && previousLevel != level)
+		stats.LevelChanges++;
+
+	stats.FullDetailTriangles += set.Levels[0].IndexCount / 3;
+	stats.SelectedTriangles += set.Levels[level].IndexCount / 3;
+	stats.ObjectsPerLevel[std::min(level, MaxLevels - 1)]++;
+}
@@ -0,0 +1,95 @@
+//***************************************************************************************
+// LodSelector.h
+//
+// Picks a level of detail per object and per frame from the screen-space size of
+// its simplification error.  A level whose GeometricError e (object space) is
+// seen at distance d through a projection with vertical scale Proj(1,1) covers
+//
+//   pixels = e * worldScale * 0.5 * RenderTargetHeight * Proj(1,1) / d
+//
+// on screen, and the coarsest level under the pixel budget is drawn.  d is taken
+// from the eye to the near side of the bounding sphere, so the estimate is
+// conservative over the whole object.
+//
+// Levels only switch once the error leaves a band around the budget: refine
+// above budget*(1 + Hysteresis), coarsen below budget*(1 - Hysteresis).  An
+// object sitting right at a threshold therefore does not flicker between levels.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include <cstdint>
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+class LodSelector
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	static const int MaxLevels = 8;
+
+	// The levels of one mesh, finest first, all in the same MeshGeometry.
+	struct LodSet
+	{
+		std::vector<SubmeshGeometry> Levels;
+		DirectX::BoundingSphere Bounds;     // object space, encloses every level
+	};
+
+	///<summary>
+	/// Gathers the submeshes name, name_lod1, name_lod2, ... of geo, stopping at
+	/// the first one missing, as MeshSimplifier levels are named.  The bounding
+	/// sphere is taken from the full-detail submesh.
+	///</summary>
+	static LodSet MakeLodSet(const MeshGeometry& geo, const std::string& name);
+
+	struct Settings
+	{
+		float PixelError = 1.0f;    // largest acceptable error on screen
+		float Hysteresis = 0.25f;   // relative half-width of the switching band
+	};
+
+	///<summary>
+	/// Pixels per object-space unit at view distance 1: the 0.5 *
+	/// RenderTargetHeight * Proj(1,1) factor shared by every object in a pass.
+	///</summary>
+	static float ProjectionScale(const DirectX::XMFLOAT4X4& proj, float renderTargetHeight);
+
+	///<summary>
+	/// Screen-space size, in pixels, of the error of level of set drawn with
+	/// world and seen through view.  Infinite when the eye is inside the
+	/// bounding sphere.
+	///</summary>
+	static float ProjectedError(const LodSet& set, int level,
+		DirectX::FXMMATRIX world, DirectX::CXMMATRIX view, float projectionScale);
+
+	///<summary>
+	/// The level of set to draw this frame.  currentLevel is the level drawn
+	/// last frame, or -1 if there was none; the result only differs from it when
+	/// the error has left the hysteresis band.
+	///</summary>
+	static int SelectLevel(const LodSet& set, int currentLevel,
+		DirectX::FXMMATRIX world, DirectX::CXMMATRIX view, float projectionScale,
+		const Settings& settings);
+
+	// Per-frame counters, reset with Reset() before selecting.
+	struct Stats
+	{
+		uint32 Objects = 0;
+		uint32 LevelChanges = 0;
+		uint32 FullDetailTriangles = 0;     // had every object drawn level 0
+		uint32 SelectedTriangles = 0;
+		uint32 ObjectsPerLevel[MaxLevels] = {};
+
+		void Reset() { *this = Stats(); }
+	};
+
+	///<summary>
+	/// Counts one selection into stats.
+	///</summary>
+	static void Record(const LodSet& set, int previousLevel, int level, Stats& stats);
+};
@@ -0,0 +1,141 @@
+//***************************************************************************************
+// MappedFile.cpp
+//***************************************************************************************
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+namespace
+{
+	// The view keeps the mapping, and the mapping the file, alive, so both
+	// handles are closed as soon as the view exists.
+	const std::uint8_t* MapWholeFile(HANDLE file, size_t& size)
+	{
+		if (file == INVALID_HANDLE_VALUE)
+			return nullptr;
+
+		const std::uint8_t* data = nullptr;
+
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 &&
+			(unsigned long long)fileSize.QuadPart <= (size_t)-1)
+		{
+			HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping != nullptr)
+			{
+				data = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				if (data != nullptr)
+					size = (size_t)fileSize.QuadPart;
+				CloseHandle(mapping);
+			}
+		}
+
+		CloseHandle(file);
+		return data;
+	}
+}
+
+bool MappedFile::Open(const std::wstring& filename)
+{
+	Close();
+
+	mData = MapWholeFile(CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr), mSize);
+
+	return mData != nullptr;
+}
+
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+	mData = MapWholeFile(CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr), mSize);
+
+	return mData != nullptr;
+}
+
+void MappedFile::Close()
+{
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+
+	mData = nullptr;
+	mSize = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) == 0 && info.st_size > 0)
+	{
+		void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data != MAP_FAILED)
+		{
+			// Consumers read front to back; let the kernel read ahead.
+			madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+			madvise(data, (size_t)info.st_size, MADV_WILLNEED);
+
+			mData = static_cast<const uint8*>(data);
+			mSize = (size_t)info.st_size;
+		}
+	}
+
+	close(file);
+	return mData != nullptr;
+}
+
+void MappedFile::Close()
+{
+	if (mData != nullptr)
+		munmap(const_cast<uint8*>(mData), mSize);
+
+	mData = nullptr;
+	mSize = 0;
+}
+
+#endif
+
+MappedFile::MappedFile(MappedFile&& other)
+	: mData(other.mData), mSize(other.mSize)
+{
+	other.mData = nullptr;
+	other.mSize = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+	if (this != &other)
+	{
+		Close();
+
+		mData = other.mData;
+		mSize = other.mSize;
+		other.mData = nullptr;
+		other.mSize = 0;
+	}
+
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
@@ -0,0 +1,51 @@
+//***************************************************************************************
+// MappedFile.h
+//
+// Read-only view of a whole file mapped into memory (MapViewOfFile on Windows,
+// mmap elsewhere).  Pages come straight from the OS file cache as they are
+// touched, so consumers that only copy the bytes onward, like texture uploads,
+// skip the heap buffer and the extra copy of a read.
+//
+// A read error on a mapped page faults instead of failing a call, which is
+// acceptable for local asset files; use a plain read for removable media.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class MappedFile
+{
+public:
+
+	using uint8 = std::uint8_t;
+
+	MappedFile() = default;
+	MappedFile(MappedFile&& other);
+	MappedFile& operator=(MappedFile&& other);
+	~MappedFile();
+
+	MappedFile(const MappedFile& rhs) = delete;
+	MappedFile& operator=(const MappedFile& rhs) = delete;
+
+	///<summary>
+	/// Maps filename, closing any file mapped before.  Returns false if it can't
+	/// be opened or is empty (an empty file can't be mapped).
+	///</summary>
+	bool Open(const std::string& filename);
+#ifdef _WIN32
+	bool Open(const std::wstring& filename);
+#endif
+
+	void Close();
+
+	bool IsOpen()const { return mData != nullptr; }
+	const uint8* Data()const { return mData; }
+	size_t Size()const { return mSize; }
+
+private:
+	const uint8* mData = nullptr;
+	size_t mSize = 0;
+};
@@ -0,0 +1,703 @@
+//***************************************************************************************
+// MeshBvh.cpp
+//***************************************************************************************
+
+#include "MeshBvh.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+using namespace DirectX;
+
+using uint32 = MeshBvh::uint32;
+
+static_assert(sizeof(MeshBvh::Node) == 32, "MeshBvh::Node should fill half a cache line");
+
+namespace
+{
+	const uint32 MaxBinCount = 64;
+
+	// Past this depth nodes are split at the median, which bounds the depth
+	// below MaxStackDepth however the SAH behaves.
+	const uint32 MaxSahDepth = 64;
+	const uint32 MaxStackDepth = 128;
+
+	// Ranges at least this large build their two halves in parallel.
+	const uint32 ParallelNodeSize = 16384;
+
+	// Triangles per ParallelFor task for the per-triangle passes.
+	const uint32 ChunkSize = 16384;
+
+	template<typename Fn>
+	void ForEachChunk(ThreadPool& pool, size_t count, const Fn& fn)
+	{
+		uint32 chunkCount = (uint32)((count + ChunkSize - 1) / ChunkSize);
+		if(chunkCount <= 1)
+		{
+			fn((size_t)0, count);
+			return;
+		}
+
+		pool.ParallelFor(chunkCount, [&](uint32 chunk)
+		{
+			size_t begin = (size_t)chunk * ChunkSize;
+			size_t end = begin + ChunkSize < count ? begin + ChunkSize : count;
+			fn(begin, end);
+		});
+	}
+
+	float HalfArea(FXMVECTOR lo, FXMVECTOR hi)
+	{
+		XMFLOAT3 e;
+		XMStoreFloat3(&e, XMVectorMax(hi - lo, XMVectorZero()));
+		return e.x*e.y + e.y*e.z + e.z*e.x;
+	}
+
+	struct Bin
+	{
+		XMVECTOR Min;
+		XMVECTOR Max;
+		uint32 Count;
+	};
+
+	// The bins of all three axes, about 10 KB.  Each build task allocates one
+	// set and reuses it for every node it builds, rather than putting it on the
+	// stack at every level of the recursion.
+	struct BinSet
+	{
+		Bin Bins[3][MaxBinCount];
+	};
+
+	struct BuildContext
+	{
+		const MeshBvh::Options* Options = nullptr;
+		ThreadPool* Pool = nullptr;
+
+		// Per source triangle.
+		std::vector<XMFLOAT3> BoxMins;
+		std::vector<XMFLOAT3> BoxMaxs;
+		std::vector<XMFLOAT3> Centroids;
+
+		// Source triangles, reordered into leaf order as the tree is built.
+		std::vector<uint32> Order;
+
+		MeshBvh::NodeArray* Nodes = nullptr;
+		std::atomic<uint32> NodeCount;
+	};
+
+	void MakeLeaf(MeshBvh::Node& node, uint32 begin, uint32 end)
+	{
+		node.Offset = begin;
+		node.Count = end - begin;
+	}
+
+	void BuildNode(BuildContext& context, BinSet& binSet, uint32 nodeIndex, uint32 begin, uint32 end, uint32 depth)
+	{
+		const MeshBvh::Options& options = *context.Options;
+		uint32* order = context.Order.data();
+		uint32 count = end - begin;
+
+		//
+		// Bounds of the triangles and of their centroids.
+		//
+
+		XMVECTOR lo = XMVectorReplicate(FLT_MAX);
+		XMVECTOR hi = XMVectorReplicate(-FLT_MAX);
+		XMVECTOR centroidLo = lo;
+		XMVECTOR centroidHi = hi;
+		for(uint32 i = begin; i < end; ++i)
+		{
+			uint32 t = order[i];
+			XMVECTOR c = XMLoadFloat3(&context.Centroids[t]);
+			lo = XMVectorMin(lo, XMLoadFloat3(&context.BoxMins[t]));
+			hi = XMVectorMax(hi, XMLoadFloat3(&context.BoxMaxs[t]));
+			centroidLo = XMVectorMin(centroidLo, c);
+			centroidHi = XMVectorMax(centroidHi, c);
+		}
+
+		MeshBvh::Node& node = (*context.Nodes)[nodeIndex];
+		XMStoreFloat3(&node.BoundsMin, lo);
+		XMStoreFloat3(&node.BoundsMax, hi);
+
+		if(count <= 1)
+		{
+			MakeLeaf(node, begin, end);
+			return;
+		}
+
+		//
+		// Bin the centroids along each axis and sweep the bin boundaries for the
+		// cheapest split.
+		//
+
+		// Small nodes have few distinct splits, so they get as many bins as they
+		// have triangles.
+		uint32 binCount = std::max(2u, std::min(std::min(options.BinCount, MaxBinCount), count));
+
+		XMFLOAT3 cLo, cExtent;
+		XMStoreFloat3(&cLo, centroidLo);
+		XMStoreFloat3(&cExtent, centroidHi - centroidLo);
+		const float lows[3] = { cLo.x, cLo.y, cLo.z };
+		const float extents[3] = { cExtent.x, cExtent.y, cExtent.z };
+
+		int bestAxis = -1;
+		uint32 bestSplit = 0;
+		float bestCost = FLT_MAX;
+
+		if(depth < MaxSahDepth)
+		{
+			// One pass fills the bins of all three axes.
+			auto& bins = binSet.Bins;
+			float scales[3];
+			for(int axis = 0; axis < 3; ++axis)
+			{
+				scales[axis] = extents[axis] > 0.0f ? binCount / extents[axis] : 0.0f;
+				for(uint32 b = 0; b < binCount; ++b)
+				{
+					bins[axis][b].Min = XMVectorReplicate(FLT_MAX);
+					bins[axis][b].Max = XMVectorReplicate(-FLT_MAX);
+					bins[axis][b].Count = 0;
+				}
+			}
+
+			for(uint32 i = begin; i < end; ++i)
+			{
+				uint32 t = order[i];
+				const float* c = &context.Centroids[t].x;
+				XMVECTOR boxMin = XMLoadFloat3(&context.BoxMins[t]);
+				XMVECTOR boxMax = XMLoadFloat3(&context.BoxMaxs[t]);
+
+				for(int axis = 0; axis < 3; ++axis)
+				{
+					Bin& bin = bins[axis][std::min(binCount - 1, (uint32)((c[axis] - lows[axis])*scales[axis]))];
+					bin.Min = XMVectorMin(bin.Min, boxMin);
+					bin.Max = XMVectorMax(bin.Max, boxMax);
+					bin.Count++;
+				}
+			}
+
+			for(int axis = 0; axis < 3; ++axis)
+			{
+				if(!(extents[axis] > 0.0f))
+					continue;
+
+				const Bin* axisBins = bins[axis];
+
+				// Right to left: area and count of everything above each boundary.
+				float rightAreas[MaxBinCount];
+				uint32 rightCounts[MaxBinCount];
+				XMVECTOR rLo = XMVectorReplicate(FLT_MAX);
+				XMVECTOR rHi = XMVectorReplicate(-FLT_MAX);
+				uint32 rCount = 0;
+				for(uint32 b = binCount - 1; b > 0; --b)
+				{
+					rLo = XMVectorMin(rLo, axisBins[b].Min);
+					rHi = XMVectorMax(rHi, axisBins[b].Max);
+					rCount += axisBins[b].Count;
+					rightAreas[b] = HalfArea(rLo, rHi);
+					rightCounts[b] = rCount;
+				}
+
+				XMVECTOR lLo = XMVectorReplicate(FLT_MAX);
+				XMVECTOR lHi = XMVectorReplicate(-FLT_MAX);
+				uint32 lCount = 0;
+				for(uint32 b = 1; b < binCount; ++b)
+				{
+					lLo = XMVectorMin(lLo, axisBins[b - 1].Min);
+					lHi = XMVectorMax(lHi, axisBins[b - 1].Max);
+					lCount += axisBins[b - 1].Count;
+
+					if(lCount == 0 || rightCounts[b] == 0)
+						continue;
+
+					float cost = HalfArea(lLo, lHi)*lCount + rightAreas[b]*rightCounts[b];
+					if(cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestSplit = b;
+					}
+				}
+			}
+		}
+
+		//
+		// Leaf, SAH split or median split.
+		//
+
+		float area = HalfArea(lo, hi);
+		float splitCost = bestAxis >= 0 && area > 0.0f ? options.TraversalCost + bestCost/area : FLT_MAX;
+
+		if(count <= options.MaxLeafTriangles && (float)count <= splitCost)
+		{
+			MakeLeaf(node, begin, end);
+			return;
+		}
+
+		uint32 mid = begin;
+		if(bestAxis >= 0)
+		{
+			int axis = bestAxis;
+			float low = lows[axis];
+			float scale = binCount / extents[axis];
+			mid = (uint32)(std::partition(order + begin, order + end, [&](uint32 t)
+			{
+				const float* c = &context.Centroids[t].x;
+				return std::min(binCount - 1, (uint32)((c[axis] - low)*scale)) < bestSplit;
+			}) - order);
+		}
+
+		if(mid == begin || mid == end)
+		{
+			// Every centroid in one place (or past MaxSahDepth): halve the range
+			// along the widest axis.
+			int axis = extents[0] >= extents[1] && extents[0] >= extents[2] ? 0 : (extents[1] >= extents[2] ? 1 : 2);
+			mid = begin + count/2;
+			std::nth_element(order + begin, order + mid, order + end, [&](uint32 a, uint32 b)
+			{
+				return (&context.Centroids[a].x)[axis] < (&context.Centroids[b].x)[axis];
+			});
+		}
+
+		// Pairs are handed out from an even index, so siblings share a line.
+		uint32 child = context.NodeCount.fetch_add(2);
+		assert(child % 2 == 0);
+		node.Offset = child;
+		node.Count = 0;
+
+		if(count >= ParallelNodeSize)
+		{
+			context.Pool->ParallelFor(2, [&](uint32 side)
+			{
+				if(side == 0)
+					BuildNode(context, binSet, child, begin, mid, depth + 1);
+				else
+				{
+					auto sideBins = std::make_unique<BinSet>();
+					BuildNode(context, *sideBins, child + 1, mid, end, depth + 1);
+				}
+			});
+		}
+		else
+		{
+			BuildNode(context, binSet, child, begin, mid, depth + 1);
+			BuildNode(context, binSet, child + 1, mid, end, depth + 1);
+		}
+	}
+
+	// Entry and exit distance of the ray through the node's box, clipped to
+	// [0, maxT].  invDir holds 1/direction per component.
+	inline bool XM_CALLCONV RayBox(FXMVECTOR origin, FXMVECTOR invDir, const MeshBvh::Node& node, float maxT, float& entry)
+	{
+		XMVECTOR t0 = (XMLoadFloat3(&node.BoundsMin) - origin)*invDir;
+		XMVECTOR t1 = (XMLoadFloat3(&node.BoundsMax) - origin)*invDir;
+
+		XMFLOAT3 tNear, tFar;
+		XMStoreFloat3(&tNear, XMVectorMin(t0, t1));
+		XMStoreFloat3(&tFar, XMVectorMax(t0, t1));
+
+		entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxT));
+		return entry <= exit;
+	}
+
+	// Moller-Trumbore.  Both sides count as hits.
+	inline bool XM_CALLCONV RayTriangle(FXMVECTOR origin, FXMVECTOR direction, const XMFLOAT3* corners,
+		float maxT, float& t, float& u, float& v)
+	{
+		XMVECTOR v0 = XMLoadFloat3(&corners[0]);
+		XMVECTOR e1 = XMLoadFloat3(&corners[1]) - v0;
+		XMVECTOR e2 = XMLoadFloat3(&corners[2]) - v0;
+
+		XMVECTOR p = XMVector3Cross(direction, e2);
+		float det = XMVectorGetX(XMVector3Dot(e1, p));
+		if(det == 0.0f)
+			return false;
+
+		float invDet = 1.0f / det;
+		XMVECTOR s = origin - v0;
+		u = XMVectorGetX(XMVector3Dot(s, p))*invDet;
+		if(u < 0.0f || u > 1.0f)
+			return false;
+
+		XMVECTOR q = XMVector3Cross(s, e1);
+		v = XMVectorGetX(XMVector3Dot(direction, q))*invDet;
+		if(v < 0.0f || u + v > 1.0f)
+			return false;
+
+		t = XMVectorGetX(XMVector3Dot(e2, q))*invDet;
+		return t >= 0.0f && t <= maxT;
+	}
+
+	// Closest point to p on triangle (a, b, c), by the Voronoi region p falls in
+	// (Ericson, Real-Time Collision Detection 5.1.5).
+	XMVECTOR XM_CALLCONV ClosestPointOnTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c)
+	{
+		XMVECTOR ab = b - a;
+		XMVECTOR ac = c - a;
+		XMVECTOR ap = p - a;
+		float d1 = XMVectorGetX(XMVector3Dot(ab, ap));
+		float d2 = XMVectorGetX(XMVector3Dot(ac, ap));
+		if(d1 <= 0.0f && d2 <= 0.0f)
+			return a;
+
+		XMVECTOR bp = p - b;
+		float d3 = XMVectorGetX(XMVector3Dot(ab, bp));
+		float d4 = XMVectorGetX(XMVector3Dot(ac, bp));
+		if(d3 >= 0.0f && d4 <= d3)
+			return b;
+
+		float vc = d1*d4 - d3*d2;
+		if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			return a + ab*(d1 / (d1 - d3));
+
+		XMVECTOR cp = p - c;
+		float d5 = XMVectorGetX(XMVector3Dot(ab, cp));
+		float d6 = XMVectorGetX(XMVector3Dot(ac, cp));
+		if(d6 >= 0.0f && d5 <= d6)
+			return c;
+
+		float vb = d5*d2 - d1*d6;
+		if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			return a + ac*(d2 / (d2 - d6));
+
+		float va = d3*d6 - d5*d4;
+		if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+			return b + (c - b)*((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		float denom = 1.0f / (va + vb + vc);
+		return a + ab*(vb*denom) + ac*(vc*denom);
+	}
+
+	inline float XM_CALLCONV BoxDistanceSq(FXMVECTOR p, const MeshBvh::Node& node)
+	{
+		XMVECTOR d = XMVectorMax(XMLoadFloat3(&node.BoundsMin) - p, p - XMLoadFloat3(&node.BoundsMax));
+		d = XMVectorMax(d, XMVectorZero());
+		return XMVectorGetX(XMVector3LengthSq(d));
+	}
+
+	// Node to visit and the distance (ray) or squared distance (point) at which
+	// it was reached, to skip it if a closer hit turned up meanwhile.
+	struct StackEntry
+	{
+		uint32 Node;
+		float Key;
+	};
+
+	bool TraceRay(const MeshBvh::NodeArray& nodes, const std::vector<XMFLOAT3>& corners,
+		const std::vector<uint32>& triangles, FXMVECTOR origin, FXMVECTOR direction,
+		float maxDistance, bool anyHit, MeshBvh::RayHit& hit)
+	{
+		if(nodes.empty())
+			return false;
+
+		XMVECTOR invDir = XMVectorReciprocal(direction);
+
+		float best = maxDistance;
+		bool found = false;
+
+		float entry;
+		if(!RayBox(origin, invDir, nodes[0], best, entry))
+			return false;
+
+		StackEntry stack[MaxStackDepth];
+		uint32 top = 0;
+		stack[top++] = { 0, entry };
+
+		while(top > 0)
+		{
+			StackEntry current = stack[--top];
+			if(current.Key > best)
+				continue;
+
+			const MeshBvh::Node& node = nodes[current.Node];
+			if(node.IsLeaf())
+			{
+				for(uint32 i = node.Offset; i < node.Offset + node.Count; ++i)
+				{
+					float t, u, v;
+					if(RayTriangle(origin, direction, &corners[3*i], best, t, u, v))
+					{
+						best = t;
+						found = true;
+						hit.Distance = t;
+						hit.Triangle = triangles[i];
+						hit.U = u;
+						hit.V = v;
+
+						if(anyHit)
+							return true;
+					}
+				}
+				continue;
+			}
+
+			// Push the far child first so the near one is searched first.
+			float entry0, entry1;
+			bool hit0 = RayBox(origin, invDir, nodes[node.Offset], best, entry0);
+			bool hit1 = RayBox(origin, invDir, nodes[node.Offset + 1], best, entry1);
+
+			if(hit0 && hit1)
+			{
+				bool nearFirst = entry0 <= entry1;
+				stack[top++] = nearFirst ? StackEntry{ node.Offset + 1, entry1 } : StackEntry{ node.Offset, entry0 };
+				stack[top++] = nearFirst ? StackEntry{ node.Offset, entry0 } : StackEntry{ node.Offset + 1, entry1 };
+			}
+			else if(hit0)
+				stack[top++] = { node.Offset, entry0 };
+			else if(hit1)
+				stack[top++] = { node.Offset + 1, entry1 };
+
+			assert(top < MaxStackDepth);
+		}
+
+		return found;
+	}
+}
+
+void MeshBvh::Build(const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+	const uint32* indices, size_t indexCount, const Options& options)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	uint32 triangleCount = (uint32)(indexCount / 3);
+	const char* positionBytes = reinterpret_cast<const char*>(positions);
+	auto position = [&](uint32 index) -> const XMFLOAT3&
+	{
+		assert(index < vertexCount);
+		return *reinterpret_cast<const XMFLOAT3*>(positionBytes + index*positionStride);
+	};
+
+	mNodes.clear();
+	mCorners.clear();
+	mTriangles.clear();
+	mStats = Stats();
+
+	if(triangleCount == 0)
+		return;
+
+	ThreadPool& pool = ThreadPool::Default();
+
+	BuildContext context;
+	context.Options = &options;
+	context.Pool = &pool;
+	context.BoxMins.resize(triangleCount);
+	context.BoxMaxs.resize(triangleCount);
+	context.Centroids.resize(triangleCount);
+	context.Order.resize(triangleCount);
+	context.Nodes = &mNodes;
+	context.NodeCount = 2;
+
+	ForEachChunk(pool, triangleCount, [&](size_t begin, size_t end)
+	{
+		for(size_t t = begin; t < end; ++t)
+		{
+			XMVECTOR v0 = XMLoadFloat3(&position(indices[3*t + 0]));
+			XMVECTOR v1 = XMLoadFloat3(&position(indices[3*t + 1]));
+			XMVECTOR v2 = XMLoadFloat3(&position(indices[3*t + 2]));
+
+			XMVECTOR lo = XMVectorMin(XMVectorMin(v0, v1), v2);
+			XMVECTOR hi = XMVectorMax(XMVectorMax(v0, v1), v2);
+			XMStoreFloat3(&context.BoxMins[t], lo);
+			XMStoreFloat3(&context.BoxMaxs[t], hi);
+			XMStoreFloat3(&context.Centroids[t], 0.5f*(lo + hi));
+			context.Order[t] = (uint32)t;
+		}
+	});
+
+	// A binary tree with at least one triangle per leaf has at most 2n-1 nodes,
+	// plus the padding node.
+	mNodes.resize(2*(size_t)triangleCount);
+
+	auto bins = std::make_unique<BinSet>();
+	BuildNode(context, *bins, 0, 0, triangleCount, 0);
+	mNodes.resize(context.NodeCount);
+
+	//
+	// Copy the corners into leaf order so a leaf's triangles are contiguous.
+	//
+
+	mCorners.resize(3*(size_t)triangleCount);
+	mTriangles.swap(context.Order);
+
+	ForEachChunk(pool, triangleCount, [&](size_t begin, size_t end)
+	{
+		for(size_t i = begin; i < end; ++i)
+		{
+			uint32 t = mTriangles[i];
+			for(int k = 0; k < 3; ++k)
+				mCorners[3*i + k] = position(indices[3*t + k]);
+		}
+	});
+
+	//
+	// Stats.
+	//
+
+	mStats.TriangleCount = triangleCount;
+	mStats.NodeCount = (uint32)mNodes.size() - 1;
+
+	std::vector<std::pair<uint32, uint32>> stack;
+	stack.emplace_back(0, 1);
+	while(!stack.empty())
+	{
+		uint32 nodeIndex = stack.back().first;
+		uint32 depth = stack.back().second;
+		stack.pop_back();
+
+		const Node& node = mNodes[nodeIndex];
+		mStats.MaxDepth = std::max(mStats.MaxDepth, depth);
+		if(node.IsLeaf())
+		{
+			mStats.LeafCount++;
+			mStats.MaxLeafTriangles = std::max(mStats.MaxLeafTriangles, node.Count);
+		}
+		else
+		{
+			stack.emplace_back(node.Offset, depth + 1);
+			stack.emplace_back(node.Offset + 1, depth + 1);
+		}
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	mStats.BuildMilliseconds = elapsed.count();
+}
+
+void MeshBvh::Build(const GeometryGenerator::MeshData& meshData, const Options& options)
+{
+	const XMFLOAT3* positions = meshData.Vertices.empty() ? nullptr : &meshData.Vertices[0].Position;
+	Build(positions, sizeof(GeometryGenerator::Vertex), meshData.Vertices.size(),
+		meshData.Indices32.data(), meshData.Indices32.size(), options);
+}
+
+void MeshBvh::Build(const GeometryGenerator::MeshDataSoA& meshData, const Options& options)
+{
+	Build(meshData.Positions.data(), sizeof(XMFLOAT3), meshData.VertexCount(),
+		meshData.Indices32.data(), meshData.Indices32.size(), options);
+}
+
+bool MeshBvh::IntersectRay(FXMVECTOR origin, FXMVECTOR direction, float maxDistance, RayHit& hit)const
+{
+	return TraceRay(mNodes, mCorners, mTriangles, origin, direction, maxDistance, false, hit);
+}
+
+bool MeshBvh::AnyHit(FXMVECTOR origin, FXMVECTOR direction, float maxDistance)const
+{
+	RayHit hit;
+	return TraceRay(mNodes, mCorners, mTriangles, origin, direction, maxDistance, true, hit);
+}
+
+bool MeshBvh::ClosestPoint(FXMVECTOR point, float maxDistance, PointHit& hit)const
+{
+	if(mNodes.empty())
+		return false;
+
+	float best = maxDistance*maxDistance;
+	bool found = false;
+
+	StackEntry stack[MaxStackDepth];
+	uint32 top = 0;
+	stack[top++] = { 0, BoxDistanceSq(point, mNodes[0]) };
+
+	while(top > 0)
+	{
+		StackEntry current = stack[--top];
+		if(current.Key > best)
+			continue;
+
+		const Node& node = mNodes[current.Node];
+		if(node.IsLeaf())
+		{
+			for(uint32 i = node.Offset; i < node.Offset + node.Count; ++i)
+			{
+				const XMFLOAT3* corners = &mCorners[3*i];
+				XMVECTOR q = ClosestPointOnTriangle(point, XMLoadFloat3(&corners[0]),
+					XMLoadFloat3(&corners[1]), XMLoadFloat3(&corners[2]));
+
+				float distanceSq = XMVectorGetX(XMVector3LengthSq(q - point));
+				if(distanceSq <= best)
+				{
+					best = distanceSq;
+					found = true;
+					XMStoreFloat3(&hit.Point, q);
+					hit.DistanceSq = distanceSq;
+					hit.Triangle = mTriangles[i];
+				}
+			}
+			continue;
+		}
+
+		float d0 = BoxDistanceSq(point, mNodes[node.Offset]);
+		float d1 = BoxDistanceSq(point, mNodes[node.Offset + 1]);
+
+		// Nearer child on top.
+		if(d0 <= d1)
+		{
+			if(d1 <= best) stack[top++] = { node.Offset + 1, d1 };
+			if(d0 <= best) stack[top++] = { node.Offset, d0 };
+		}
+		else
+		{
+			if(d0 <= best) stack[top++] = { node.Offset, d0 };
+			if(d1 <= best) stack[top++] = { node.Offset + 1, d1 };
+		}
+
+		assert(top < MaxStackDepth);
+	}
+
+	return found;
+}
+
+void MeshBvh::OverlapBox(const BoundingBox& box, std::vector<uint32>& triangles)const
+{
+	if(mNodes.empty())
+		return;
+
+	XMVECTOR center = XMLoadFloat3(&box.Center);
+	XMVECTOR extents = XMLoadFloat3(&box.Extents);
+	XMVECTOR lo = center - extents;
+	XMVECTOR hi = center + extents;
+
+	uint32 stack[MaxStackDepth];
+	uint32 top = 0;
+	stack[top++] = 0;
+
+	while(top > 0)
+	{
+		const Node& node = mNodes[stack[--top]];
+
+		// Boxes overlap unless separated along some axis.
+		XMVECTOR separated = XMVectorOrInt(XMVectorGreater(XMLoadFloat3(&node.BoundsMin), hi),
+			XMVectorLess(XMLoadFloat3(&node.BoundsMax), lo));
+		if(!XMVector3EqualInt(separated, XMVectorFalseInt()))
+			continue;
+
+		if(node.IsLeaf())
+		{
+			for(uint32 i = node.Offset; i < node.Offset + node.Count; ++i)
+			{
+				const XMFLOAT3* corners = &mCorners[3*i];
+				if(box.Intersects(XMLoadFloat3(&corners[0]), XMLoadFloat3(&corners[1]), XMLoadFloat3(&corners[2])))
+					triangles.push_back(mTriangles[i]);
+			}
+		}
+		else
+		{
+			stack[top++] = node.Offset;
+			stack[top++] = node.Offset + 1;
+			assert(top < MaxStackDepth);
+		}
+	}
+}
+
+BoundingBox MeshBvh::Bounds()const
+{
+	BoundingBox bounds(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+	if(!mNodes.empty())
+		BoundingBox::CreateFromPoints(bounds, XMLoadFloat3(&mNodes[0].BoundsMin), XMLoadFloat3(&mNodes[0].BoundsMax));
+	return bounds;
+}
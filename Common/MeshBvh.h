@@ -0,0 +1,160 @@
+//***************************************************************************************
+// MeshBvh.h
+//
+// Bounding volume hierarchy over the triangles of a mesh, for CPU picking and
+// collision queries that would otherwise loop over every triangle.
+//
+// The tree is built top-down with the surface area heuristic evaluated over a
+// fixed number of bins per axis, the two halves of large nodes being built in
+// parallel on ThreadPool::Default().  Nodes are 32 bytes and live in one flat,
+// 64-byte aligned array.  Children come in pairs starting at an even index
+// (node 1 is padding), so visiting both touches a single 64-byte line.  The
+// BVH keeps its own copy of the triangle corners in
+// leaf order and reports hits by the triangle's index in the source index list,
+// so the mesh may be freed once the tree is built.
+//***************************************************************************************
+
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <cfloat>
+#include <cstdint>
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+#include <new>
+#include <vector>
+
+class MeshBvh
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	///<summary>
+	/// Allocates on 64-byte boundaries, so every even-indexed node starts a
+	/// cache line.
+	///</summary>
+	template<typename T>
+	struct CacheLineAllocator
+	{
+		using value_type = T;
+
+		static const size_t Alignment = 64;
+
+		CacheLineAllocator() = default;
+		template<typename U>
+		CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+		T* allocate(size_t n)
+		{
+			return static_cast<T*>(::operator new(n*sizeof(T), std::align_val_t(Alignment)));
+		}
+
+		void deallocate(T* p, size_t)
+		{
+			::operator delete(p, std::align_val_t(Alignment));
+		}
+
+		template<typename U>
+		bool operator==(const CacheLineAllocator<U>&)const { return true; }
+		template<typename U>
+		bool operator!=(const CacheLineAllocator<U>&)const { return false; }
+	};
+
+	struct Node
+	{
+		DirectX::XMFLOAT3 BoundsMin;
+		uint32 Offset = 0;      // leaf: first triangle slot; interior: first of the two children
+		DirectX::XMFLOAT3 BoundsMax;
+		uint32 Count = 0;       // triangles in the leaf, 0 for interior nodes
+
+		bool IsLeaf()const { return Count != 0; }
+	};
+
+	using NodeArray = std::vector<Node, CacheLineAllocator<Node>>;
+
+	struct Options
+	{
+		uint32 BinCount = 16;           // SAH candidates per axis, at most 64
+		uint32 MaxLeafTriangles = 8;    // nodes above this are always split
+
+		// Cost of visiting a node relative to testing one triangle.
+		float TraversalCost = 1.0f;
+	};
+
+	struct RayHit
+	{
+		float Distance = FLT_MAX;
+		uint32 Triangle = ~0u;          // index into the source list, 3*Triangle is its first index
+
+		// Barycentric coordinates of the hit: P = (1-U-V)*V0 + U*V1 + V*V2.
+		float U = 0.0f;
+		float V = 0.0f;
+	};
+
+	struct PointHit
+	{
+		DirectX::XMFLOAT3 Point = { 0.0f, 0.0f, 0.0f };
+		float DistanceSq = FLT_MAX;
+		uint32 Triangle = ~0u;
+	};
+
+	struct Stats
+	{
+		uint32 TriangleCount = 0;
+		uint32 NodeCount = 0;           // without the padding node
+		uint32 LeafCount = 0;
+		uint32 MaxDepth = 0;
+		uint32 MaxLeafTriangles = 0;
+		double BuildMilliseconds = 0.0;
+	};
+
+	///<summary>
+	/// Builds the tree over the indexCount/3 triangles of the list.  positions
+	/// points at the first position; consecutive positions are positionStride
+	/// bytes apart.  Replaces any previous tree.
+	///</summary>
+	void Build(const DirectX::XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+		const uint32* indices, size_t indexCount, const Options& options);
+
+	void Build(const GeometryGenerator::MeshData& meshData, const Options& options);
+	void Build(const GeometryGenerator::MeshDataSoA& meshData, const Options& options);
+
+	///<summary>
+	/// Nearest triangle hit by the ray origin + t*direction for t in [0,
+	/// maxDistance].  direction need not be normalized; Distance is in units of
+	/// its length.  Both sides of a triangle are hit.
+	///</summary>
+	bool IntersectRay(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance, RayHit& hit)const;
+
+	///<summary>
+	/// Whether any triangle is hit for t in [0, maxDistance], e.g. for line of
+	/// sight.  Stops at the first hit found.
+	///</summary>
+	bool AnyHit(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance)const;
+
+	///<summary>
+	/// Point of the mesh nearest to point, searching no farther than
+	/// maxDistance.  Returns false if no triangle is that close.
+	///</summary>
+	bool ClosestPoint(DirectX::FXMVECTOR point, float maxDistance, PointHit& hit)const;
+
+	///<summary>
+	/// Appends the source index of every triangle that intersects box.
+	///</summary>
+	void OverlapBox(const DirectX::BoundingBox& box, std::vector<uint32>& triangles)const;
+
+	// Bounds of the whole mesh.
+	DirectX::BoundingBox Bounds()const;
+
+	const NodeArray& Nodes()const { return mNodes; }
+	const Stats& GetStats()const { return mStats; }
+
+private:
+	// Leaf triangle slot -> corner positions, and source triangle index.
+	std::vector<DirectX::XMFLOAT3> mCorners;
+	std::vector<uint32> mTriangles;
+
+	NodeArray mNodes;
+	Stats mStats;
+};
@@ -0,0 +1,211 @@
+//***************************************************************************************
+// MeshCache.cpp
+//***************************************************************************************
+
+#include "MeshCache.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using uint32 = MeshCache::uint32;
+using uint64 = MeshCache::uint64;
+
+namespace
+{
+	uint64 AlignUp(uint64 value, uint64 alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	const uint64 FnvOffsetBasis = 14695981039346656037ull;
+	const uint64 FnvPrime = 1099511628211ull;
+
+	uint64 HashBytes(uint64 hash, const unsigned char* bytes, size_t byteSize)
+	{
+		for(size_t i = 0; i < byteSize; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= FnvPrime;
+		}
+
+		return hash;
+	}
+
+	uint32 ReadIndex(const MeshCache::Mesh& mesh, uint32 i)
+	{
+		if(mesh.IndexSize == 2)
+		{
+			std::uint16_t index;
+			std::memcpy(&index, mesh.IndexData.data() + 2*(size_t)i, sizeof(index));
+			return index;
+		}
+
+		uint32 index;
+		std::memcpy(&index, mesh.IndexData.data() + 4*(size_t)i, sizeof(index));
+		return index;
+	}
+}
+
+uint64 MeshCache::Hash(const void* data, size_t byteSize)
+{
+	return HashBytes(FnvOffsetBasis, static_cast<const unsigned char*>(data), byteSize);
+}
+
+bool MeshCache::HashFile(const std::string& filename, uint64& hash)
+{
+	std::ifstream fin(filename, std::ios::binary);
+	if(!fin)
+		return false;
+
+	hash = FnvOffsetBasis;
+
+	std::vector<char> buffer(1 << 16);
+	while(fin)
+	{
+		fin.read(buffer.data(), buffer.size());
+		hash = HashBytes(hash, reinterpret_cast<const unsigned char*>(buffer.data()), (size_t)fin.gcount());
+	}
+
+	return fin.eof();
+}
+
+bool MeshCache::Load(const std::string& filename, Mesh& mesh)
+{
+	std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+	if(!fin)
+		return false;
+
+	std::streamoff fileSize = fin.tellg();
+	if(fileSize < (std::streamoff)sizeof(FileHeader))
+		return false;
+
+	std::vector<char> file((size_t)fileSize);
+	fin.seekg(0, std::ios::beg);
+	if(!fin.read(file.data(), file.size()))
+		return false;
+
+	FileHeader header;
+	std::memcpy(&header, file.data(), sizeof(header));
+
+	if(header.Magic != Magic || header.FormatVersion != FormatVersion || header.FileSize != (uint64)fileSize)
+		return false;
+	if(header.IndexSize != 2 && header.IndexSize != 4)
+		return false;
+	if(header.VertexStride == 0 && header.VertexCount != 0)
+		return false;
+
+	uint64 vertexBytes = (uint64)header.VertexCount*header.VertexStride;
+	uint64 indexBytes = (uint64)header.IndexCount*header.IndexSize;
+	uint64 submeshEnd = sizeof(FileHeader) + (uint64)header.SubmeshCount*sizeof(FileSubmesh);
+	if(submeshEnd > header.VertexDataOffset ||
+	   header.VertexDataOffset + vertexBytes > header.IndexDataOffset ||
+	   header.IndexDataOffset + indexBytes > header.FileSize)
+		return false;
+
+	mesh.SourceHash = header.SourceHash;
+	mesh.ContentVersion = header.ContentVersion;
+	mesh.VertexStride = header.VertexStride;
+	mesh.IndexSize = header.IndexSize;
+	mesh.BoundsMin = header.BoundsMin;
+	mesh.BoundsMax = header.BoundsMax;
+
+	mesh.Submeshes.resize(header.SubmeshCount);
+	for(uint32 i = 0; i < header.SubmeshCount; ++i)
+	{
+		FileSubmesh fileSubmesh;
+		std::memcpy(&fileSubmesh, file.data() + sizeof(FileHeader) + i*sizeof(FileSubmesh), sizeof(FileSubmesh));
+
+		Submesh& submesh = mesh.Submeshes[i];
+		submesh.Name.assign(fileSubmesh.Name, strnlen(fileSubmesh.Name, sizeof(fileSubmesh.Name)));
+		submesh.IndexCount = fileSubmesh.IndexCount;
+		submesh.StartIndexLocation = fileSubmesh.StartIndexLocation;
+		submesh.BaseVertexLocation = fileSubmesh.BaseVertexLocation;
+		submesh.BoundsMin = fileSubmesh.BoundsMin;
+		submesh.BoundsMax = fileSubmesh.BoundsMax;
+		submesh.GeometricError = fileSubmesh.GeometricError;
+	}
+
+	const char* vertexData = file.data() + header.VertexDataOffset;
+	const char* indexData = file.data() + header.IndexDataOffset;
+	mesh.VertexData.assign(vertexData, vertexData + vertexBytes);
+	mesh.IndexData.assign(indexData, indexData + indexBytes);
+
+	// Callers index straight into the blobs with these, so a stale or corrupt
+	// file must fail here rather than read out of bounds later.
+	for(uint32 i = 0; i < header.IndexCount; ++i)
+	{
+		if(ReadIndex(mesh, i) >= header.VertexCount)
+			return false;
+	}
+
+	for(const Submesh& submesh : mesh.Submeshes)
+	{
+		if((uint64)submesh.StartIndexLocation + submesh.IndexCount > header.IndexCount)
+			return false;
+
+		for(uint32 i = 0; i < submesh.IndexCount; ++i)
+		{
+			std::int64_t vertex = (std::int64_t)ReadIndex(mesh, submesh.StartIndexLocation + i) + submesh.BaseVertexLocation;
+			if(vertex < 0 || vertex >= header.VertexCount)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool MeshCache::Save(const std::string& filename, const Mesh& mesh)
+{
+	if(mesh.VertexStride == 0 || (mesh.IndexSize != 2 && mesh.IndexSize != 4))
+		return false;
+
+	FileHeader header = {};
+	header.Magic = Magic;
+	header.FormatVersion = FormatVersion;
+	header.SourceHash = mesh.SourceHash;
+	header.ContentVersion = mesh.ContentVersion;
+	header.VertexStride = mesh.VertexStride;
+	header.VertexCount = mesh.VertexCount();
+	header.IndexSize = mesh.IndexSize;
+	header.IndexCount = mesh.IndexCount();
+	header.SubmeshCount = (uint32)mesh.Submeshes.size();
+	header.BoundsMin = mesh.BoundsMin;
+	header.BoundsMax = mesh.BoundsMax;
+
+	uint64 submeshEnd = sizeof(FileHeader) + mesh.Submeshes.size()*sizeof(FileSubmesh);
+	header.VertexDataOffset = AlignUp(submeshEnd, BlobAlignment);
+	header.IndexDataOffset = AlignUp(header.VertexDataOffset + mesh.VertexData.size(), BlobAlignment);
+	header.FileSize = header.IndexDataOffset + mesh.IndexData.size();
+
+	// Assemble the file in memory so it goes out in one write.
+	std::vector<char> file((size_t)header.FileSize, 0);
+	std::memcpy(file.data(), &header, sizeof(header));
+
+	for(size_t i = 0; i < mesh.Submeshes.size(); ++i)
+	{
+		const Submesh& submesh = mesh.Submeshes[i];
+
+		FileSubmesh fileSubmesh = {};
+		std::memcpy(fileSubmesh.Name, submesh.Name.data(), std::min(submesh.Name.size(), sizeof(fileSubmesh.Name) - 1));
+		fileSubmesh.IndexCount = submesh.IndexCount;
+		fileSubmesh.StartIndexLocation = submesh.StartIndexLocation;
+		fileSubmesh.BaseVertexLocation = submesh.BaseVertexLocation;
+		fileSubmesh.BoundsMin = submesh.BoundsMin;
+		fileSubmesh.BoundsMax = submesh.BoundsMax;
+		fileSubmesh.GeometricError = submesh.GeometricError;
+
+		std::memcpy(file.data() + sizeof(FileHeader) + i*sizeof(FileSubmesh), &fileSubmesh, sizeof(fileSubmesh));
+	}
+
+	if(!mesh.VertexData.empty())
+		std::memcpy(file.data() + header.VertexDataOffset, mesh.VertexData.data(), mesh.VertexData.size());
+	if(!mesh.IndexData.empty())
+		std::memcpy(file.data() + header.IndexDataOffset, mesh.IndexData.data(), mesh.IndexData.size());
+
+	std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+	if(!fout)
+		return false;
+
+	fout.write(file.data(), file.size());
+	return (bool)fout;
+}
@@ -0,0 +1,114 @@
+//***************************************************************************************
+// MeshCache.h
+//
+// Versioned binary container for processed meshes, so a model parsed from text
+// (Models/*.txt) once can be loaded with a single read on later runs.
+//
+// File layout (little endian, every blob starts on a 16 byte boundary):
+//   FileHeader
+//   FileSubmesh[SubmeshCount]
+//   vertex blob   VertexCount*VertexStride bytes, copied verbatim
+//   index blob    IndexCount*IndexSize bytes
+//
+// The header records a hash of the source file and a caller-chosen content
+// version; the caller compares both against what it expects and rebuilds the
+// cache when either differs.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+class MeshCache
+{
+public:
+
+	using uint8 = std::uint8_t;
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	// Bumped whenever the file layout below changes.
+	static const uint32 FormatVersion = 2;
+
+	struct Submesh
+	{
+		std::string Name;           // at most 31 characters are stored
+		uint32 IndexCount = 0;
+		uint32 StartIndexLocation = 0;
+		int BaseVertexLocation = 0;
+		DirectX::XMFLOAT3 BoundsMin = { 0.0f, 0.0f, 0.0f };
+		DirectX::XMFLOAT3 BoundsMax = { 0.0f, 0.0f, 0.0f };
+		float GeometricError = 0.0f;    // of a simplified level, see MeshSimplifier
+	};
+
+	struct Mesh
+	{
+		uint64 SourceHash = 0;
+		uint32 ContentVersion = 0;  // the caller's processing version
+		uint32 VertexStride = 0;
+		uint32 IndexSize = 4;       // 2 or 4
+		DirectX::XMFLOAT3 BoundsMin = { 0.0f, 0.0f, 0.0f };
+		DirectX::XMFLOAT3 BoundsMax = { 0.0f, 0.0f, 0.0f };
+		std::vector<Submesh> Submeshes;
+		std::vector<uint8> VertexData;
+		std::vector<uint8> IndexData;
+
+		uint32 VertexCount()const { return VertexStride ? (uint32)(VertexData.size() / VertexStride) : 0; }
+		uint32 IndexCount()const { return (uint32)(IndexData.size() / IndexSize); }
+	};
+
+	///<summary>
+	/// 64-bit FNV-1a hash of a file's bytes.  Returns false if it can't be read.
+	///</summary>
+	static bool HashFile(const std::string& filename, uint64& hash);
+	static uint64 Hash(const void* data, size_t byteSize);
+
+	///<summary>
+	/// Reads the whole file in one go and unpacks it.  Returns false if the file
+	/// is missing, truncated, or written by a different FormatVersion, or if a
+	/// submesh's index range or an index (plus its submesh's base vertex) falls
+	/// outside the file's indices or vertices.
+	///</summary>
+	static bool Load(const std::string& filename, Mesh& mesh);
+
+	///<summary>
+	/// Writes mesh to filename, replacing any existing file.
+	///</summary>
+	static bool Save(const std::string& filename, const Mesh& mesh);
+
+private:
+	static const uint32 Magic = 0x4853454d; // "MESH"
+	static const uint32 BlobAlignment = 16;
+
+	struct FileHeader
+	{
+		uint32 Magic;
+		uint32 FormatVersion;
+		uint64 SourceHash;
+		uint32 ContentVersion;
+		uint32 VertexStride;
+		uint32 VertexCount;
+		uint32 IndexSize;
+		uint32 IndexCount;
+		uint32 SubmeshCount;
+		DirectX::XMFLOAT3 BoundsMin;
+		DirectX::XMFLOAT3 BoundsMax;
+		uint64 VertexDataOffset;
+		uint64 IndexDataOffset;
+		uint64 FileSize;
+	};
+
+	struct FileSubmesh
+	{
+		char Name[32];
+		uint32 IndexCount;
+		uint32 StartIndexLocation;
+		std::int32_t BaseVertexLocation;
+		DirectX::XMFLOAT3 BoundsMin;
+		DirectX::XMFLOAT3 BoundsMax;
+		float GeometricError;
+	};
+};
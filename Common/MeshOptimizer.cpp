@@ -0,0 +1,225 @@
+//***************************************************************************************
+// MeshOptimizer.cpp
+//***************************************************************************************
+
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cassert>
+
+using uint32 = MeshOptimizer::uint32;
+
+namespace
+{
+	// Triangles adjacent to each vertex in compressed (CSR) form: the triangles
+	// of vertex v are Triangles[Offsets[v]] .. Triangles[Offsets[v+1]-1].
+	struct VertexTriangleAdjacency
+	{
+		std::vector<uint32> Offsets;
+		std::vector<uint32> Triangles;
+
+		void Build(const uint32* indices, size_t indexCount, size_t vertexCount)
+		{
+			Offsets.assign(vertexCount + 1, 0);
+			for(size_t i = 0; i < indexCount; ++i)
+				Offsets[indices[i] + 1]++;
+
+			for(size_t v = 0; v < vertexCount; ++v)
+				Offsets[v + 1] += Offsets[v];
+
+			Triangles.resize(indexCount);
+			std::vector<uint32> cursor(Offsets.begin(), Offsets.end() - 1);
+			for(size_t i = 0; i < indexCount; ++i)
+				Triangles[cursor[indices[i]]++] = (uint32)(i / 3);
+		}
+
+		uint32 Count(uint32 v)const { return Offsets[v + 1] - Offsets[v]; }
+	};
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize)
+{
+	assert(indexCount % 3 == 0);
+
+	size_t triangleCount = indexCount / 3;
+	if(triangleCount == 0)
+		return;
+
+	VertexTriangleAdjacency adjacency;
+	adjacency.Build(indices, indexCount, vertexCount);
+
+	// Triangles not yet emitted that use each vertex.
+	std::vector<uint32> liveCount(vertexCount);
+	for(uint32 v = 0; v < (uint32)vertexCount; ++v)
+		liveCount[v] = adjacency.Count(v);
+
+	// Time at which each vertex last entered the (simulated FIFO) cache.  A
+	// vertex is cached while time - cacheTime[v] < cacheSize.
+	std::vector<uint32> cacheTime(vertexCount, 0);
+	uint32 time = cacheSize + 1;
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32> deadEnd;
+	deadEnd.reserve(indexCount);
+
+	std::vector<uint32> candidates;
+	candidates.reserve(64);
+
+	std::vector<uint32> result(indexCount);
+	size_t k = 0;
+
+	uint32 fanVertex = 0;
+	uint32 nextScan = 1;
+	const uint32 NoVertex = ~0u;
+
+	while(fanVertex != NoVertex)
+	{
+		//
+		// Emit every remaining triangle around the fanning vertex.
+		//
+
+		candidates.clear();
+		for(uint32 a = adjacency.Offsets[fanVertex]; a < adjacency.Offsets[fanVertex + 1]; ++a)
+		{
+			uint32 t = adjacency.Triangles[a];
+			if(emitted[t])
+				continue;
+
+			for(uint32 c = 0; c < 3; ++c)
+			{
+				uint32 v = indices[t*3 + c];
+				result[k++] = v;
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveCount[v]--;
+
+				if(time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+
+			emitted[t] = true;
+		}
+
+		//
+		// Pick the next fanning vertex: the candidate still in cache after its
+		// own triangles are emitted that entered the cache earliest.
+		//
+
+		uint32 best = NoVertex;
+		int bestPriority = -1;
+		for(uint32 v : candidates)
+		{
+			if(liveCount[v] == 0)
+				continue;
+
+			int priority = 0;
+			if(time - cacheTime[v] + 2*liveCount[v] <= cacheSize)
+				priority = (int)(time - cacheTime[v]);
+
+			if(priority > bestPriority)
+			{
+				bestPriority = priority;
+				best = v;
+			}
+		}
+
+		// Dead end: back up to a recently used vertex with work left, then fall
+		// back to scanning the vertices in order.
+		while(best == NoVertex && !deadEnd.empty())
+		{
+			uint32 v = deadEnd.back();
+			deadEnd.pop_back();
+			if(liveCount[v] > 0)
+				best = v;
+		}
+
+		while(best == NoVertex && nextScan < vertexCount)
+		{
+			if(liveCount[nextScan] > 0)
+				best = nextScan;
+			++nextScan;
+		}
+
+		fanVertex = best;
+	}
+
+	assert(k == indexCount);
+	std::copy(result.begin(), result.end(), indices);
+}
+
+void MeshOptimizer::OptimizeVertexCache(GeometryGenerator::MeshData& meshData, uint32 cacheSize)
+{
+	OptimizeVertexCache(meshData.Indices32.data(), meshData.Indices32.size(), meshData.Vertices.size(), cacheSize);
+}
+
+uint32 MeshOptimizer::OptimizeVertexFetchRemap(uint32* indices, size_t indexCount, size_t vertexCount, std::vector<uint32>& remap)
+{
+	remap.assign(vertexCount, ~0u);
+
+	uint32 nextVertex = 0;
+	for(size_t i = 0; i < indexCount; ++i)
+	{
+		uint32& newIndex = remap[indices[i]];
+		if(newIndex == ~0u)
+			newIndex = nextVertex++;
+
+		indices[i] = newIndex;
+	}
+
+	return nextVertex;
+}
+
+void MeshOptimizer::OptimizeVertexFetch(GeometryGenerator::MeshData& meshData)
+{
+	std::vector<uint32> remap;
+	uint32 vertexCount = OptimizeVertexFetchRemap(meshData.Indices32.data(), meshData.Indices32.size(),
+		meshData.Vertices.size(), remap);
+
+	RemapVertices(meshData.Vertices, remap, vertexCount);
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const uint32* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize)
+{
+	CacheStats stats;
+	stats.TriangleCount = (uint32)(indexCount / 3);
+
+	// Same timestamp trick as the cache pass: time only advances on a miss, so a
+	// vertex is still in the FIFO while fewer than cacheSize misses followed it.
+	std::vector<uint32> cacheTime(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32 time = cacheSize + 1;
+
+	for(size_t i = 0; i < indexCount; ++i)
+	{
+		uint32 v = indices[i];
+
+		if(!referenced[v])
+		{
+			referenced[v] = true;
+			stats.VertexCount++;
+		}
+
+		if(time - cacheTime[v] > cacheSize)
+		{
+			cacheTime[v] = time++;
+			stats.CacheMisses++;
+		}
+	}
+
+	if(stats.TriangleCount > 0)
+		stats.ACMR = (float)stats.CacheMisses / stats.TriangleCount;
+	if(stats.VertexCount > 0)
+		stats.ATVR = (float)stats.CacheMisses / stats.VertexCount;
+
+	return stats;
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const GeometryGenerator::MeshData& meshData, uint32 cacheSize)
+{
+	return AnalyzeVertexCache(meshData.Indices32.data(), meshData.Indices32.size(), meshData.Vertices.size(), cacheSize);
+}
+
+void MeshOptimizer::Optimize(GeometryGenerator::MeshData& meshData, uint32 cacheSize)
+{
+	OptimizeVertexCache(meshData, cacheSize);
+	OptimizeVertexFetch(meshData);
+}
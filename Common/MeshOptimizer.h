@@ -0,0 +1,90 @@
+//***************************************************************************************
+// MeshOptimizer.h
+//
+// Index and vertex reordering passes for triangle lists, run once at load time:
+//   1. OptimizeVertexCache reorders triangles so recently transformed vertices
+//      are reused (Tipsify, Sander et al. 2007).
+//   2. OptimizeVertexFetch renumbers vertices in first-use order so the vertex
+//      buffer is read front to back.
+//   3. AnalyzeVertexCache reports ACMR/ATVR for a FIFO post-transform cache.
+//
+// Run them in that order: the fetch pass only renames vertices, so it keeps the
+// triangle order chosen by the cache pass.
+//***************************************************************************************
+
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <cstdint>
+#include <vector>
+
+class MeshOptimizer
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	// Cache size used when none is given.  Small enough that the order also
+	// works well on hardware with a larger cache.
+	static const uint32 DefaultCacheSize = 16;
+
+	struct CacheStats
+	{
+		uint32 TriangleCount = 0;
+		uint32 VertexCount = 0;     // distinct vertices referenced
+		uint32 CacheMisses = 0;     // vertex shader invocations
+
+		// Average cache miss ratio: misses per triangle.  0.5 is the ideal for a
+		// large regular mesh, 3.0 means no reuse at all.
+		float ACMR = 0.0f;
+
+		// Average transform to vertex ratio: misses per distinct vertex.  1.0 is
+		// ideal whatever the mesh topology.
+		float ATVR = 0.0f;
+	};
+
+	///<summary>
+	/// Reorders the triangles of an indexed triangle list in place for a
+	/// post-transform vertex cache of cacheSize entries.  Runs in linear time.
+	///</summary>
+	static void OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize = DefaultCacheSize);
+	static void OptimizeVertexCache(GeometryGenerator::MeshData& meshData, uint32 cacheSize = DefaultCacheSize);
+
+	///<summary>
+	/// Renumbers vertices in the order the index buffer first references them and
+	/// rewrites the indices.  remap[oldIndex] receives the new index, or ~0u for
+	/// vertices no triangle uses.  Returns the number of vertices kept.  Apply the
+	/// same remap to the vertex array with RemapVertices.
+	///</summary>
+	static uint32 OptimizeVertexFetchRemap(uint32* indices, size_t indexCount, size_t vertexCount, std::vector<uint32>& remap);
+	static void OptimizeVertexFetch(GeometryGenerator::MeshData& meshData);
+
+	///<summary>
+	/// Moves vertices to the slots chosen by OptimizeVertexFetchRemap and drops
+	/// the unused ones.  Works with any vertex type.
+	///</summary>
+	template<typename T>
+	static void RemapVertices(std::vector<T>& vertices, const std::vector<uint32>& remap, uint32 newVertexCount)
+	{
+		std::vector<T> result(newVertexCount);
+		for(size_t i = 0; i < vertices.size(); ++i)
+		{
+			if(remap[i] != ~0u)
+				result[remap[i]] = vertices[i];
+		}
+
+		vertices.swap(result);
+	}
+
+	///<summary>
+	/// Simulates a FIFO post-transform cache of cacheSize entries over the index
+	/// list and reports how many vertices would be transformed.
+	///</summary>
+	static CacheStats AnalyzeVertexCache(const uint32* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize = DefaultCacheSize);
+	static CacheStats AnalyzeVertexCache(const GeometryGenerator::MeshData& meshData, uint32 cacheSize = DefaultCacheSize);
+
+	///<summary>
+	/// Runs the cache pass and then the fetch pass on meshData.
+	///</summary>
+	static void Optimize(GeometryGenerator::MeshData& meshData, uint32 cacheSize = DefaultCacheSize);
+};
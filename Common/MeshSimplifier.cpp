@@ -0,0 +1,849 @@
+//***************************************************************************************
+// MeshSimplifier.cpp
+//***************************************************************************************
+
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+
+using namespace DirectX;
+
+using uint32 = MeshSimplifier::uint32;
+
+namespace
+{
+	// Normal xyz and texcoord uv ride along with the position in the quadrics.
+	const int AttributeCount = 5;
+	const int FullSize = 3 + AttributeCount;
+
+	// Border planes are weighted up so borders keep their shape.
+	const double BorderWeight = 10.0;
+
+	///<summary>
+	/// Q(x) = x'Ax + 2b'x + c over N coordinates, A symmetric and stored as its
+	/// upper triangle.
+	///</summary>
+	template<int N>
+	struct Quadric
+	{
+		double A[N*(N + 1)/2] = {};
+		double b[N] = {};
+		double c = 0.0;
+		double Weight = 0.0;
+
+		// Adds w*(u.x + d)^2.
+		void AddSquare(const double* u, double d, double w)
+		{
+			for(int i = 0, k = 0; i < N; ++i)
+			{
+				for(int j = i; j < N; ++j)
+					A[k++] += w*u[i]*u[j];
+
+				b[i] += w*d*u[i];
+			}
+
+			c += w*d*d;
+		}
+
+		void Add(const Quadric& q)
+		{
+			for(int i = 0; i < N*(N + 1)/2; ++i)
+				A[i] += q.A[i];
+			for(int i = 0; i < N; ++i)
+				b[i] += q.b[i];
+			c += q.c;
+			Weight += q.Weight;
+		}
+
+		double Evaluate(const double* x)const
+		{
+			double result = c;
+			for(int i = 0, k = 0; i < N; ++i)
+			{
+				result += 2.0*b[i]*x[i] + A[k++]*x[i]*x[i];
+				for(int j = i + 1; j < N; ++j)
+					result += 2.0*A[k++]*x[i]*x[j];
+			}
+
+			return result;
+		}
+	};
+
+	template<int N>
+	double EvaluateSum(const Quadric<N>& q0, const Quadric<N>& q1, const double* x)
+	{
+		double weight = q0.Weight + q1.Weight;
+		double error = q0.Evaluate(x) + q1.Evaluate(x);
+		return weight > 0.0 ? std::max(0.0, error) / weight : 0.0;
+	}
+
+	void Sub(const double* a, const double* b, double* r) { r[0] = a[0] - b[0]; r[1] = a[1] - b[1]; r[2] = a[2] - b[2]; }
+	double Dot(const double* a, const double* b) { return a[0]*b[0] + a[1]*b[1] + a[2]*b[2]; }
+	void Cross(const double* a, const double* b, double* r)
+	{
+		r[0] = a[1]*b[2] - a[2]*b[1];
+		r[1] = a[2]*b[0] - a[0]*b[2];
+		r[2] = a[0]*b[1] - a[1]*b[0];
+	}
+
+	///<summary>
+	/// Squared distance from p to the triangle (a, b, c), after the closest
+	/// point search of Ericson's Real-Time Collision Detection, 5.1.5.
+	///</summary>
+	double TriangleDistanceSq(const double* p, const double* a, const double* b, const double* c)
+	{
+		double ab[3], ac[3], ap[3], q[3];
+		Sub(b, a, ab);
+		Sub(c, a, ac);
+		Sub(p, a, ap);
+
+		auto distanceTo = [p](const double* x)
+		{
+			double d[3];
+			Sub(p, x, d);
+			return Dot(d, d);
+		};
+		auto distanceToEdge = [&](const double* x, const double* e, double t)
+		{
+			for(int k = 0; k < 3; ++k)
+				q[k] = x[k] + t*e[k];
+			return distanceTo(q);
+		};
+
+		double d1 = Dot(ab, ap);
+		double d2 = Dot(ac, ap);
+		if(d1 <= 0.0 && d2 <= 0.0)
+			return distanceTo(a);
+
+		double bp[3];
+		Sub(p, b, bp);
+		double d3 = Dot(ab, bp);
+		double d4 = Dot(ac, bp);
+		if(d3 >= 0.0 && d4 <= d3)
+			return distanceTo(b);
+
+		double vc = d1*d4 - d3*d2;
+		if(vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+			return distanceToEdge(a, ab, d1 / (d1 - d3));
+
+		double cp[3];
+		Sub(p, c, cp);
+		double d5 = Dot(ab, cp);
+		double d6 = Dot(ac, cp);
+		if(d6 >= 0.0 && d5 <= d6)
+			return distanceTo(c);
+
+		double vb = d5*d2 - d1*d6;
+		if(vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+			return distanceToEdge(a, ac, d2 / (d2 - d6));
+
+		double va = d3*d6 - d5*d4;
+		if(va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+		{
+			double bc[3];
+			Sub(c, b, bc);
+			return distanceToEdge(b, bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+		}
+
+		double denom = va + vb + vc;
+		if(denom <= 0.0)
+			return std::min(distanceTo(a), std::min(distanceTo(b), distanceTo(c)));
+
+		double v = vb / denom;
+		double w = vc / denom;
+		for(int k = 0; k < 3; ++k)
+			q[k] = a[k] + v*ab[k] + w*ac[k];
+		return distanceTo(q);
+	}
+
+	enum class VertexKind : unsigned char
+	{
+		Manifold,   // free to move
+		Border,     // on an open border; moves only along it
+		Locked      // seam, non-manifold or locked border; never moves
+	};
+
+	struct Collapse
+	{
+		uint32 From;
+		uint32 To;
+		double Cost;
+	};
+
+	///<summary>
+	/// The mesh being simplified: triangles with dead ones marked, per-vertex
+	/// triangle lists, quadrics and kinds.
+	///</summary>
+	class Simplifier
+	{
+	public:
+		Simplifier(const uint32* indices, size_t indexCount,
+			const void* vertices, size_t vertexCount, const GeometryGenerator::VertexLayout& layout,
+			const MeshSimplifier::Options& options);
+
+		uint32 SourceTriangleCount()const { return (uint32)mDead.size(); }
+
+		void SimplifyTo(uint32 targetTriangles);
+
+		MeshSimplifier::Lod Snapshot()const;
+
+	private:
+		void ClassifyVertices(bool lockBorders);
+		void BuildQuadrics(const MeshSimplifier::Options& options);
+
+		bool IsCollapseAllowed(uint32 from, uint32 to)const;
+		bool IsCollapseValid(uint32 from, uint32 to);
+		void DoCollapse(uint32 from, uint32 to);
+
+		void GatherNeighbours(uint32 v, std::vector<uint32>& neighbours);
+		uint32 SharedTriangleCount(uint32 a, uint32 b)const;
+		void MeasureMerged(uint32 v);
+
+		// A vertex's point in quadric space; its first three values are the position.
+		const double* Point(uint32 v)const { return &mPoints[v*FullSize]; }
+		const double* Position(uint32 v)const { return Point(v); }
+
+		std::vector<uint32> mTriangles;
+		std::vector<char> mDead;
+		uint32 mLiveTriangles = 0;
+
+		// Per vertex: position (in units of the mesh extent, centered) followed
+		// by the attributes, triangles touching it, and its kind.
+		std::vector<double> mPoints;
+		std::vector<std::vector<uint32>> mVertexTriangles;
+		std::vector<VertexKind> mKinds;
+
+		std::vector<Quadric<FullSize>> mQuadrics;
+
+		// Per vertex: the source vertices collapsed onto it so far.
+		std::vector<std::vector<uint32>> mMerged;
+
+		double mExtent = 1.0;
+		double mMaxErrorSq = 0.0;   // in extent units
+
+		std::vector<uint32> mNeighboursA;
+		std::vector<uint32> mNeighboursB;
+	};
+
+	Simplifier::Simplifier(const uint32* indices, size_t indexCount,
+		const void* vertices, size_t vertexCount, const GeometryGenerator::VertexLayout& layout,
+		const MeshSimplifier::Options& options)
+		: mTriangles(indices, indices + indexCount)
+		, mDead(indexCount / 3, 0)
+		, mLiveTriangles((uint32)(indexCount / 3))
+		, mPoints(vertexCount*FullSize, 0.0)
+		, mVertexTriangles(vertexCount)
+		, mKinds(vertexCount, VertexKind::Manifold)
+		, mQuadrics(vertexCount)
+		, mMerged(vertexCount)
+	{
+		assert(layout.PositionOffset >= 0);
+
+		//
+		// Gather the attributes, with positions centered and scaled so errors
+		// and weights don't depend on the mesh's size.
+		//
+
+		const char* bytes = static_cast<const char*>(vertices);
+
+		XMFLOAT3 boundsMin(+FLT_MAX, +FLT_MAX, +FLT_MAX);
+		XMFLOAT3 boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for(size_t i = 0; i < vertexCount; ++i)
+		{
+			XMFLOAT3 p;
+			std::memcpy(&p, bytes + i*layout.Stride + layout.PositionOffset, sizeof(p));
+			boundsMin = XMFLOAT3(std::min(boundsMin.x, p.x), std::min(boundsMin.y, p.y), std::min(boundsMin.z, p.z));
+			boundsMax = XMFLOAT3(std::max(boundsMax.x, p.x), std::max(boundsMax.y, p.y), std::max(boundsMax.z, p.z));
+		}
+
+		if(vertexCount > 0)
+			mExtent = std::max(std::max(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y), boundsMax.z - boundsMin.z);
+		if(mExtent <= 0.0)
+			mExtent = 1.0;
+
+		for(size_t i = 0; i < vertexCount; ++i)
+		{
+			const char* vertex = bytes + i*layout.Stride;
+			double* dst = &mPoints[i*FullSize];
+
+			XMFLOAT3 p;
+			std::memcpy(&p, vertex + layout.PositionOffset, sizeof(p));
+			dst[0] = (p.x - boundsMin.x) / mExtent;
+			dst[1] = (p.y - boundsMin.y) / mExtent;
+			dst[2] = (p.z - boundsMin.z) / mExtent;
+
+			if(layout.NormalOffset >= 0)
+			{
+				XMFLOAT3 n;
+				std::memcpy(&n, vertex + layout.NormalOffset, sizeof(n));
+				dst[3] = n.x;
+				dst[4] = n.y;
+				dst[5] = n.z;
+			}
+
+			if(layout.TexCOffset >= 0)
+			{
+				XMFLOAT2 uv;
+				std::memcpy(&uv, vertex + layout.TexCOffset, sizeof(uv));
+				dst[6] = uv.x;
+				dst[7] = uv.y;
+			}
+		}
+
+		for(uint32 t = 0; t < mDead.size(); ++t)
+		{
+			const uint32* tri = &mTriangles[3*t];
+			if(tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2])
+			{
+				mDead[t] = 1;
+				mLiveTriangles--;
+				continue;
+			}
+
+			for(int c = 0; c < 3; ++c)
+				mVertexTriangles[tri[c]].push_back(t);
+		}
+
+		ClassifyVertices(options.LockBorders);
+		BuildQuadrics(options);
+	}
+
+	void Simplifier::ClassifyVertices(bool lockBorders)
+	{
+		//
+		// Vertices sharing a position are the two sides of a seam; moving one
+		// side alone would tear the surface, so they stay put.
+		//
+
+		struct PositionHash
+		{
+			size_t operator()(const XMFLOAT3& p)const
+			{
+				uint32 h[3];
+				std::memcpy(h, &p, sizeof(h));
+				return (h[0]*73856093u) ^ (h[1]*19349663u) ^ (h[2]*83492791u);
+			}
+		};
+		struct PositionEqual
+		{
+			bool operator()(const XMFLOAT3& a, const XMFLOAT3& b)const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+		};
+
+		std::unordered_map<XMFLOAT3, uint32, PositionHash, PositionEqual> firstAtPosition;
+		for(uint32 v = 0; v < mKinds.size(); ++v)
+		{
+			const double* p = Position(v);
+			XMFLOAT3 key((float)p[0], (float)p[1], (float)p[2]);
+
+			auto inserted = firstAtPosition.insert({ key, v });
+			if(!inserted.second)
+			{
+				mKinds[v] = VertexKind::Locked;
+				mKinds[inserted.first->second] = VertexKind::Locked;
+			}
+		}
+
+		//
+		// Count the triangles on every edge: one means an open border, more
+		// than two a non-manifold edge.
+		//
+
+		std::unordered_map<std::uint64_t, uint32> edgeTriangles;
+		edgeTriangles.reserve(mTriangles.size());
+
+		for(uint32 t = 0; t < mDead.size(); ++t)
+		{
+			if(mDead[t])
+				continue;
+
+			for(int c = 0; c < 3; ++c)
+			{
+				uint32 a = mTriangles[3*t + c];
+				uint32 b = mTriangles[3*t + (c + 1) % 3];
+				std::uint64_t key = ((std::uint64_t)std::min(a, b) << 32) | std::max(a, b);
+				edgeTriangles[key]++;
+			}
+		}
+
+		for(const auto& edge : edgeTriangles)
+		{
+			uint32 a = (uint32)(edge.first >> 32);
+			uint32 b = (uint32)(edge.first & 0xffffffff);
+
+			VertexKind kind = VertexKind::Locked;
+			if(edge.second == 1 && !lockBorders)
+				kind = VertexKind::Border;
+			else if(edge.second == 2)
+				continue;
+
+			for(uint32 v : { a, b })
+			{
+				if(mKinds[v] != VertexKind::Locked)
+					mKinds[v] = kind;
+			}
+		}
+	}
+
+	void Simplifier::BuildQuadrics(const MeshSimplifier::Options& options)
+	{
+		const double attributeWeights[AttributeCount] = {
+			options.NormalWeight, options.NormalWeight, options.NormalWeight,
+			options.TexCWeight, options.TexCWeight };
+
+		for(uint32 t = 0; t < mDead.size(); ++t)
+		{
+			if(mDead[t])
+				continue;
+
+			const uint32* tri = &mTriangles[3*t];
+			const double* p0 = Position(tri[0]);
+			const double* p1 = Position(tri[1]);
+			const double* p2 = Position(tri[2]);
+
+			double e1[3], e2[3], n[3];
+			Sub(p1, p0, e1);
+			Sub(p2, p0, e2);
+			Cross(e1, e2, n);
+
+			double length = std::sqrt(Dot(n, n));
+			if(length <= 0.0)
+				continue;
+
+			double area = 0.5*length;
+			n[0] /= length;
+			n[1] /= length;
+			n[2] /= length;
+
+			Quadric<FullSize> full;
+
+			// Distance from the triangle's plane.
+			double u[FullSize] = { n[0], n[1], n[2] };
+			double d = -Dot(n, p0);
+			full.AddSquare(u, d, area);
+
+			//
+			// Each attribute varies linearly over the triangle as g.p + d.  The
+			// quadric measures how far a vertex's own value is from that, so the
+			// gradient g lies in the plane: g = a*e1 + b*e2 with g.e1 and g.e2
+			// matching the attribute's change along the edges.
+			//
+
+			double e11 = Dot(e1, e1);
+			double e12 = Dot(e1, e2);
+			double e22 = Dot(e2, e2);
+			double det = e11*e22 - e12*e12;
+
+			if(det > 0.0)
+			{
+				for(int j = 0; j < AttributeCount; ++j)
+				{
+					if(attributeWeights[j] <= 0.0)
+						continue;
+
+					double s0 = Point(tri[0])[3 + j];
+					double ds1 = Point(tri[1])[3 + j] - s0;
+					double ds2 = Point(tri[2])[3 + j] - s0;
+
+					double a = (ds1*e22 - ds2*e12) / det;
+					double b = (ds2*e11 - ds1*e12) / det;
+
+					double g[FullSize] = {};
+					for(int k = 0; k < 3; ++k)
+						g[k] = a*e1[k] + b*e2[k];
+					g[3 + j] = -1.0;
+
+					full.AddSquare(g, s0 - Dot(g, p0), area*attributeWeights[j]);
+				}
+			}
+
+			full.Weight = area;
+
+			for(int c = 0; c < 3; ++c)
+				mQuadrics[tri[c]].Add(full);
+
+			//
+			// Open border edges also get a plane through the edge, perpendicular
+			// to the triangle, that holds the border in place.
+			//
+
+			for(int c = 0; c < 3; ++c)
+			{
+				uint32 a = tri[c];
+				uint32 b = tri[(c + 1) % 3];
+				if(mKinds[a] == VertexKind::Manifold || mKinds[b] == VertexKind::Manifold || SharedTriangleCount(a, b) != 1)
+					continue;
+
+				double edge[3];
+				Sub(Position(b), Position(a), edge);
+
+				double bn[3];
+				Cross(edge, n, bn);
+				double bnLength = std::sqrt(Dot(bn, bn));
+				if(bnLength <= 0.0)
+					continue;
+
+				double ub[FullSize] = { bn[0] / bnLength, bn[1] / bnLength, bn[2] / bnLength };
+				double db = -Dot(ub, Position(a));
+				double w = BorderWeight*Dot(edge, edge);
+
+				Quadric<FullSize> border;
+				border.AddSquare(ub, db, w);
+
+				for(uint32 v : { a, b })
+					mQuadrics[v].Add(border);
+			}
+		}
+	}
+
+	uint32 Simplifier::SharedTriangleCount(uint32 a, uint32 b)const
+	{
+		uint32 count = 0;
+		for(uint32 t : mVertexTriangles[a])
+		{
+			if(mDead[t])
+				continue;
+
+			const uint32* tri = &mTriangles[3*t];
+			if(tri[0] == b || tri[1] == b || tri[2] == b)
+				count++;
+		}
+
+		return count;
+	}
+
+	void Simplifier::MeasureMerged(uint32 v)
+	{
+		const std::vector<uint32>& triangles = mVertexTriangles[v];
+		if(triangles.empty())
+			return;
+
+		for(uint32 original : mMerged[v])
+		{
+			const double* p = Position(original);
+
+			// Sliding along the surface is no error, so only the offset from
+			// the plane of the nearest triangle counts.
+			double nearest = DBL_MAX;
+			const uint32* nearestTri = nullptr;
+			for(uint32 t : triangles)
+			{
+				// Neighbours' lists still hold the triangles the collapse just
+				// removed; only to's list is purged.
+				if(mDead[t])
+					continue;
+
+				const uint32* tri = &mTriangles[3*t];
+				double distanceSq = TriangleDistanceSq(p, Position(tri[0]), Position(tri[1]), Position(tri[2]));
+				if(distanceSq < nearest)
+				{
+					nearest = distanceSq;
+					nearestTri = tri;
+				}
+			}
+
+			if(nearestTri == nullptr)
+				return;
+
+			double e1[3], e2[3], n[3], offset[3];
+			Sub(Position(nearestTri[1]), Position(nearestTri[0]), e1);
+			Sub(Position(nearestTri[2]), Position(nearestTri[0]), e2);
+			Cross(e1, e2, n);
+			Sub(p, Position(nearestTri[0]), offset);
+
+			double lengthSq = Dot(n, n);
+			double planeSq = lengthSq > 0.0 ? Dot(n, offset)*Dot(n, offset) / lengthSq : nearest;
+			mMaxErrorSq = std::max(mMaxErrorSq, planeSq);
+		}
+	}
+
+	void Simplifier::GatherNeighbours(uint32 v, std::vector<uint32>& neighbours)
+	{
+		neighbours.clear();
+		for(uint32 t : mVertexTriangles[v])
+		{
+			if(mDead[t])
+				continue;
+
+			for(int c = 0; c < 3; ++c)
+			{
+				uint32 w = mTriangles[3*t + c];
+				if(w != v)
+					neighbours.push_back(w);
+			}
+		}
+
+		std::sort(neighbours.begin(), neighbours.end());
+		neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+	}
+
+	bool Simplifier::IsCollapseAllowed(uint32 from, uint32 to)const
+	{
+		switch(mKinds[from])
+		{
+		case VertexKind::Manifold:
+			return true;
+		case VertexKind::Border:
+			// Only along the border, onto another border vertex.
+			return mKinds[to] != VertexKind::Manifold && SharedTriangleCount(from, to) == 1;
+		default:
+			return false;
+		}
+	}
+
+	bool Simplifier::IsCollapseValid(uint32 from, uint32 to)
+	{
+		//
+		// Link condition: the two vertices may only share the neighbours
+		// opposite the edge, or the collapse would pinch the surface.
+		//
+
+		GatherNeighbours(from, mNeighboursA);
+		GatherNeighbours(to, mNeighboursB);
+
+		uint32 shared = 0;
+		for(size_t i = 0, j = 0; i < mNeighboursA.size() && j < mNeighboursB.size(); )
+		{
+			if(mNeighboursA[i] < mNeighboursB[j])
+				i++;
+			else if(mNeighboursA[i] > mNeighboursB[j])
+				j++;
+			else
+			{
+				shared++;
+				i++;
+				j++;
+			}
+		}
+
+		if(shared != SharedTriangleCount(from, to))
+			return false;
+
+		//
+		// No remaining triangle may flip over.
+		//
+
+		const double* target = Position(to);
+		for(uint32 t : mVertexTriangles[from])
+		{
+			if(mDead[t])
+				continue;
+
+			const uint32* tri = &mTriangles[3*t];
+			if(tri[0] == to || tri[1] == to || tri[2] == to)
+				continue;
+
+			int c = tri[0] == from ? 0 : (tri[1] == from ? 1 : 2);
+			const double* p1 = Position(tri[(c + 1) % 3]);
+			const double* p2 = Position(tri[(c + 2) % 3]);
+
+			double e1[3], e2[3], before[3], after[3];
+			Sub(p1, Position(from), e1);
+			Sub(p2, Position(from), e2);
+			Cross(e1, e2, before);
+
+			Sub(p1, target, e1);
+			Sub(p2, target, e2);
+			Cross(e1, e2, after);
+
+			// Also refuses triangles that would become (nearly) degenerate.
+			double beforeLength = std::sqrt(Dot(before, before));
+			double afterLength = std::sqrt(Dot(after, after));
+			if(Dot(before, after) <= 1e-2*beforeLength*afterLength)
+				return false;
+		}
+
+		return true;
+	}
+
+	void Simplifier::DoCollapse(uint32 from, uint32 to)
+	{
+		for(uint32 t : mVertexTriangles[from])
+		{
+			if(mDead[t])
+				continue;
+
+			uint32* tri = &mTriangles[3*t];
+			if(tri[0] == to || tri[1] == to || tri[2] == to)
+			{
+				mDead[t] = 1;
+				mLiveTriangles--;
+				continue;
+			}
+
+			for(int c = 0; c < 3; ++c)
+			{
+				if(tri[c] == from)
+					tri[c] = to;
+			}
+
+			mVertexTriangles[to].push_back(t);
+		}
+
+		mVertexTriangles[from].clear();
+
+		// Drop the triangles that just died from the target's list.
+		auto& toTriangles = mVertexTriangles[to];
+		toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(),
+			[this](uint32 t) { return mDead[t] != 0; }), toTriangles.end());
+
+		mQuadrics[to].Add(mQuadrics[from]);
+
+		//
+		// to now stands for from and everything collapsed onto it.  Every
+		// source vertex is measured against the triangles around the vertex
+		// that stands for it, and those changed for to and its neighbours.
+		//
+
+		std::vector<uint32>& merged = mMerged[to];
+		merged.push_back(from);
+		merged.insert(merged.end(), mMerged[from].begin(), mMerged[from].end());
+		std::vector<uint32>().swap(mMerged[from]);
+
+		MeasureMerged(to);
+		GatherNeighbours(to, mNeighboursA);
+		for(uint32 v : mNeighboursA)
+			MeasureMerged(v);
+	}
+
+	void Simplifier::SimplifyTo(uint32 targetTriangles)
+	{
+		std::vector<Collapse> collapses;
+		std::vector<char> touched(mKinds.size());
+
+		while(mLiveTriangles > targetTriangles)
+		{
+			//
+			// Cost every edge in its cheaper allowed direction.
+			//
+
+			collapses.clear();
+			for(uint32 t = 0; t < mDead.size(); ++t)
+			{
+				if(mDead[t])
+					continue;
+
+				for(int c = 0; c < 3; ++c)
+				{
+					uint32 a = mTriangles[3*t + c];
+					uint32 b = mTriangles[3*t + (c + 1) % 3];
+
+					// Interior edges show up from both of their triangles.
+					if(a > b && mKinds[a] == VertexKind::Manifold && mKinds[b] == VertexKind::Manifold)
+						continue;
+
+					Collapse best = { a, b, -1.0 };
+					if(IsCollapseAllowed(a, b))
+						best.Cost = EvaluateSum(mQuadrics[a], mQuadrics[b], Point(b));
+
+					if(IsCollapseAllowed(b, a))
+					{
+						double cost = EvaluateSum(mQuadrics[a], mQuadrics[b], Point(a));
+						if(best.Cost < 0.0 || cost < best.Cost)
+							best = { b, a, cost };
+					}
+
+					if(best.Cost >= 0.0)
+						collapses.push_back(best);
+				}
+			}
+
+			if(collapses.empty())
+				break;
+
+			std::sort(collapses.begin(), collapses.end(),
+				[](const Collapse& x, const Collapse& y) { return x.Cost < y.Cost; });
+
+			//
+			// Apply the cheapest third, each vertex at most once per pass, so
+			// the costs used stay close to the truth.
+			//
+
+			std::fill(touched.begin(), touched.end(), 0);
+
+			size_t passLimit = std::max<size_t>(1, collapses.size() / 3);
+			uint32 collapsed = 0;
+
+			for(size_t i = 0; i < passLimit && mLiveTriangles > targetTriangles; ++i)
+			{
+				const Collapse& collapse = collapses[i];
+				if(touched[collapse.From] || touched[collapse.To])
+					continue;
+
+				if(!IsCollapseValid(collapse.From, collapse.To))
+					continue;
+
+				DoCollapse(collapse.From, collapse.To);
+				touched[collapse.From] = 1;
+				touched[collapse.To] = 1;
+				collapsed++;
+			}
+
+			if(collapsed == 0)
+				break;
+		}
+	}
+
+	MeshSimplifier::Lod Simplifier::Snapshot()const
+	{
+		MeshSimplifier::Lod lod;
+		lod.Indices.reserve(3*(size_t)mLiveTriangles);
+
+		for(uint32 t = 0; t < mDead.size(); ++t)
+		{
+			if(!mDead[t])
+				lod.Indices.insert(lod.Indices.end(), &mTriangles[3*t], &mTriangles[3*t] + 3);
+		}
+
+		lod.GeometricError = (float)(std::sqrt(mMaxErrorSq)*mExtent);
+		return lod;
+	}
+}
+
+MeshSimplifier::Lod MeshSimplifier::Simplify(const uint32* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, const GeometryGenerator::VertexLayout& layout,
+	float targetRatio, const Options& options)
+{
+	return BuildLodChain(indices, indexCount, vertices, vertexCount, layout,
+		std::vector<float>(1, targetRatio), options)[0];
+}
+
+std::vector<MeshSimplifier::Lod> MeshSimplifier::BuildLodChain(const uint32* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, const GeometryGenerator::VertexLayout& layout,
+	const std::vector<float>& ratios, const Options& options)
+{
+	assert(indexCount % 3 == 0);
+
+	Simplifier simplifier(indices, indexCount, vertices, vertexCount, layout, options);
+
+	std::vector<Lod> lods;
+	lods.reserve(ratios.size());
+
+	for(float ratio : ratios)
+	{
+		assert(lods.empty() || ratio <= ratios[lods.size() - 1]);
+
+		uint32 target = (uint32)(std::max(0.0f, ratio) * simplifier.SourceTriangleCount());
+		simplifier.SimplifyTo(target);
+		lods.push_back(simplifier.Snapshot());
+	}
+
+	return lods;
+}
+
+std::vector<MeshSimplifier::Lod> MeshSimplifier::BuildLodChain(const GeometryGenerator::MeshData& meshData,
+	const std::vector<float>& ratios, const Options& options)
+{
+	GeometryGenerator::VertexLayout layout;
+	layout.Stride = sizeof(GeometryGenerator::Vertex);
+	layout.PositionOffset = offsetof(GeometryGenerator::Vertex, Position);
+	layout.NormalOffset = offsetof(GeometryGenerator::Vertex, Normal);
+	layout.TexCOffset = offsetof(GeometryGenerator::Vertex, TexC);
+
+	return BuildLodChain(meshData.Indices32.data(), meshData.Indices32.size(),
+		meshData.Vertices.data(), meshData.Vertices.size(), layout, ratios, options);
+}
@@ -0,0 +1,75 @@
+//***************************************************************************************
+// MeshSimplifier.h
+//
+// Builds levels of detail of an indexed triangle mesh by repeated half-edge
+// collapses ordered by a quadric error metric.  A collapse moves a vertex onto a
+// neighbouring one, so every level only drops triangles and keeps referencing
+// the original vertices: the levels can share the mesh's vertex buffer and just
+// append their index lists to its index buffer.
+//
+// Each vertex carries a quadric over position, normal and texcoord (Hoppe's
+// attribute quadrics, area weighted), so collapses that would smear shading or
+// texture mapping cost more than purely geometric ones.  Vertices sharing a
+// position with another vertex (normal or UV seams) and vertices on
+// non-manifold edges never move; open borders only collapse along themselves.
+//
+// Every level reports its geometric error: the largest distance, in object
+// space, of a source vertex from the plane of the nearest triangle around the
+// vertex that now stands for it.  It is measured again whenever those
+// triangles change, so it holds for the level as a whole.  A LOD selector can
+// compare it against a screen-space error budget.
+//***************************************************************************************
+
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <cstdint>
+#include <vector>
+
+class MeshSimplifier
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	struct Options
+	{
+		// Attribute costs relative to position errors measured in units of the
+		// mesh's largest extent: with 1e-4 a normal off by 0.1 (about 6 degrees)
+		// costs as much as moving the surface by 0.1% of the mesh size.  On the
+		// skull this roughly doubles the geometric error of each level.
+		float NormalWeight = 1e-4f;
+		float TexCWeight = 1e-4f;
+
+		// Keep open borders exactly where they are.
+		bool LockBorders = false;
+	};
+
+	struct Lod
+	{
+		std::vector<uint32> Indices;     // references the source vertices
+		float GeometricError = 0.0f;     // object-space distance
+	};
+
+	///<summary>
+	/// Simplifies the mesh towards targetRatio of its triangles.  Positions are
+	/// required in layout; normals and texcoords are used when present.  The
+	/// target may not be reached if the remaining collapses would damage the
+	/// mesh (flipped triangles, non-manifold edges, locked vertices).
+	///</summary>
+	static Lod Simplify(const uint32* indices, size_t indexCount,
+		const void* vertices, size_t vertexCount, const GeometryGenerator::VertexLayout& layout,
+		float targetRatio, const Options& options);
+
+	///<summary>
+	/// One Lod per entry of ratios, which must be decreasing.  Each level is
+	/// simplified further from the previous one, so the chain costs about as
+	/// much as building its coarsest level alone.
+	///</summary>
+	static std::vector<Lod> BuildLodChain(const uint32* indices, size_t indexCount,
+		const void* vertices, size_t vertexCount, const GeometryGenerator::VertexLayout& layout,
+		const std::vector<float>& ratios, const Options& options);
+
+	static std::vector<Lod> BuildLodChain(const GeometryGenerator::MeshData& meshData,
+		const std::vector<float>& ratios, const Options& options);
+};
@@ -0,0 +1,292 @@
+//***************************************************************************************
+// MeshWelder.cpp
+//***************************************************************************************
+
+#include "MeshWelder.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using namespace DirectX;
+
+using uint32 = MeshWelder::uint32;
+
+namespace
+{
+	// One float attribute inside the vertex data.
+	struct Stream
+	{
+		const char* Data = nullptr;
+		size_t Stride = 0;
+		int Components = 0;
+		float Tolerance = 0.0f;
+
+		const float* At(size_t i)const { return reinterpret_cast<const float*>(Data + i*Stride); }
+	};
+
+	struct Cell
+	{
+		std::int64_t X = 0;
+		std::int64_t Y = 0;
+		std::int64_t Z = 0;
+
+		bool operator==(const Cell& rhs)const { return X == rhs.X && Y == rhs.Y && Z == rhs.Z; }
+	};
+
+	const uint32 EmptySlot = ~0u;
+
+	// A kept vertex filed under its cell.  The cell's hash is stored alongside
+	// so most probes are rejected without touching the vertex data.
+	struct Slot
+	{
+		uint32 Vertex = EmptySlot;
+		uint32 Hash = 0;
+	};
+
+	uint32 HashCell(const Cell& c)
+	{
+		std::uint64_t h = (std::uint64_t)c.X * 0x9e3779b97f4a7c15ull
+			^ (std::uint64_t)c.Y * 0xc2b2ae3d27d4eb4full
+			^ (std::uint64_t)c.Z * 0x165667b19e3779f9ull;
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		return (uint32)(h ^ (h >> 32));
+	}
+
+	// Grid coordinate of v along one axis.  Exact welding uses the float's bits
+	// as the cell, so only identical values share one.
+	std::int64_t CellCoord(float v, float invCellSize)
+	{
+		if(invCellSize == 0.0f)
+		{
+			if(v == 0.0f)
+				v = 0.0f;   // -0 and +0 are equal
+
+			std::int32_t bits;
+			std::memcpy(&bits, &v, sizeof(bits));
+			return bits;
+		}
+
+		// The clamp only guards the conversion against infinities and values
+		// far beyond any real mesh; NaN goes to the origin.
+		const double limit = 4611686018427387904.0;   // 2^62
+		double c = std::floor((double)v * invCellSize);
+		if(c != c)
+			c = 0.0;
+		c = c < -limit ? -limit : (c > limit ? limit : c);
+
+		return (std::int64_t)c;
+	}
+
+	bool Equal(const Stream* streams, size_t streamCount, size_t a, size_t b)
+	{
+		for(size_t s = 0; s < streamCount; ++s)
+		{
+			const float* va = streams[s].At(a);
+			const float* vb = streams[s].At(b);
+			for(int c = 0; c < streams[s].Components; ++c)
+			{
+				if(!(std::fabs(va[c] - vb[c]) <= streams[s].Tolerance))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	// streams[0] must be the position.
+	uint32 BuildRemap(const Stream* streams, size_t streamCount, size_t vertexCount, std::vector<uint32>& remap)
+	{
+		remap.assign(vertexCount, EmptySlot);
+
+		const Stream& position = streams[0];
+		float tolerance = position.Tolerance;
+
+		// With cells twice the tolerance wide, [p - tolerance, p + tolerance]
+		// touches at most two cells per axis.
+		float invCellSize = tolerance > 0.0f ? 0.5f / tolerance : 0.0f;
+
+		size_t capacity = 16;
+		while(capacity < 2*vertexCount)
+			capacity *= 2;
+		uint32 mask = (uint32)(capacity - 1);
+
+		std::vector<Slot> table(capacity);
+		std::vector<Cell> cells(vertexCount);
+
+		uint32 newVertexCount = 0;
+
+		for(size_t i = 0; i < vertexCount; ++i)
+		{
+			const float* p = position.At(i);
+
+			Cell lo;
+			Cell hi;
+			lo.X = CellCoord(p[0] - tolerance, invCellSize);
+			lo.Y = CellCoord(p[1] - tolerance, invCellSize);
+			lo.Z = CellCoord(p[2] - tolerance, invCellSize);
+			hi.X = CellCoord(p[0] + tolerance, invCellSize);
+			hi.Y = CellCoord(p[1] + tolerance, invCellSize);
+			hi.Z = CellCoord(p[2] + tolerance, invCellSize);
+
+			uint32 match = EmptySlot;
+
+			Cell c;
+			for(c.Z = lo.Z; ; ++c.Z)
+			{
+				for(c.Y = lo.Y; ; ++c.Y)
+				{
+					for(c.X = lo.X; ; ++c.X)
+					{
+						uint32 hash = HashCell(c);
+						for(uint32 slot = hash & mask; table[slot].Vertex != EmptySlot; slot = (slot + 1) & mask)
+						{
+							uint32 v = table[slot].Vertex;
+							if(table[slot].Hash == hash && v < match && cells[v] == c && Equal(streams, streamCount, v, i))
+								match = v;
+						}
+
+						if(c.X == hi.X)
+							break;
+					}
+
+					if(c.Y == hi.Y)
+						break;
+				}
+
+				if(c.Z == hi.Z)
+					break;
+			}
+
+			if(match != EmptySlot)
+			{
+				remap[i] = remap[match];
+				continue;
+			}
+
+			// A new vertex: file it under the cell it lies in.
+			Cell own;
+			own.X = CellCoord(p[0], invCellSize);
+			own.Y = CellCoord(p[1], invCellSize);
+			own.Z = CellCoord(p[2], invCellSize);
+			cells[i] = own;
+
+			uint32 hash = HashCell(own);
+			uint32 slot = hash & mask;
+			while(table[slot].Vertex != EmptySlot)
+				slot = (slot + 1) & mask;
+			table[slot].Vertex = (uint32)i;
+			table[slot].Hash = hash;
+
+			remap[i] = newVertexCount++;
+		}
+
+		return newVertexCount;
+	}
+
+	void AddStream(std::vector<Stream>& streams, const void* data, size_t stride, int offset, int components, float tolerance)
+	{
+		if(offset < 0)
+			return;
+
+		Stream s;
+		s.Data = static_cast<const char*>(data) + offset;
+		s.Stride = stride;
+		s.Components = components;
+		s.Tolerance = tolerance;
+		streams.push_back(s);
+	}
+}
+
+uint32 MeshWelder::BuildRemap(const void* vertices, size_t vertexCount,
+	const GeometryGenerator::VertexLayout& layout, const Options& options,
+	std::vector<uint32>& remap)
+{
+	std::vector<Stream> streams;
+	AddStream(streams, vertices, layout.Stride, layout.PositionOffset, 3, options.PositionTolerance);
+	AddStream(streams, vertices, layout.Stride, layout.NormalOffset, 3, options.NormalTolerance);
+	AddStream(streams, vertices, layout.Stride, layout.TangentUOffset, 3, options.TangentTolerance);
+	AddStream(streams, vertices, layout.Stride, layout.TexCOffset, 2, options.TexCTolerance);
+
+	if(layout.PositionOffset < 0)
+	{
+		// Nothing to hash by: keep every vertex.
+		remap.resize(vertexCount);
+		for(size_t i = 0; i < vertexCount; ++i)
+			remap[i] = (uint32)i;
+		return (uint32)vertexCount;
+	}
+
+	return ::BuildRemap(streams.data(), streams.size(), vertexCount, remap);
+}
+
+size_t MeshWelder::RemapIndices(uint32* indices, size_t indexCount, const std::vector<uint32>& remap)
+{
+	size_t written = 0;
+	for(size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		uint32 i0 = remap[indices[i + 0]];
+		uint32 i1 = remap[indices[i + 1]];
+		uint32 i2 = remap[indices[i + 2]];
+
+		if(i0 == i1 || i1 == i2 || i2 == i0)
+			continue;
+
+		indices[written++] = i0;
+		indices[written++] = i1;
+		indices[written++] = i2;
+	}
+
+	return written;
+}
+
+MeshWelder::Stats MeshWelder::Weld(GeometryGenerator::MeshData& meshData, const Options& options)
+{
+	GeometryGenerator::VertexLayout layout;
+	layout.Stride = sizeof(GeometryGenerator::Vertex);
+	layout.PositionOffset = offsetof(GeometryGenerator::Vertex, Position);
+	layout.NormalOffset = offsetof(GeometryGenerator::Vertex, Normal);
+	layout.TangentUOffset = offsetof(GeometryGenerator::Vertex, TangentU);
+	layout.TexCOffset = offsetof(GeometryGenerator::Vertex, TexC);
+
+	return Weld(meshData.Vertices, meshData.Indices32, layout, options);
+}
+
+MeshWelder::Stats MeshWelder::Weld(GeometryGenerator::MeshDataSoA& meshData, const Options& options)
+{
+	size_t vertexCount = meshData.VertexCount();
+
+	// Streams shorter than the positions are not in use and are left alone.
+	std::vector<Stream> streams;
+	AddStream(streams, meshData.Positions.data(), sizeof(XMFLOAT3), 0, 3, options.PositionTolerance);
+	if(meshData.Normals.size() == vertexCount)
+		AddStream(streams, meshData.Normals.data(), sizeof(XMFLOAT3), 0, 3, options.NormalTolerance);
+	if(meshData.TangentUs.size() == vertexCount)
+		AddStream(streams, meshData.TangentUs.data(), sizeof(XMFLOAT3), 0, 3, options.TangentTolerance);
+	if(meshData.TexCs.size() == vertexCount)
+		AddStream(streams, meshData.TexCs.data(), sizeof(XMFLOAT2), 0, 2, options.TexCTolerance);
+
+	std::vector<uint32> remap;
+	uint32 newVertexCount = ::BuildRemap(streams.data(), streams.size(), vertexCount, remap);
+
+	Stats stats;
+	stats.VertexCount = (uint32)vertexCount;
+	stats.WeldedVertexCount = newVertexCount;
+	stats.TriangleCount = (uint32)(meshData.Indices32.size() / 3);
+
+	size_t indexCount = RemapIndices(meshData.Indices32.data(), meshData.Indices32.size(), remap);
+	stats.DegenerateTriangles = stats.TriangleCount - (uint32)(indexCount / 3);
+	meshData.Indices32.resize(indexCount);
+
+	CompactVertices(meshData.Positions, remap, newVertexCount);
+	if(meshData.Normals.size() == vertexCount)
+		CompactVertices(meshData.Normals, remap, newVertexCount);
+	if(meshData.TangentUs.size() == vertexCount)
+		CompactVertices(meshData.TangentUs, remap, newVertexCount);
+	if(meshData.TexCs.size() == vertexCount)
+		CompactVertices(meshData.TexCs, remap, newVertexCount);
+
+	return stats;
+}
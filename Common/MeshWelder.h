@@ -0,0 +1,109 @@
+//***************************************************************************************
+// MeshWelder.h
+//
+// Merges duplicate vertices of an indexed mesh.  Two vertices are the same when
+// every attribute they carry (position, normal, tangent, texcoord) agrees within
+// its tolerance, so exact copies and near copies left by exporters collapse while
+// normal and UV seams stay split: a box keeps its 24 vertices.
+//
+// Vertices are hashed by their position snapped to a grid twice the position
+// tolerance wide.  A vertex within tolerance of another lies in one of at most
+// 8 cells around it, so each vertex probes those cells and compares only the
+// few vertices found there.  With a bounded number of vertices per cell this is
+// O(n) expected time and memory.
+//
+// Welding is first come, first kept: a vertex merges into the earliest kept
+// vertex that matches it, and every kept vertex is one of the input vertices.
+//***************************************************************************************
+
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <cstdint>
+#include <vector>
+
+class MeshWelder
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	// Largest per-component difference still treated as equal.  Zero welds
+	// exact copies only.
+	struct Options
+	{
+		float PositionTolerance = 1e-6f;
+		float NormalTolerance = 1e-3f;
+		float TangentTolerance = 1e-3f;
+		float TexCTolerance = 1e-5f;
+	};
+
+	struct Stats
+	{
+		uint32 VertexCount = 0;
+		uint32 WeldedVertexCount = 0;
+		uint32 TriangleCount = 0;
+		uint32 DegenerateTriangles = 0;     // removed because two corners merged
+	};
+
+	///<summary>
+	/// Finds the duplicates of vertexCount vertices described by layout, which
+	/// must have a position.  remap[oldIndex] receives the new index; new
+	/// indices follow the order in which kept vertices first appear.  Returns
+	/// the number of vertices kept.
+	///</summary>
+	static uint32 BuildRemap(const void* vertices, size_t vertexCount,
+		const GeometryGenerator::VertexLayout& layout, const Options& options,
+		std::vector<uint32>& remap);
+
+	///<summary>
+	/// Rewrites indices through remap and drops triangles whose corners merged.
+	/// Returns the new index count.
+	///</summary>
+	static size_t RemapIndices(uint32* indices, size_t indexCount, const std::vector<uint32>& remap);
+
+	///<summary>
+	/// Keeps the first vertex of every group found by BuildRemap, in new index
+	/// order.  Works with any vertex type.
+	///</summary>
+	template<typename T>
+	static void CompactVertices(std::vector<T>& vertices, const std::vector<uint32>& remap, uint32 newVertexCount)
+	{
+		std::vector<T> result(newVertexCount);
+		uint32 next = 0;
+		for(size_t i = 0; i < vertices.size(); ++i)
+		{
+			if(remap[i] == next)
+				result[next++] = vertices[i];
+		}
+
+		vertices.swap(result);
+	}
+
+	///<summary>
+	/// Welds an interleaved mesh in place: builds the remap, rewrites the index
+	/// list and compacts the vertices.
+	///</summary>
+	template<typename T>
+	static Stats Weld(std::vector<T>& vertices, std::vector<uint32>& indices,
+		const GeometryGenerator::VertexLayout& layout, const Options& options)
+	{
+		std::vector<uint32> remap;
+		uint32 newVertexCount = BuildRemap(vertices.data(), vertices.size(), layout, options, remap);
+
+		Stats stats;
+		stats.VertexCount = (uint32)vertices.size();
+		stats.WeldedVertexCount = newVertexCount;
+		stats.TriangleCount = (uint32)(indices.size() / 3);
+
+		size_t indexCount = RemapIndices(indices.data(), indices.size(), remap);
+		stats.DegenerateTriangles = stats.TriangleCount - (uint32)(indexCount / 3);
+		indices.resize(indexCount);
+
+		CompactVertices(vertices, remap, newVertexCount);
+		return stats;
+	}
+
+	static Stats Weld(GeometryGenerator::MeshData& meshData, const Options& options);
+	static Stats Weld(GeometryGenerator::MeshDataSoA& meshData, const Options& options);
+};
@@ -0,0 +1,224 @@
+//***************************************************************************************
+// MeshletBuilder.cpp
+//***************************************************************************************
+
+#include "MeshletBuilder.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+using uint8 = MeshletBuilder::uint8;
+using uint32 = MeshletBuilder::uint32;
+
+namespace
+{
+	const XMFLOAT3& PositionAt(const XMFLOAT3* positions, size_t positionStride, uint32 i)
+	{
+		return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const char*>(positions) + i*positionStride);
+	}
+}
+
+MeshletBuilder::MeshletData MeshletBuilder::Build(const uint32* indices, size_t indexCount,
+	const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+	uint32 maxVertices, uint32 maxTriangles)
+{
+	assert(indexCount % 3 == 0);
+	assert(maxVertices >= 3 && maxVertices <= 256);
+	assert(maxTriangles >= 1);
+
+	MeshletData result;
+	result.TriangleIndices.reserve(indexCount);
+	result.VertexIndices.reserve(indexCount / 3);
+
+	// Cluster-local number of each mesh vertex in the open cluster, or ~0u.
+	std::vector<uint32> localIndex(vertexCount, ~0u);
+
+	Meshlet current;
+
+	auto closeMeshlet = [&]()
+	{
+		for(uint32 i = 0; i < current.VertexCount; ++i)
+			localIndex[result.VertexIndices[current.VertexOffset + i]] = ~0u;
+
+		result.Meshlets.push_back(current);
+
+		current.VertexOffset += current.VertexCount;
+		current.TriangleOffset += current.TriangleCount;
+		current.VertexCount = 0;
+		current.TriangleCount = 0;
+	};
+
+	for(size_t t = 0; t < indexCount; t += 3)
+	{
+		const uint32* tri = indices + t;
+
+		uint32 newVertices = 0;
+		for(uint32 c = 0; c < 3; ++c)
+		{
+			if(localIndex[tri[c]] == ~0u && (c == 0 || tri[c] != tri[0]) && (c < 2 || tri[c] != tri[1]))
+				newVertices++;
+		}
+
+		if(current.VertexCount + newVertices > maxVertices || current.TriangleCount + 1 > maxTriangles)
+			closeMeshlet();
+
+		for(uint32 c = 0; c < 3; ++c)
+		{
+			uint32& local = localIndex[tri[c]];
+			if(local == ~0u)
+			{
+				local = current.VertexCount++;
+				result.VertexIndices.push_back(tri[c]);
+			}
+
+			result.TriangleIndices.push_back((uint8)local);
+		}
+
+		current.TriangleCount++;
+	}
+
+	if(current.TriangleCount > 0)
+		closeMeshlet();
+
+	result.Bounds.reserve(result.Meshlets.size());
+	for(const Meshlet& meshlet : result.Meshlets)
+		result.Bounds.push_back(ComputeBounds(result, meshlet, positions, positionStride));
+
+	return result;
+}
+
+MeshletBuilder::MeshletData MeshletBuilder::Build(const GeometryGenerator::MeshData& meshData,
+	uint32 maxVertices, uint32 maxTriangles)
+{
+	const XMFLOAT3* positions = meshData.Vertices.empty() ? nullptr : &meshData.Vertices[0].Position;
+
+	return Build(meshData.Indices32.data(), meshData.Indices32.size(),
+		positions, sizeof(GeometryGenerator::Vertex), meshData.Vertices.size(), maxVertices, maxTriangles);
+}
+
+MeshletBuilder::MeshletBounds MeshletBuilder::ComputeBounds(const MeshletData& meshlets, const Meshlet& meshlet,
+	const XMFLOAT3* positions, size_t positionStride)
+{
+	MeshletBounds bounds;
+
+	//
+	// Sphere and box over the cluster's vertices.
+	//
+
+	std::vector<XMFLOAT3> points(meshlet.VertexCount);
+	for(uint32 i = 0; i < meshlet.VertexCount; ++i)
+		points[i] = PositionAt(positions, positionStride, meshlets.VertexIndices[meshlet.VertexOffset + i]);
+
+	BoundingSphere::CreateFromPoints(bounds.Sphere, points.size(), points.data(), sizeof(XMFLOAT3));
+	BoundingBox::CreateFromPoints(bounds.Box, points.size(), points.data(), sizeof(XMFLOAT3));
+
+	//
+	// Normal cone: the axis is the average face normal, the cutoff comes from
+	// the face that deviates most from it.
+	//
+
+	const uint8* local = &meshlets.TriangleIndices[3*meshlet.TriangleOffset];
+
+	std::vector<XMVECTOR> normals;
+	normals.reserve(meshlet.TriangleCount);
+
+	XMVECTOR axis = XMVectorZero();
+	for(uint32 t = 0; t < meshlet.TriangleCount; ++t)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&points[local[3*t + 0]]);
+		XMVECTOR p1 = XMLoadFloat3(&points[local[3*t + 1]]);
+		XMVECTOR p2 = XMLoadFloat3(&points[local[3*t + 2]]);
+
+		// Degenerate triangles are invisible and say nothing about facing.
+		XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+		float length = XMVectorGetX(XMVector3Length(n));
+		if(length <= 0.0f)
+			continue;
+
+		n /= length;
+		normals.push_back(n);
+		axis += n;
+	}
+
+	float axisLength = XMVectorGetX(XMVector3Length(axis));
+	if(normals.empty() || axisLength <= 0.0f)
+		return bounds;
+
+	axis /= axisLength;
+
+	float minDot = 1.0f;
+	for(const XMVECTOR& n : normals)
+		minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(n, axis)));
+
+	// Past ~84 degrees of spread the cone would almost never cull anything, and
+	// the apex below would run off to infinity.
+	if(minDot <= 0.1f)
+		return bounds;
+
+	// Move the apex back along the axis until it lies behind every triangle's
+	// plane, so the test is exact for any eye position, not just distant ones.
+	XMVECTOR center = XMLoadFloat3(&bounds.Sphere.Center);
+	float maxT = 0.0f;
+	for(uint32 t = 0, k = 0; t < meshlet.TriangleCount; ++t)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&points[local[3*t + 0]]);
+		XMVECTOR p1 = XMLoadFloat3(&points[local[3*t + 1]]);
+		XMVECTOR p2 = XMLoadFloat3(&points[local[3*t + 2]]);
+		if(XMVectorGetX(XMVector3LengthSq(XMVector3Cross(p1 - p0, p2 - p0))) <= 0.0f)
+			continue;
+
+		const XMVECTOR& n = normals[k++];
+		float dc = XMVectorGetX(XMVector3Dot(center - p0, n));
+		float dn = XMVectorGetX(XMVector3Dot(axis, n));
+		maxT = std::max(maxT, dc / dn);
+	}
+
+	XMStoreFloat3(&bounds.ConeApex, center - axis*maxT);
+	XMStoreFloat3(&bounds.ConeAxis, axis);
+	bounds.ConeCutoff = sqrtf(1.0f - minDot*minDot);
+
+	return bounds;
+}
+
+ClusterCuller::CullStats ClusterCuller::Cull(const MeshletBuilder::MeshletData& meshlets,
+	const BoundingFrustum& frustum, const XMFLOAT3& eyePos,
+	uint32 startIndexLocation, std::vector<DrawRange>& ranges)
+{
+	CullStats stats;
+	stats.ClusterCount = (uint32)meshlets.Meshlets.size();
+	stats.TriangleCount = meshlets.TriangleCount();
+
+	ranges.clear();
+
+	XMVECTOR eye = XMLoadFloat3(&eyePos);
+
+	for(size_t i = 0; i < meshlets.Meshlets.size(); ++i)
+	{
+		const MeshletBuilder::Meshlet& meshlet = meshlets.Meshlets[i];
+		const MeshletBuilder::MeshletBounds& bounds = meshlets.Bounds[i];
+
+		if(frustum.Contains(bounds.Sphere) == DISJOINT)
+			continue;
+
+		if(bounds.ConeCutoff < 1.0f)
+		{
+			XMVECTOR toApex = XMVector3Normalize(XMLoadFloat3(&bounds.ConeApex) - eye);
+			if(XMVectorGetX(XMVector3Dot(toApex, XMLoadFloat3(&bounds.ConeAxis))) >= bounds.ConeCutoff)
+				continue;
+		}
+
+		stats.VisibleClusters++;
+		stats.VisibleTriangles += meshlet.TriangleCount;
+
+		uint32 start = startIndexLocation + 3*meshlet.TriangleOffset;
+		uint32 count = 3*meshlet.TriangleCount;
+		if(!ranges.empty() && ranges.back().StartIndexLocation + ranges.back().IndexCount == start)
+			ranges.back().IndexCount += count;
+		else
+			ranges.push_back({ start, count });
+	}
+
+	return stats;
+}
@@ -0,0 +1,123 @@
+//***************************************************************************************
+// MeshletBuilder.h
+//
+// Splits an indexed triangle list into small clusters (meshlets) of at most
+// MaxVertices vertices and MaxTriangles triangles, each with a bounding sphere,
+// an axis-aligned box and a backface normal cone, so whole clusters can be
+// culled on the CPU before they are submitted.
+//
+// The result is a handful of flat arrays:
+//   Meshlets        - one record per cluster, offsets into the two arrays below
+//   VertexIndices   - cluster-local vertex -> mesh vertex
+//   TriangleIndices - three cluster-local vertex numbers (bytes) per triangle
+//   Bounds          - culling data per cluster
+//
+// Clusters are contiguous runs of the input triangles, so the index list passed
+// to Build is already in cluster order: cluster i is its index range starting
+// at 3*Meshlets[i].TriangleOffset and can be drawn with DrawIndexedInstanced.
+//***************************************************************************************
+
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <cstdint>
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+#include <vector>
+
+class MeshletBuilder
+{
+public:
+
+	using uint8 = std::uint8_t;
+	using uint32 = std::uint32_t;
+
+	// 64 vertices / 124 triangles keeps a cluster within the sizes mesh shader
+	// hardware prefers, should the clusters ever be fed to one.
+	static const uint32 DefaultMaxVertices = 64;
+	static const uint32 DefaultMaxTriangles = 124;
+
+	struct Meshlet
+	{
+		uint32 VertexOffset = 0;    // first entry in VertexIndices
+		uint32 TriangleOffset = 0;  // first triangle; its bytes start at 3*TriangleOffset
+		uint32 VertexCount = 0;
+		uint32 TriangleCount = 0;
+	};
+
+	struct MeshletBounds
+	{
+		DirectX::BoundingSphere Sphere;
+		DirectX::BoundingBox Box;
+
+		// Every triangle of the cluster faces away from an eye at E when
+		// dot(normalize(ConeApex - E), ConeAxis) >= ConeCutoff.  ConeCutoff is 1
+		// when the normals spread too far for the test to ever pass.
+		DirectX::XMFLOAT3 ConeApex = { 0.0f, 0.0f, 0.0f };
+		DirectX::XMFLOAT3 ConeAxis = { 0.0f, 0.0f, 0.0f };
+		float ConeCutoff = 1.0f;
+	};
+
+	struct MeshletData
+	{
+		std::vector<Meshlet> Meshlets;
+		std::vector<uint32> VertexIndices;
+		std::vector<uint8> TriangleIndices;
+		std::vector<MeshletBounds> Bounds;
+
+		uint32 TriangleCount()const { return (uint32)(TriangleIndices.size() / 3); }
+	};
+
+	///<summary>
+	/// Cuts the triangle list into clusters in index order, so run it on a list
+	/// already ordered for the vertex cache (MeshOptimizer) to get tight
+	/// clusters.  positions points at the first position; consecutive positions
+	/// are positionStride bytes apart.  maxVertices may not exceed 256.
+	///</summary>
+	static MeshletData Build(const uint32* indices, size_t indexCount,
+		const DirectX::XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+		uint32 maxVertices = DefaultMaxVertices, uint32 maxTriangles = DefaultMaxTriangles);
+
+	static MeshletData Build(const GeometryGenerator::MeshData& meshData,
+		uint32 maxVertices = DefaultMaxVertices, uint32 maxTriangles = DefaultMaxTriangles);
+
+private:
+	static MeshletBounds ComputeBounds(const MeshletData& meshlets, const Meshlet& meshlet,
+		const DirectX::XMFLOAT3* positions, size_t positionStride);
+};
+
+///<summary>
+/// Rejects clusters outside the view frustum or facing away from the eye and
+/// returns the rest as index ranges ready to draw.
+///</summary>
+class ClusterCuller
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	// Consecutive visible clusters are merged into one range.
+	struct DrawRange
+	{
+		uint32 StartIndexLocation = 0;
+		uint32 IndexCount = 0;
+	};
+
+	struct CullStats
+	{
+		uint32 ClusterCount = 0;
+		uint32 VisibleClusters = 0;
+		uint32 TriangleCount = 0;
+		uint32 VisibleTriangles = 0;
+	};
+
+	///<summary>
+	/// frustum and eyePos must be in the mesh's local space.  startIndexLocation
+	/// is where the indices passed to MeshletBuilder::Build begin in the index
+	/// buffer.  ranges is overwritten.  The cone test assumes the world
+	/// transform does not mirror the mesh.
+	///</summary>
+	static CullStats Cull(const MeshletBuilder::MeshletData& meshlets,
+		const DirectX::BoundingFrustum& frustum, const DirectX::XMFLOAT3& eyePos,
+		uint32 startIndexLocation, std::vector<DrawRange>& ranges);
+};
@@ -0,0 +1,512 @@
+//***************************************************************************************
+// ModelReader.cpp
+//***************************************************************************************
+
+#include "ModelReader.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace DirectX;
+
+using uint32 = ModelReader::uint32;
+
+namespace
+{
+	// Walks the text buffer.  Every Read skips leading whitespace first.
+	struct Cursor
+	{
+		const char* Pos;
+		const char* End;
+
+		void SkipSpace()
+		{
+			while(Pos < End && (*Pos == ' ' || *Pos == '\t' || *Pos == '\r' || *Pos == '\n'))
+				++Pos;
+		}
+
+		bool Expect(const char* literal)
+		{
+			SkipSpace();
+
+			size_t length = std::strlen(literal);
+			if((size_t)(End - Pos) < length || std::memcmp(Pos, literal, length) != 0)
+				return false;
+
+			Pos += length;
+			return true;
+		}
+
+		bool SkipPast(char c)
+		{
+			const char* found = static_cast<const char*>(std::memchr(Pos, c, End - Pos));
+			if(found == nullptr)
+				return false;
+
+			Pos = found + 1;
+			return true;
+		}
+
+		template<typename T>
+		bool Read(T& value)
+		{
+			SkipSpace();
+
+			std::from_chars_result result = std::from_chars(Pos, End, value);
+			if(result.ec != std::errc())
+				return false;
+
+			Pos = result.ptr;
+			return true;
+		}
+
+		// True when nothing but whitespace is left on the current line.
+		bool AtLineEnd()
+		{
+			while(Pos < End && (*Pos == ' ' || *Pos == '\t' || *Pos == '\r'))
+				++Pos;
+			return Pos == End || *Pos == '\n';
+		}
+	};
+
+	struct Chunk
+	{
+		const char* Begin;
+		const char* End;
+		uint32 FirstRecord;
+		uint32 RecordCount;
+	};
+
+	// Chunks smaller than this are not worth a task of their own.
+	const size_t MinChunkBytes = 64*1024;
+
+	// Splits [begin, end) into at most maxChunks pieces that each end right
+	// after a newline, so no record straddles two chunks.
+	void SplitLines(const char* begin, const char* end, size_t maxChunks, std::vector<Chunk>& chunks)
+	{
+		size_t size = end - begin;
+		size_t chunkCount = std::max<size_t>(1, std::min(maxChunks, size / MinChunkBytes));
+
+		chunks.clear();
+		const char* chunkBegin = begin;
+		for(size_t i = 1; i <= chunkCount && chunkBegin < end; ++i)
+		{
+			const char* chunkEnd = end;
+			if(i < chunkCount)
+			{
+				const char* target = std::max(chunkBegin, begin + size*i/chunkCount);
+				const char* newline = static_cast<const char*>(std::memchr(target, '\n', end - target));
+				chunkEnd = newline != nullptr ? newline + 1 : end;
+			}
+
+			chunks.push_back({ chunkBegin, chunkEnd, 0, 0 });
+			chunkBegin = chunkEnd;
+		}
+	}
+
+	// Number of lines in [begin, end) holding anything but whitespace.
+	uint32 CountRecords(const char* begin, const char* end)
+	{
+		uint32 count = 0;
+		bool inRecord = false;
+		for(const char* p = begin; p < end; ++p)
+		{
+			char c = *p;
+			if(c == '\n')
+				inRecord = false;
+			else if(!inRecord && c != ' ' && c != '\t' && c != '\r')
+			{
+				inRecord = true;
+				++count;
+			}
+		}
+
+		return count;
+	}
+
+	// Both parsers store the index of the bad record in failed.  With
+	// wholeLines every record must also end its line, as the parallel parser
+	// counts records by lines.
+	bool ParseVertices(Cursor& cursor, uint32 first, uint32 count, bool wholeLines, ModelReader::Model& model,
+		XMFLOAT3& boundsMin, XMFLOAT3& boundsMax, uint32& failed)
+	{
+		XMVECTOR vMin = XMLoadFloat3(&boundsMin);
+		XMVECTOR vMax = XMLoadFloat3(&boundsMax);
+
+		for(uint32 i = first; i < first + count; ++i)
+		{
+			XMFLOAT3& p = model.Positions[i];
+			XMFLOAT3& n = model.Normals[i];
+			if(!cursor.Read(p.x) || !cursor.Read(p.y) || !cursor.Read(p.z) ||
+			   !cursor.Read(n.x) || !cursor.Read(n.y) || !cursor.Read(n.z) ||
+			   (wholeLines && !cursor.AtLineEnd()))
+			{
+				failed = i;
+				return false;
+			}
+
+			XMVECTOR P = XMLoadFloat3(&p);
+			vMin = XMVectorMin(vMin, P);
+			vMax = XMVectorMax(vMax, P);
+		}
+
+		XMStoreFloat3(&boundsMin, vMin);
+		XMStoreFloat3(&boundsMax, vMax);
+		return true;
+	}
+
+	bool ParseTriangles(Cursor& cursor, uint32 first, uint32 count, bool wholeLines, uint32 vertexCount,
+		uint32* indices, uint32& failed)
+	{
+		for(uint32 i = first; i < first + count; ++i)
+		{
+			uint32* triangle = indices + 3*(size_t)i;
+			for(int k = 0; k < 3; ++k)
+			{
+				if(!cursor.Read(triangle[k]) || triangle[k] >= vertexCount)
+				{
+					failed = i;
+					return false;
+				}
+			}
+
+			if(wholeLines && !cursor.AtLineEnd())
+			{
+				failed = i;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Fail(std::string* error, const std::string& message)
+	{
+		if(error != nullptr)
+			*error = message;
+		return false;
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool SameModel(const ModelReader::Model& a, const ModelReader::Model& b)
+	{
+		auto sameFloats = [](const std::vector<XMFLOAT3>& x, const std::vector<XMFLOAT3>& y)
+		{
+			return x.size() == y.size() && std::memcmp(x.data(), y.data(), x.size()*sizeof(XMFLOAT3)) == 0;
+		};
+
+		return sameFloats(a.Positions, b.Positions) && sameFloats(a.Normals, b.Normals) && a.Indices == b.Indices;
+	}
+}
+
+bool ModelReader::ParseHeader(const char* text, size_t size, Header& header, std::string* error)
+{
+	Cursor cursor = { text, text + size };
+
+	if(!cursor.Expect("VertexCount:") || !cursor.Read(header.VertexCount))
+		return Fail(error, "missing VertexCount");
+	if(!cursor.Expect("TriangleCount:") || !cursor.Read(header.TriangleCount))
+		return Fail(error, "missing TriangleCount");
+	if(!cursor.Expect("VertexList") || !cursor.SkipPast('{'))
+		return Fail(error, "missing VertexList");
+
+	header.VerticesBegin = cursor.Pos;
+	return true;
+}
+
+bool ModelReader::Parse(const char* text, size_t size, Model& model, std::string* error)
+{
+	Header header;
+	if(!ParseHeader(text, size, header, error))
+		return false;
+
+	model.Positions.resize(header.VertexCount);
+	model.Normals.resize(header.VertexCount);
+	model.Indices.resize(3*(size_t)header.TriangleCount);
+
+	XMFLOAT3 boundsMin = { +FLT_MAX, +FLT_MAX, +FLT_MAX };
+	XMFLOAT3 boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	uint32 failed = 0;
+	Cursor cursor = { header.VerticesBegin, text + size };
+	if(!ParseVertices(cursor, 0, header.VertexCount, false, model, boundsMin, boundsMax, failed))
+		return Fail(error, "bad vertex " + std::to_string(failed));
+
+	if(!cursor.Expect("}") || !cursor.Expect("TriangleList") || !cursor.SkipPast('{'))
+		return Fail(error, "missing TriangleList");
+
+	if(!ParseTriangles(cursor, 0, header.TriangleCount, false, header.VertexCount, model.Indices.data(), failed))
+		return Fail(error, "bad triangle " + std::to_string(failed));
+
+	if(!cursor.Expect("}"))
+		return Fail(error, "unterminated TriangleList");
+
+	if(header.VertexCount > 0)
+	{
+		model.BoundsMin = boundsMin;
+		model.BoundsMax = boundsMax;
+	}
+
+	return true;
+}
+
+bool ModelReader::ParseParallel(const char* text, size_t size, Model& model, ThreadPool& pool, std::string* error)
+{
+	const char* end = text + size;
+
+	Header header;
+	if(!ParseHeader(text, size, header, error))
+		return false;
+
+	//
+	// Locate both sections.  Neither holds a brace, so a plain scan finds them.
+	//
+
+	const char* verticesEnd = static_cast<const char*>(std::memchr(header.VerticesBegin, '}', end - header.VerticesBegin));
+	if(verticesEnd == nullptr)
+		return Fail(error, "unterminated VertexList");
+
+	Cursor cursor = { verticesEnd + 1, end };
+	if(!cursor.Expect("TriangleList") || !cursor.SkipPast('{'))
+		return Fail(error, "missing TriangleList");
+
+	const char* trianglesBegin = cursor.Pos;
+	const char* trianglesEnd = static_cast<const char*>(std::memchr(trianglesBegin, '}', end - trianglesBegin));
+	if(trianglesEnd == nullptr)
+		return Fail(error, "unterminated TriangleList");
+
+	model.Positions.resize(header.VertexCount);
+	model.Normals.resize(header.VertexCount);
+	model.Indices.resize(3*(size_t)header.TriangleCount);
+
+	//
+	// Cut each section at newlines, count the records of every chunk to know
+	// where its output starts, then parse all chunks straight into place.
+	//
+
+	size_t maxChunks = 4*((size_t)pool.ThreadCount() + 1);
+
+	std::vector<Chunk> vertexChunks;
+	std::vector<Chunk> triangleChunks;
+	SplitLines(header.VerticesBegin, verticesEnd, maxChunks, vertexChunks);
+	SplitLines(trianglesBegin, trianglesEnd, maxChunks, triangleChunks);
+
+	std::vector<Chunk*> chunks;
+	for(Chunk& chunk : vertexChunks)
+		chunks.push_back(&chunk);
+	for(Chunk& chunk : triangleChunks)
+		chunks.push_back(&chunk);
+
+	pool.ParallelFor((uint32)chunks.size(), [&](uint32 i)
+	{
+		chunks[i]->RecordCount = CountRecords(chunks[i]->Begin, chunks[i]->End);
+	});
+
+	auto assignRecords = [](std::vector<Chunk>& sectionChunks)
+	{
+		uint32 next = 0;
+		for(Chunk& chunk : sectionChunks)
+		{
+			chunk.FirstRecord = next;
+			next += chunk.RecordCount;
+		}
+		return next;
+	};
+
+	if(assignRecords(vertexChunks) != header.VertexCount)
+		return Fail(error, "VertexList does not hold VertexCount lines");
+	if(assignRecords(triangleChunks) != header.TriangleCount)
+		return Fail(error, "TriangleList does not hold TriangleCount lines");
+
+	std::vector<XMFLOAT3> chunkMin(vertexChunks.size(), XMFLOAT3(+FLT_MAX, +FLT_MAX, +FLT_MAX));
+	std::vector<XMFLOAT3> chunkMax(vertexChunks.size(), XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+	std::vector<char> chunkOk(chunks.size(), 0);
+	std::vector<uint32> chunkFailed(chunks.size(), 0);
+
+	pool.ParallelFor((uint32)chunks.size(), [&](uint32 i)
+	{
+		const Chunk& chunk = *chunks[i];
+		Cursor chunkCursor = { chunk.Begin, chunk.End };
+
+		chunkOk[i] = i < vertexChunks.size()
+			? ParseVertices(chunkCursor, chunk.FirstRecord, chunk.RecordCount, true, model,
+				chunkMin[i], chunkMax[i], chunkFailed[i])
+			: ParseTriangles(chunkCursor, chunk.FirstRecord, chunk.RecordCount, true, header.VertexCount,
+				model.Indices.data(), chunkFailed[i]);
+	});
+
+	// Chunks are in file order, so the first bad chunk holds the first bad record.
+	for(size_t i = 0; i < chunks.size(); ++i)
+	{
+		if(!chunkOk[i])
+		{
+			return Fail(error, (i < vertexChunks.size() ? "bad vertex " : "bad triangle ") +
+				std::to_string(chunkFailed[i]));
+		}
+	}
+
+	//
+	// Merge the per-chunk bounds.
+	//
+
+	if(header.VertexCount > 0)
+	{
+		XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+		XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+		for(size_t i = 0; i < vertexChunks.size(); ++i)
+		{
+			vMin = XMVectorMin(vMin, XMLoadFloat3(&chunkMin[i]));
+			vMax = XMVectorMax(vMax, XMLoadFloat3(&chunkMax[i]));
+		}
+
+		XMStoreFloat3(&model.BoundsMin, vMin);
+		XMStoreFloat3(&model.BoundsMax, vMax);
+	}
+
+	return true;
+}
+
+bool ModelReader::ReadFile(const std::string& filename, std::vector<char>& buffer)
+{
+	std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+	if(!fin)
+		return false;
+
+	std::streamoff size = fin.tellg();
+	if(size < 0)
+		return false;
+
+	buffer.resize((size_t)size);
+	fin.seekg(0, std::ios::beg);
+
+	return (bool)fin.read(buffer.data(), buffer.size());
+}
+
+bool ModelReader::Load(const std::string& filename, Model& model, std::string* error)
+{
+	std::vector<char> buffer;
+	if(!ReadFile(filename, buffer))
+		return Fail(error, filename + " not found");
+
+	// With a single worker the extra counting pass would only cost time.
+	ThreadPool& pool = ThreadPool::Default();
+	if(buffer.size() >= ParallelThreshold && pool.ThreadCount() > 1)
+		return ParseParallel(buffer.data(), buffer.size(), model, pool, error);
+
+	return Parse(buffer.data(), buffer.size(), model, error);
+}
+
+bool ModelReader::LoadWithStream(const std::string& filename, Model& model)
+{
+	std::ifstream fin(filename);
+	if(!fin)
+		return false;
+
+	uint32 vcount = 0;
+	uint32 tcount = 0;
+	std::string ignore;
+
+	fin >> ignore >> vcount;
+	fin >> ignore >> tcount;
+	fin >> ignore >> ignore >> ignore >> ignore;
+
+	model.Positions.resize(vcount);
+	model.Normals.resize(vcount);
+
+	XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+	XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+
+	for(uint32 i = 0; i < vcount; ++i)
+	{
+		XMFLOAT3& p = model.Positions[i];
+		XMFLOAT3& n = model.Normals[i];
+		fin >> p.x >> p.y >> p.z;
+		fin >> n.x >> n.y >> n.z;
+
+		XMVECTOR P = XMLoadFloat3(&p);
+		vMin = XMVectorMin(vMin, P);
+		vMax = XMVectorMax(vMax, P);
+	}
+
+	fin >> ignore;
+	fin >> ignore;
+	fin >> ignore;
+
+	model.Indices.resize(3*(size_t)tcount);
+	for(uint32 i = 0; i < tcount; ++i)
+		fin >> model.Indices[i*3 + 0] >> model.Indices[i*3 + 1] >> model.Indices[i*3 + 2];
+
+	if(vcount > 0)
+	{
+		XMStoreFloat3(&model.BoundsMin, vMin);
+		XMStoreFloat3(&model.BoundsMax, vMax);
+	}
+
+	return !fin.fail();
+}
+
+ModelReader::BenchmarkResult ModelReader::Benchmark(const std::string& filename, uint32 iterations)
+{
+	BenchmarkResult result;
+
+	std::vector<char> buffer;
+	if(!ReadFile(filename, buffer) || iterations == 0)
+		return result;
+
+	result.FileMegabytes = buffer.size() / (1024.0*1024.0);
+	result.FastMilliseconds = DBL_MAX;
+	result.StreamMilliseconds = DBL_MAX;
+
+	result.ParallelMilliseconds = DBL_MAX;
+
+	Model fast;
+	Model parallel;
+	Model stream;
+	bool fastOk = true;
+	bool parallelOk = true;
+	bool streamOk = true;
+	for(uint32 i = 0; i < iterations; ++i)
+	{
+		auto start = std::chrono::steady_clock::now();
+		fastOk = ReadFile(filename, buffer) && Parse(buffer.data(), buffer.size(), fast) && fastOk;
+		result.FastMilliseconds = std::min(result.FastMilliseconds, MillisecondsSince(start));
+
+		start = std::chrono::steady_clock::now();
+		parallelOk = ReadFile(filename, buffer) &&
+			ParseParallel(buffer.data(), buffer.size(), parallel, ThreadPool::Default()) && parallelOk;
+		result.ParallelMilliseconds = std::min(result.ParallelMilliseconds, MillisecondsSince(start));
+
+		start = std::chrono::steady_clock::now();
+		streamOk = LoadWithStream(filename, stream) && streamOk;
+		result.StreamMilliseconds = std::min(result.StreamMilliseconds, MillisecondsSince(start));
+	}
+
+	result.FastMBps = result.FileMegabytes / (result.FastMilliseconds / 1000.0);
+	result.ParallelMBps = result.FileMegabytes / (result.ParallelMilliseconds / 1000.0);
+	result.StreamMBps = result.FileMegabytes / (result.StreamMilliseconds / 1000.0);
+	result.Identical = fastOk && parallelOk && streamOk && SameModel(fast, stream) && SameModel(parallel, stream);
+
+	return result;
+}
+
+std::string ModelReader::ToString(const std::string& filename, const BenchmarkResult& result)
+{
+	std::ostringstream text;
+	text.precision(3);
+	text << std::fixed << filename << ": " << result.FileMegabytes << " MB, "
+		 << "from_chars " << result.FastMilliseconds << " ms (" << result.FastMBps << " MB/s), "
+		 << "parallel " << result.ParallelMilliseconds << " ms (" << result.ParallelMBps << " MB/s), "
+		 << "ifstream " << result.StreamMilliseconds << " ms (" << result.StreamMBps << " MB/s), "
+		 << (result.Identical ? "identical" : "MISMATCH");
+
+	return text.str();
+}
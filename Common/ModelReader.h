@@ -0,0 +1,115 @@
+//***************************************************************************************
+// ModelReader.h
+//
+// Reader for the text model format of Models/skull.txt and Models/car.txt:
+//
+//   VertexCount: N
+//   TriangleCount: M
+//   VertexList (pos, normal)
+//   {
+//       px py pz nx ny nz      (N lines)
+//   }
+//   TriangleList
+//   {
+//       i0 i1 i2               (M lines)
+//   }
+//
+// The file is read with one bulk read and parsed in a single pass with
+// std::from_chars: no iostreams, no locale, and no allocation beyond the file
+// buffer and the output arrays, which are sized from the counts up front.  The
+// bounding box is gathered while parsing.  Needs C++17.
+//
+// Large files are parsed on a ThreadPool: both sections are cut into
+// newline-aligned chunks, each chunk counts its lines to find where its output
+// starts, then all chunks parse straight into the shared arrays.  The result is
+// identical to the serial parse.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+class ModelReader
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	struct Model
+	{
+		std::vector<DirectX::XMFLOAT3> Positions;
+		std::vector<DirectX::XMFLOAT3> Normals;
+		std::vector<uint32> Indices;
+
+		DirectX::XMFLOAT3 BoundsMin = { 0.0f, 0.0f, 0.0f };
+		DirectX::XMFLOAT3 BoundsMax = { 0.0f, 0.0f, 0.0f };
+	};
+
+	///<summary>
+	/// Parses a whole model held in memory.  On failure returns false and, if
+	/// error is given, describes what was wrong.
+	///</summary>
+	static bool Parse(const char* text, size_t size, Model& model, std::string* error = nullptr);
+
+	///<summary>
+	/// Same result as Parse, with the work spread over pool.  Every line of the
+	/// two lists must hold exactly one record.
+	///</summary>
+	static bool ParseParallel(const char* text, size_t size, Model& model, ThreadPool& pool, std::string* error = nullptr);
+
+	// Files at least this large are parsed in parallel by Load.
+	static const size_t ParallelThreshold = 1024*1024;
+
+	///<summary>
+	/// Reads filename in one go and parses it, in parallel on
+	/// ThreadPool::Default() when it is large and the pool has workers.
+	///</summary>
+	static bool Load(const std::string& filename, Model& model, std::string* error = nullptr);
+
+	///<summary>
+	/// The reference reader: the std::ifstream >> loop the demos used before.
+	/// Kept for the benchmark and as a fallback to compare against.
+	///</summary>
+	static bool LoadWithStream(const std::string& filename, Model& model);
+
+	struct BenchmarkResult
+	{
+		double FileMegabytes = 0.0;
+		double FastMilliseconds = 0.0;     // best of the iterations
+		double ParallelMilliseconds = 0.0;
+		double StreamMilliseconds = 0.0;
+		double FastMBps = 0.0;
+		double ParallelMBps = 0.0;
+		double StreamMBps = 0.0;
+		bool Identical = false;            // all readers produced the same model
+	};
+
+	///<summary>
+	/// Times the serial and parallel parsers against LoadWithStream on
+	/// filename, file read included, and reports the best run of each in MB/s.
+	///</summary>
+	static BenchmarkResult Benchmark(const std::string& filename, uint32 iterations = 5);
+
+	// Human-readable one-line summary of a benchmark run.
+	static std::string ToString(const std::string& filename, const BenchmarkResult& result);
+
+	///<summary>
+	/// Reads a whole file into buffer with a single read.
+	///</summary>
+	static bool ReadFile(const std::string& filename, std::vector<char>& buffer);
+
+private:
+	struct Header
+	{
+		uint32 VertexCount = 0;
+		uint32 TriangleCount = 0;
+		const char* VerticesBegin = nullptr;    // just past the VertexList brace
+	};
+
+	static bool ParseHeader(const char* text, size_t size, Header& header, std::string* error);
+};
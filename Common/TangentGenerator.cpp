@@ -0,0 +1,282 @@
+//***************************************************************************************
+// TangentGenerator.cpp
+//***************************************************************************************
+
+#include "TangentGenerator.h"
+#include "ThreadPool.h"
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+using uint32 = TangentGenerator::uint32;
+
+namespace
+{
+	// Elements per ParallelFor task.  Large enough that scheduling is noise next
+	// to the work.
+	const uint32 ChunkSize = 16384;
+
+	template<typename Fn>
+	void ForEachChunk(ThreadPool& pool, size_t count, const Fn& fn)
+	{
+		uint32 chunkCount = (uint32)((count + ChunkSize - 1) / ChunkSize);
+		if(chunkCount <= 1)
+		{
+			fn((size_t)0, count);
+			return;
+		}
+
+		pool.ParallelFor(chunkCount, [&](uint32 chunk)
+		{
+			size_t begin = (size_t)chunk * ChunkSize;
+			size_t end = begin + ChunkSize < count ? begin + ChunkSize : count;
+			fn(begin, end);
+		});
+	}
+
+	// For every vertex, the face corners (3*triangle + corner) that reference it:
+	// Corners[Offsets[v]] to Corners[Offsets[v + 1]].
+	struct Adjacency
+	{
+		std::vector<uint32> Offsets;
+		std::vector<uint32> Corners;
+	};
+
+	void BuildAdjacency(const uint32* indices, size_t indexCount, size_t vertexCount, Adjacency& adjacency)
+	{
+		adjacency.Offsets.assign(vertexCount + 1, 0);
+		adjacency.Corners.resize(indexCount);
+
+		for(size_t i = 0; i < indexCount; ++i)
+		{
+			assert(indices[i] < vertexCount);
+			adjacency.Offsets[indices[i] + 1]++;
+		}
+
+		for(size_t v = 0; v < vertexCount; ++v)
+			adjacency.Offsets[v + 1] += adjacency.Offsets[v];
+
+		// Fill with a running cursor per vertex, then shift the offsets back.
+		for(size_t i = 0; i < indexCount; ++i)
+			adjacency.Corners[adjacency.Offsets[indices[i]]++] = (uint32)i;
+
+		for(size_t v = vertexCount; v > 0; --v)
+			adjacency.Offsets[v] = adjacency.Offsets[v - 1];
+		adjacency.Offsets[0] = 0;
+	}
+
+	float AngleBetween(FXMVECTOR a, FXMVECTOR b)
+	{
+		float sine = XMVectorGetX(XMVector3Length(XMVector3Cross(a, b)));
+		float cosine = XMVectorGetX(XMVector3Dot(a, b));
+		return std::atan2(sine, cosine);
+	}
+
+	// Interior angles of triangle (p0, p1, p2) at each corner.
+	void CornerAngles(FXMVECTOR p0, FXMVECTOR p1, FXMVECTOR p2, float angles[3])
+	{
+		angles[0] = AngleBetween(p1 - p0, p2 - p0);
+		angles[1] = AngleBetween(p2 - p1, p0 - p1);
+		angles[2] = AngleBetween(p0 - p2, p1 - p2);
+	}
+
+	// Any unit vector orthogonal to n, for vertices the UVs say nothing about.
+	XMVECTOR AnyOrthogonal(FXMVECTOR n)
+	{
+		XMVECTOR axis = std::fabs(XMVectorGetX(n)) < 0.9f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		XMVECTOR t = axis - n*XMVector3Dot(n, axis);
+		return XMVectorGetX(XMVector3LengthSq(t)) > 0.0f ? XMVector3Normalize(t) : XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+	}
+
+	// Component of v in the plane of unit vector n, normalized; zero if v has
+	// none.
+	XMVECTOR ProjectOntoPlane(FXMVECTOR v, FXMVECTOR n)
+	{
+		XMVECTOR p = v - n*XMVector3Dot(n, v);
+		float lengthSq = XMVectorGetX(XMVector3LengthSq(p));
+		return lengthSq > 1e-20f ? p / std::sqrt(lengthSq) : XMVectorZero();
+	}
+}
+
+void TangentGenerator::ComputeNormals(const XMFLOAT3* positions, size_t vertexCount,
+	const uint32* indices, size_t indexCount, NormalWeighting weighting,
+	XMFLOAT3* normals, ThreadPool& pool)
+{
+	size_t triangleCount = indexCount / 3;
+
+	//
+	// Per face: its unit normal and the weight of each of its corners.
+	//
+
+	std::vector<XMFLOAT3> faceNormals(triangleCount);
+	std::vector<float> cornerWeights(3*triangleCount);
+
+	ForEachChunk(pool, triangleCount, [&](size_t begin, size_t end)
+	{
+		for(size_t t = begin; t < end; ++t)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&positions[indices[3*t + 0]]);
+			XMVECTOR p1 = XMLoadFloat3(&positions[indices[3*t + 1]]);
+			XMVECTOR p2 = XMLoadFloat3(&positions[indices[3*t + 2]]);
+
+			XMVECTOR c = XMVector3Cross(p1 - p0, p2 - p0);
+			float doubleArea = XMVectorGetX(XMVector3Length(c));
+			XMStoreFloat3(&faceNormals[t], doubleArea > 0.0f ? c / doubleArea : XMVectorZero());
+
+			float angles[3] = { 1.0f, 1.0f, 1.0f };
+			if(weighting != NormalWeighting::Area)
+				CornerAngles(p0, p1, p2, angles);
+
+			float area = weighting != NormalWeighting::Angle ? 0.5f*doubleArea : 1.0f;
+			for(int k = 0; k < 3; ++k)
+				cornerWeights[3*t + k] = area*angles[k];
+		}
+	});
+
+	//
+	// Per vertex: gather the faces around it.
+	//
+
+	Adjacency adjacency;
+	BuildAdjacency(indices, 3*triangleCount, vertexCount, adjacency);
+
+	ForEachChunk(pool, vertexCount, [&](size_t begin, size_t end)
+	{
+		for(size_t v = begin; v < end; ++v)
+		{
+			XMVECTOR n = XMVectorZero();
+			for(uint32 i = adjacency.Offsets[v]; i < adjacency.Offsets[v + 1]; ++i)
+			{
+				uint32 corner = adjacency.Corners[i];
+				n += cornerWeights[corner] * XMLoadFloat3(&faceNormals[corner / 3]);
+			}
+
+			float lengthSq = XMVectorGetX(XMVector3LengthSq(n));
+			XMStoreFloat3(&normals[v], lengthSq > 0.0f ? n / std::sqrt(lengthSq) : XMVectorZero());
+		}
+	});
+}
+
+void TangentGenerator::ComputeTangents(const XMFLOAT3* positions, const XMFLOAT3* normals,
+	const XMFLOAT2* texCs, size_t vertexCount,
+	const uint32* indices, size_t indexCount,
+	XMFLOAT3* tangents, float* signs, ThreadPool& pool)
+{
+	size_t triangleCount = indexCount / 3;
+
+	//
+	// Per face: the directions of increasing u and v over the face, and the
+	// angle at each corner.
+	//
+
+	std::vector<XMFLOAT3> faceTangents(triangleCount);
+	std::vector<XMFLOAT3> faceBitangents(triangleCount);
+	std::vector<float> cornerAngles(3*triangleCount);
+
+	ForEachChunk(pool, triangleCount, [&](size_t begin, size_t end)
+	{
+		for(size_t t = begin; t < end; ++t)
+		{
+			uint32 i0 = indices[3*t + 0];
+			uint32 i1 = indices[3*t + 1];
+			uint32 i2 = indices[3*t + 2];
+
+			XMVECTOR p0 = XMLoadFloat3(&positions[i0]);
+			XMVECTOR p1 = XMLoadFloat3(&positions[i1]);
+			XMVECTOR p2 = XMLoadFloat3(&positions[i2]);
+			CornerAngles(p0, p1, p2, &cornerAngles[3*t]);
+
+			XMVECTOR e1 = p1 - p0;
+			XMVECTOR e2 = p2 - p0;
+
+			float du1 = texCs[i1].x - texCs[i0].x;
+			float dv1 = texCs[i1].y - texCs[i0].y;
+			float du2 = texCs[i2].x - texCs[i0].x;
+			float dv2 = texCs[i2].y - texCs[i0].y;
+
+			// Solve e1 = du1*T + dv1*B, e2 = du2*T + dv2*B.  Only the directions
+			// are kept, so the determinant's magnitude does not matter, only
+			// its sign.
+			float det = du1*dv2 - du2*dv1;
+			XMVECTOR tangent = XMVectorZero();
+			XMVECTOR bitangent = XMVectorZero();
+			if(std::fabs(det) > 1e-20f)
+			{
+				float s = det > 0.0f ? 1.0f : -1.0f;
+				tangent = XMVector3Normalize(s*(e1*dv2 - e2*dv1));
+				bitangent = XMVector3Normalize(s*(e2*du1 - e1*du2));
+			}
+
+			XMStoreFloat3(&faceTangents[t], tangent);
+			XMStoreFloat3(&faceBitangents[t], bitangent);
+		}
+	});
+
+	//
+	// Per vertex: project each corner's tangent onto the normal plane and sum
+	// them weighted by angle.  The bitangents only decide the sign, which
+	// cross(n, tangent) already confines to the plane, so they are summed as
+	// they are.
+	//
+
+	Adjacency adjacency;
+	BuildAdjacency(indices, 3*triangleCount, vertexCount, adjacency);
+
+	ForEachChunk(pool, vertexCount, [&](size_t begin, size_t end)
+	{
+		for(size_t v = begin; v < end; ++v)
+		{
+			XMVECTOR n = XMLoadFloat3(&normals[v]);
+
+			XMVECTOR tangent = XMVectorZero();
+			XMVECTOR bitangent = XMVectorZero();
+			for(uint32 i = adjacency.Offsets[v]; i < adjacency.Offsets[v + 1]; ++i)
+			{
+				uint32 corner = adjacency.Corners[i];
+				float angle = cornerAngles[corner];
+				tangent += angle * ProjectOntoPlane(XMLoadFloat3(&faceTangents[corner / 3]), n);
+				bitangent += angle * XMLoadFloat3(&faceBitangents[corner / 3]);
+			}
+
+			tangent = ProjectOntoPlane(tangent, n);
+			if(XMVector3Equal(tangent, XMVectorZero()))
+				tangent = AnyOrthogonal(n);
+
+			XMStoreFloat3(&tangents[v], tangent);
+
+			if(signs != nullptr)
+				signs[v] = XMVectorGetX(XMVector3Dot(XMVector3Cross(n, tangent), bitangent)) < 0.0f ? -1.0f : 1.0f;
+		}
+	});
+}
+
+void TangentGenerator::Generate(GeometryGenerator::MeshDataSoA& meshData, NormalWeighting weighting,
+	std::vector<float>* tangentSigns)
+{
+	size_t vertexCount = meshData.VertexCount();
+
+	meshData.Normals.resize(vertexCount);
+	ComputeNormals(meshData.Positions.data(), vertexCount,
+		meshData.Indices32.data(), meshData.Indices32.size(), weighting,
+		meshData.Normals.data(), ThreadPool::Default());
+
+	if(meshData.TexCs.size() == vertexCount)
+		GenerateTangents(meshData, tangentSigns);
+}
+
+void TangentGenerator::GenerateTangents(GeometryGenerator::MeshDataSoA& meshData,
+	std::vector<float>* tangentSigns)
+{
+	size_t vertexCount = meshData.VertexCount();
+	assert(meshData.Normals.size() == vertexCount && meshData.TexCs.size() == vertexCount);
+
+	meshData.TangentUs.resize(vertexCount);
+	if(tangentSigns != nullptr)
+		tangentSigns->resize(vertexCount);
+
+	ComputeTangents(meshData.Positions.data(), meshData.Normals.data(), meshData.TexCs.data(), vertexCount,
+		meshData.Indices32.data(), meshData.Indices32.size(),
+		meshData.TangentUs.data(), tangentSigns != nullptr ? tangentSigns->data() : nullptr,
+		ThreadPool::Default());
+}
@@ -0,0 +1,82 @@
+//***************************************************************************************
+// TangentGenerator.h
+//
+// Vertex normals and tangent frames for any indexed triangle list, for meshes
+// that do not come with them (imported models, welded or simplified meshes).
+// GeometryGenerator's shapes have analytic frames and do not need this.
+//
+// Normals are the weighted sum of the normals of the faces around each vertex,
+// weighted by face area, by the angle of the face at the vertex, or by both.
+//
+// Tangents follow the MikkTSpace construction: every face corner gets the
+// face's UV-derived tangent and bitangent projected onto the vertex normal's
+// plane, the corners are summed weighted by their angle, and the result is
+// orthogonalized against the normal.  The handedness sign is +1 when
+// cross(normal, tangent) points along the bitangent, so the shader rebuilds
+//
+//   bitangent = sign * cross(normal, tangent)
+//
+// Unlike MikkTSpace, vertices are never split: a vertex shared by faces of
+// opposite handedness (a mirrored UV seam that was welded) gets the sign of its
+// angle-weighted majority.  Weld with the UVs compared to keep such seams split.
+//
+// The work runs in two parallel passes over flat arrays, one per face and one
+// per vertex.  A vertex-to-corner adjacency in compressed rows (one offset per
+// vertex, one entry per face corner) lets each vertex gather its faces without
+// locks or per-vertex allocations.
+//***************************************************************************************
+
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+class ThreadPool;
+
+class TangentGenerator
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	enum class NormalWeighting
+	{
+		Area,           // large faces dominate; cheapest
+		Angle,          // independent of tessellation
+		AreaAngle
+	};
+
+	///<summary>
+	/// Writes vertexCount normals.  Vertices no triangle uses get a zero normal.
+	///</summary>
+	static void ComputeNormals(const DirectX::XMFLOAT3* positions, size_t vertexCount,
+		const uint32* indices, size_t indexCount, NormalWeighting weighting,
+		DirectX::XMFLOAT3* normals, ThreadPool& pool);
+
+	///<summary>
+	/// Writes vertexCount unit tangents orthogonal to normals and, if signs is
+	/// not null, their handedness (+1 or -1).  Where the UVs give no direction
+	/// (degenerate or unused vertices) any unit vector orthogonal to the normal
+	/// is used.
+	///</summary>
+	static void ComputeTangents(const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* normals,
+		const DirectX::XMFLOAT2* texCs, size_t vertexCount,
+		const uint32* indices, size_t indexCount,
+		DirectX::XMFLOAT3* tangents, float* signs, ThreadPool& pool);
+
+	///<summary>
+	/// Fills meshData.Normals and, when meshData has texcoords, TangentUs, on
+	/// ThreadPool::Default().  tangentSigns, if given, receives the handedness
+	/// of each tangent.
+	///</summary>
+	static void Generate(GeometryGenerator::MeshDataSoA& meshData, NormalWeighting weighting,
+		std::vector<float>* tangentSigns = nullptr);
+
+	///<summary>
+	/// Same, keeping the existing normals and only building tangents.
+	///</summary>
+	static void GenerateTangents(GeometryGenerator::MeshDataSoA& meshData,
+		std::vector<float>* tangentSigns = nullptr);
+};
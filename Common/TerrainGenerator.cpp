@@ -0,0 +1,571 @@
+//***************************************************************************************
+// TerrainGenerator.cpp
+//***************************************************************************************
+
+#include "TerrainGenerator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+using namespace DirectX;
+
+using uint32 = TerrainGenerator::uint32;
+
+namespace
+{
+	// Skirt edges, in the order their vertices follow the grid.
+	enum SkirtEdge
+	{
+		SkirtBottom = 0,    // row 0, along +x
+		SkirtTop,           // row Resolution, along +x
+		SkirtLeft,          // column 0, along +z
+		SkirtRight          // column Resolution, along +z
+	};
+
+	uint32 SkirtVertex(uint32 resolution, uint32 edge, uint32 k)
+	{
+		return (resolution + 1)*(resolution + 1) + edge*(resolution + 1) + k;
+	}
+
+	uint32 GridRow(uint32 resolution, uint32 edge, uint32 k)
+	{
+		switch(edge)
+		{
+		case SkirtBottom: return 0;
+		case SkirtTop: return resolution;
+		default: return k;
+		}
+	}
+
+	uint32 GridColumn(uint32 resolution, uint32 edge, uint32 k)
+	{
+		switch(edge)
+		{
+		case SkirtLeft: return 0;
+		case SkirtRight: return resolution;
+		default: return k;
+		}
+	}
+
+	template<typename T>
+	size_t CapacityBytes(const std::vector<T>& v)
+	{
+		return v.capacity()*sizeof(T);
+	}
+}
+
+size_t TerrainGenerator::Chunk::ByteSize()const
+{
+	return sizeof(Chunk) + CapacityBytes(Mesh.Positions) + CapacityBytes(Mesh.Normals)
+		+ CapacityBytes(Mesh.TangentUs) + CapacityBytes(Mesh.TexCs);
+}
+
+uint32 TerrainGenerator::MaxLodCount(uint32 resolution)
+{
+	uint32 count = 0;
+	while((resolution >> count) >= 2)
+		++count;
+	return count;
+}
+
+std::unique_ptr<TerrainGenerator::Chunk> TerrainGenerator::BuildChunk(const Settings& settings, const HeightFunction& height,
+	int x, int z, ThreadPool* pool)
+{
+	uint32 r = settings.Resolution;
+	assert(r >= 2 && (r & (r - 1)) == 0);
+
+	float spacing = settings.ChunkSize / r;
+	int firstX = x*(int)r;
+	int firstZ = z*(int)r;
+
+	//
+	// Heights with a one sample border, so normals at the edges use the same
+	// neighbours as in the adjacent chunk.
+	//
+
+	uint32 paddedSize = r + 3;
+	std::vector<float> heights(paddedSize*paddedSize);
+
+	auto sampleRow = [&](uint32 row)
+	{
+		float wz = (float)(firstZ + (int)row - 1) * spacing;
+		for(uint32 col = 0; col < paddedSize; ++col)
+		{
+			float wx = (float)(firstX + (int)col - 1) * spacing;
+			heights[row*paddedSize + col] = height(wx, wz);
+		}
+	};
+
+	if(pool != nullptr)
+		pool->ParallelFor(paddedSize, sampleRow);
+	else
+	{
+		for(uint32 row = 0; row < paddedSize; ++row)
+			sampleRow(row);
+	}
+
+	auto heightAt = [&](int i, int j) { return heights[(i + 1)*(int)paddedSize + (j + 1)]; };
+
+	//
+	// Grid vertices.
+	//
+
+	auto chunk = std::make_unique<Chunk>();
+	chunk->X = x;
+	chunk->Z = z;
+
+	GeometryGenerator::MeshDataSoA& mesh = chunk->Mesh;
+	mesh.ResizeVertices(VertexCount(settings));
+
+	float invTwoSpacing = 0.5f / spacing;
+	for(uint32 i = 0; i <= r; ++i)
+	{
+		float wz = (float)(firstZ + (int)i) * spacing;
+		for(uint32 j = 0; j <= r; ++j)
+		{
+			float wx = (float)(firstX + (int)j) * spacing;
+			uint32 v = i*(r + 1) + j;
+
+			int row = (int)i;
+			int col = (int)j;
+			float dhdx = (heightAt(row, col + 1) - heightAt(row, col - 1)) * invTwoSpacing;
+			float dhdz = (heightAt(row + 1, col) - heightAt(row - 1, col)) * invTwoSpacing;
+
+			mesh.Positions[v] = XMFLOAT3(wx, heightAt(row, col), wz);
+			XMStoreFloat3(&mesh.Normals[v], XMVector3Normalize(XMVectorSet(-dhdx, 1.0f, -dhdz, 0.0f)));
+			XMStoreFloat3(&mesh.TangentUs[v], XMVector3Normalize(XMVectorSet(1.0f, dhdx, 0.0f, 0.0f)));
+
+			// Stretch the texture over each chunk; v runs towards -z as in CreateGrid.
+			mesh.TexCs[v] = XMFLOAT2((float)j / r, (float)(r - i) / r);
+		}
+	}
+
+	//
+	// Skirt vertices: the border vertices again, lowered.
+	//
+
+	for(uint32 edge = 0; edge < 4; ++edge)
+	{
+		for(uint32 k = 0; k <= r; ++k)
+		{
+			uint32 src = GridRow(r, edge, k)*(r + 1) + GridColumn(r, edge, k);
+			uint32 dst = SkirtVertex(r, edge, k);
+
+			mesh.Positions[dst] = mesh.Positions[src];
+			mesh.Positions[dst].y -= settings.SkirtDepth;
+			mesh.Normals[dst] = mesh.Normals[src];
+			mesh.TangentUs[dst] = mesh.TangentUs[src];
+			mesh.TexCs[dst] = mesh.TexCs[src];
+		}
+	}
+
+	BoundingBox::CreateFromPoints(chunk->Bounds, mesh.Positions.size(), mesh.Positions.data(), sizeof(XMFLOAT3));
+
+	return chunk;
+}
+
+std::vector<uint32> TerrainGenerator::BuildIndices(uint32 resolution, uint32 lod, uint32 stitchMask, bool skirts)
+{
+	uint32 r = resolution;
+	uint32 step = 1u << lod;
+	uint32 cells = r / step;
+	assert(cells >= 1);
+
+	// Stitching needs an even number of cells along the edge.
+	if(cells < 2)
+		stitchMask = 0;
+
+	// Grid vertex (i, j) with the odd vertices of stitched edges folded onto
+	// the even vertex before them.
+	auto vertex = [&](uint32 i, uint32 j)
+	{
+		if((stitchMask & StitchBottom) && i == 0 && (j / step) % 2 == 1)
+			j -= step;
+		else if((stitchMask & StitchTop) && i == r && (j / step) % 2 == 1)
+			j -= step;
+		else if((stitchMask & StitchLeft) && j == 0 && (i / step) % 2 == 1)
+			i -= step;
+		else if((stitchMask & StitchRight) && j == r && (i / step) % 2 == 1)
+			i -= step;
+
+		return i*(r + 1) + j;
+	};
+
+	std::vector<uint32> indices;
+	indices.reserve(6*cells*cells + (skirts ? 24*cells : 0));
+
+	auto addTriangle = [&](uint32 a, uint32 b, uint32 c)
+	{
+		// Folded edges leave some triangles with a repeated corner.
+		if(a == b || b == c || c == a)
+			return;
+
+		indices.push_back(a);
+		indices.push_back(b);
+		indices.push_back(c);
+	};
+
+	// False for a triangle that folding turned inside out or flattened into a
+	// line.  Triangles with a repeated corner are dropped anyway.
+	auto upright = [&](uint32 a, uint32 b, uint32 c)
+	{
+		if(a == b || b == c || c == a)
+			return true;
+
+		int ax = (int)(a % (r + 1)), az = (int)(a / (r + 1));
+		int bx = (int)(b % (r + 1)), bz = (int)(b / (r + 1));
+		int cx = (int)(c % (r + 1)), cz = (int)(c / (r + 1));
+		return (bz - az)*(cx - ax) - (bx - ax)*(cz - az) > 0;
+	};
+
+	//
+	// Surface: rows run along +z, columns along +x.
+	//
+
+	for(uint32 i = 0; i < r; i += step)
+	{
+		for(uint32 j = 0; j < r; j += step)
+		{
+			uint32 v00 = vertex(i, j);
+			uint32 v01 = vertex(i, j + step);
+			uint32 v10 = vertex(i + step, j);
+			uint32 v11 = vertex(i + step, j + step);
+
+			// Where two stitched edges meet, folding can flatten a triangle of
+			// the usual diagonal; the other diagonal then fits.
+			if(upright(v00, v10, v01) && upright(v01, v10, v11))
+			{
+				addTriangle(v00, v10, v01);
+				addTriangle(v01, v10, v11);
+			}
+			else
+			{
+				addTriangle(v00, v10, v11);
+				addTriangle(v00, v11, v01);
+			}
+		}
+	}
+
+	if(!skirts)
+		return indices;
+
+	//
+	// Skirts, one quad below each edge segment left by the stitching.
+	//
+
+	const uint32 edgeStitch[4] = { StitchBottom, StitchTop, StitchLeft, StitchRight };
+
+	for(uint32 edge = 0; edge < 4; ++edge)
+	{
+		uint32 edgeStep = (stitchMask & edgeStitch[edge]) ? 2*step : step;
+
+		// Bottom and right edges run clockwise seen from outside, top and left
+		// the other way.
+		bool flip = edge == SkirtTop || edge == SkirtLeft;
+
+		for(uint32 k = 0; k < r; k += edgeStep)
+		{
+			uint32 top0 = vertex(GridRow(r, edge, k), GridColumn(r, edge, k));
+			uint32 top1 = vertex(GridRow(r, edge, k + edgeStep), GridColumn(r, edge, k + edgeStep));
+			uint32 bottom0 = SkirtVertex(r, edge, k);
+			uint32 bottom1 = SkirtVertex(r, edge, k + edgeStep);
+
+			if(flip)
+			{
+				addTriangle(top0, bottom0, top1);
+				addTriangle(bottom0, bottom1, top1);
+			}
+			else
+			{
+				addTriangle(top0, top1, bottom0);
+				addTriangle(bottom0, top1, bottom1);
+			}
+		}
+	}
+
+	return indices;
+}
+
+IndexPatternCache::Region TerrainGenerator::FindIndices(IndexPatternCache& patterns,
+	uint32 resolution, uint32 lod, uint32 stitchMask, bool skirts)
+{
+	std::uint64_t key = IndexPatternCache::MakeKey(IndexPatternCache::PatternKind::TerrainPatch,
+		resolution, lod, stitchMask, skirts ? 1 : 0);
+
+	return patterns.Find(key, [&](std::vector<uint32>& indices)
+	{
+		std::vector<uint32> pattern = BuildIndices(resolution, lod, stitchMask, skirts);
+		indices.insert(indices.end(), pattern.begin(), pattern.end());
+	});
+}
+
+void TerrainGenerator::AddAllIndices(IndexPatternCache& patterns, uint32 resolution, uint32 lodCount, bool skirts)
+{
+	for(uint32 lod = 0; lod < lodCount; ++lod)
+	{
+		for(uint32 mask = 0; mask < 16; ++mask)
+			FindIndices(patterns, resolution, lod, mask, skirts);
+	}
+}
+
+TerrainStreamer::TerrainStreamer(const Settings& settings, TerrainGenerator::HeightFunction height, ThreadPool& pool)
+	: mSettings(settings)
+	, mHeight(std::move(height))
+	, mPool(pool)
+{
+	uint32 maxLods = TerrainGenerator::MaxLodCount(mSettings.Terrain.Resolution);
+	mSettings.Terrain.LodCount = std::max(1u, std::min(mSettings.Terrain.LodCount, maxLods));
+
+	TerrainGenerator::AddAllIndices(mPatterns, mSettings.Terrain.Resolution, mSettings.Terrain.LodCount, true);
+}
+
+TerrainStreamer::~TerrainStreamer()
+{
+	// The builds reference nothing of ours, but finish them before the pool
+	// can go away.
+	for(auto& pending : mPending)
+		pending.second.wait();
+}
+
+float TerrainStreamer::DistanceToChunk(const XMFLOAT3& eyePos, int x, int z)const
+{
+	// Horizontal distance to the chunk's square; heights are not known before
+	// it is built.
+	float size = mSettings.Terrain.ChunkSize;
+	float minX = x*size;
+	float minZ = z*size;
+
+	float dx = std::max(0.0f, std::max(minX - eyePos.x, eyePos.x - (minX + size)));
+	float dz = std::max(0.0f, std::max(minZ - eyePos.z, eyePos.z - (minZ + size)));
+	return std::sqrt(dx*dx + dz*dz);
+}
+
+void TerrainStreamer::Update(const XMFLOAT3& eyePos)
+{
+	mLoaded.clear();
+	mEvicted.clear();
+
+	//
+	// Collect finished builds.
+	//
+
+	std::vector<std::uint64_t> loadedKeys;
+
+	for(auto it = mPending.begin(); it != mPending.end(); )
+	{
+		if(it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++it;
+			continue;
+		}
+
+		loadedKeys.push_back(it->first);
+		mResident[it->first] = it->second.get();
+		it = mPending.erase(it);
+	}
+
+	//
+	// Evict chunks that fell behind, then the farthest ones while over budget.
+	//
+
+	// A chunk loaded and evicted in the same Update was never handed out, so
+	// it is not reported either way.
+	auto evict = [&](std::uint64_t key)
+	{
+		if(std::find(loadedKeys.begin(), loadedKeys.end(), key) == loadedKeys.end())
+			mEvicted.push_back(key);
+	};
+
+	std::vector<std::pair<float, std::uint64_t>> byDistance;
+	for(auto it = mResident.begin(); it != mResident.end(); )
+	{
+		float distance = DistanceToChunk(eyePos, it->second->X, it->second->Z);
+		if(distance > mSettings.EvictRadius)
+		{
+			evict(it->first);
+			it = mResident.erase(it);
+			continue;
+		}
+
+		byDistance.push_back(std::make_pair(distance, it->first));
+		++it;
+	}
+
+	if(byDistance.size() > mSettings.MaxResidentChunks)
+	{
+		std::sort(byDistance.begin(), byDistance.end());
+		for(size_t i = mSettings.MaxResidentChunks; i < byDistance.size(); ++i)
+		{
+			evict(byDistance[i].second);
+			mResident.erase(byDistance[i].second);
+		}
+	}
+
+	// Looked up by key: the chunks evicted above are gone.
+	for(std::uint64_t key : loadedKeys)
+	{
+		auto it = mResident.find(key);
+		if(it != mResident.end())
+			mLoaded.push_back(it->second.get());
+	}
+
+	//
+	// Queue the nearest missing chunks.
+	//
+
+	float size = mSettings.Terrain.ChunkSize;
+	float radius = mSettings.LoadRadius;
+	int minX = (int)std::floor((eyePos.x - radius) / size);
+	int maxX = (int)std::floor((eyePos.x + radius) / size);
+	int minZ = (int)std::floor((eyePos.z - radius) / size);
+	int maxZ = (int)std::floor((eyePos.z + radius) / size);
+
+	struct Candidate
+	{
+		float Distance;
+		int X;
+		int Z;
+	};
+	std::vector<Candidate> candidates;
+
+	for(int z = minZ; z <= maxZ; ++z)
+	{
+		for(int x = minX; x <= maxX; ++x)
+		{
+			float distance = DistanceToChunk(eyePos, x, z);
+			std::uint64_t key = Key(x, z);
+			if(distance <= radius && mResident.count(key) == 0 && mPending.count(key) == 0)
+				candidates.push_back(Candidate{ distance, x, z });
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b)
+	{
+		return a.Distance < b.Distance;
+	});
+
+	for(const Candidate& c : candidates)
+	{
+		if(mPending.size() >= mSettings.MaxPendingChunks ||
+			mResident.size() + mPending.size() >= mSettings.MaxResidentChunks)
+			break;
+
+		TerrainGenerator::Settings terrain = mSettings.Terrain;
+		TerrainGenerator::HeightFunction height = mHeight;
+		int x = c.X;
+		int z = c.Z;
+		mPending[Key(x, z)] = mPool.Submit([terrain, height, x, z]()
+		{
+			return TerrainGenerator::BuildChunk(terrain, height, x, z, nullptr);
+		});
+	}
+
+	SelectLods(eyePos);
+
+	mStats.ResidentChunks = (uint32)mResident.size();
+	mStats.PendingChunks = (uint32)mPending.size();
+	mStats.LoadedChunks = (uint32)mLoaded.size();
+	mStats.EvictedChunks = (uint32)mEvicted.size();
+	mStats.ResidentBytes = 0;
+	for(auto& resident : mResident)
+		mStats.ResidentBytes += resident.second->ByteSize();
+}
+
+void TerrainStreamer::SelectLods(const XMFLOAT3& eyePos)
+{
+	uint32 lodCount = mSettings.Terrain.LodCount;
+
+	//
+	// Level from the distance to each chunk's box.
+	//
+
+	std::unordered_map<std::uint64_t, uint32> lods;
+	lods.reserve(mResident.size());
+
+	XMVECTOR eye = XMLoadFloat3(&eyePos);
+	for(auto& resident : mResident)
+	{
+		const BoundingBox& bounds = resident.second->Bounds;
+		XMVECTOR center = XMLoadFloat3(&bounds.Center);
+		XMVECTOR extents = XMLoadFloat3(&bounds.Extents);
+		XMVECTOR closest = XMVectorClamp(eye, center - extents, center + extents);
+		float distance = XMVectorGetX(XMVector3Length(eye - closest));
+
+		uint32 lod = 0;
+		if(distance >= mSettings.LodDistance)
+			lod = std::min(lodCount - 1, 1 + (uint32)std::log2(distance / mSettings.LodDistance));
+
+		lods[resident.first] = lod;
+	}
+
+	//
+	// Stitching only bridges one level, so refine chunks more than one level
+	// coarser than a neighbour until no such pair is left.
+	//
+
+	const int neighbourX[4] = { -1, 1, 0, 0 };
+	const int neighbourZ[4] = { 0, 0, -1, 1 };
+	const uint32 neighbourEdge[4] = {
+		TerrainGenerator::StitchLeft, TerrainGenerator::StitchRight,
+		TerrainGenerator::StitchBottom, TerrainGenerator::StitchTop };
+
+	for(uint32 pass = 0; pass < lodCount; ++pass)
+	{
+		bool changed = false;
+		for(auto& entry : lods)
+		{
+			const TerrainGenerator::Chunk& chunk = *mResident[entry.first];
+			for(int n = 0; n < 4; ++n)
+			{
+				auto neighbour = lods.find(Key(chunk.X + neighbourX[n], chunk.Z + neighbourZ[n]));
+				if(neighbour != lods.end() && entry.second > neighbour->second + 1)
+				{
+					entry.second = neighbour->second + 1;
+					changed = true;
+				}
+			}
+		}
+
+		if(!changed)
+			break;
+	}
+
+	//
+	// Draw list of the chunks in range, nearest first.
+	//
+
+	std::vector<std::pair<float, DrawChunk>> visible;
+	for(auto& resident : mResident)
+	{
+		const TerrainGenerator::Chunk& chunk = *resident.second;
+		float distance = DistanceToChunk(eyePos, chunk.X, chunk.Z);
+		if(distance > mSettings.LoadRadius)
+			continue;
+
+		DrawChunk draw;
+		draw.Chunk = &chunk;
+		draw.Lod = lods[resident.first];
+
+		for(int n = 0; n < 4; ++n)
+		{
+			auto neighbour = lods.find(Key(chunk.X + neighbourX[n], chunk.Z + neighbourZ[n]));
+			if(neighbour != lods.end() && neighbour->second > draw.Lod)
+				draw.StitchMask |= neighbourEdge[n];
+		}
+
+		draw.Indices = TerrainGenerator::FindIndices(mPatterns, mSettings.Terrain.Resolution, draw.Lod, draw.StitchMask, true);
+
+		visible.push_back(std::make_pair(distance, draw));
+	}
+
+	std::sort(visible.begin(), visible.end(), [](const std::pair<float, DrawChunk>& a, const std::pair<float, DrawChunk>& b)
+	{
+		return a.first < b.first;
+	});
+
+	mDrawList.clear();
+	for(auto& v : visible)
+		mDrawList.push_back(v.second);
+}
@@ -0,0 +1,206 @@
+//***************************************************************************************
+// TerrainGenerator.h
+//
+// Heightfield terrain cut into square chunks, for worlds too large for one
+// CreateGrid mesh.
+//
+// Chunk (X, Z) covers [X, X+1] x [Z, Z+1] chunk sizes of the xz plane with a
+// (Resolution+1)^2 vertex grid.  Samples are placed by their global grid index,
+// so two chunks compute bit-identical positions and normals along the edge they
+// share.  After the grid come the skirt vertices: a copy of every border vertex
+// lowered by SkirtDepth, which hangs a curtain below each edge to hide cracks
+// against a neighbour that is not loaded yet.
+//
+// All chunks share the same vertex numbering, so one index list per LOD and
+// neighbour combination serves every chunk.  LOD l keeps every 2^l-th row and
+// column.  An edge whose neighbour is one level coarser is stitched: each odd
+// vertex of that edge is folded onto the previous even one, which leaves the
+// edge with exactly the coarse neighbour's vertices and no T-junctions.
+//
+// TerrainStreamer keeps the chunks around a moving eye resident.  Missing chunks
+// are built on a ThreadPool without blocking the caller, far ones are evicted,
+// and memory stays bounded by MaxResidentChunks whatever the world size.  Its
+// IndexPatternCache holds every LOD and stitch pattern once, so all chunks draw
+// from a single shared index buffer.
+//***************************************************************************************
+
+#pragma once
+
+#include "GeometryGenerator.h"
+#include "IndexPatternCache.h"
+#include <cstdint>
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+#include <functional>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+class TerrainGenerator
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	// Height of the terrain at world position (x, z).  Called from worker
+	// threads, so it must be safe to call concurrently.
+	using HeightFunction = std::function<float(float x, float z)>;
+
+	struct Settings
+	{
+		float ChunkSize = 64.0f;        // world units per chunk side
+		uint32 Resolution = 64;         // quads per chunk side, a power of two
+		uint32 LodCount = 4;            // at most log2(Resolution)
+		float SkirtDepth = 4.0f;
+	};
+
+	// Neighbours one LOD coarser, for BuildIndices.
+	enum StitchEdge : uint32
+	{
+		StitchLeft = 1,     // -x
+		StitchRight = 2,    // +x
+		StitchBottom = 4,   // -z
+		StitchTop = 8       // +z
+	};
+
+	struct Chunk
+	{
+		int X = 0;
+		int Z = 0;
+
+		// Grid then skirt vertices, see GridVertexCount.  Indices32 is unused:
+		// the index lists come from BuildIndices.
+		GeometryGenerator::MeshDataSoA Mesh;
+
+		// Surface and skirts.
+		DirectX::BoundingBox Bounds;
+
+		size_t ByteSize()const;
+	};
+
+	static uint32 GridVertexCount(const Settings& settings) { return (settings.Resolution + 1)*(settings.Resolution + 1); }
+	static uint32 VertexCount(const Settings& settings) { return GridVertexCount(settings) + 4*(settings.Resolution + 1); }
+
+	///<summary>
+	/// Samples height over chunk (x, z).  If pool is given the rows are spread
+	/// over it.
+	///</summary>
+	static std::unique_ptr<Chunk> BuildChunk(const Settings& settings, const HeightFunction& height,
+		int x, int z, ThreadPool* pool);
+
+	///<summary>
+	/// Triangle list of one chunk at lod, folding the edges in stitchMask (a
+	/// combination of StitchEdge) onto the next coarser level.  With skirts the
+	/// skirt triangles follow the surface triangles.  Every triangle is
+	/// clockwise seen from above (skirts: from outside).
+	///</summary>
+	static std::vector<uint32> BuildIndices(uint32 resolution, uint32 lod, uint32 stitchMask, bool skirts);
+
+	///<summary>
+	/// The region of patterns holding BuildIndices(resolution, lod,
+	/// stitchMask, skirts), built on first use.
+	///</summary>
+	static IndexPatternCache::Region FindIndices(IndexPatternCache& patterns,
+		uint32 resolution, uint32 lod, uint32 stitchMask, bool skirts);
+
+	///<summary>
+	/// Adds the patterns of every LOD below lodCount and every stitch mask, so
+	/// the index buffer can be created once before drawing starts.
+	///</summary>
+	static void AddAllIndices(IndexPatternCache& patterns, uint32 resolution, uint32 lodCount, bool skirts);
+
+	// Levels usable with resolution: the coarsest keeps 2 quads per side so
+	// that it can still be stitched.
+	static uint32 MaxLodCount(uint32 resolution);
+};
+
+class TerrainStreamer
+{
+public:
+
+	using uint32 = std::uint32_t;
+
+	struct Settings
+	{
+		TerrainGenerator::Settings Terrain;
+
+		float LoadRadius = 512.0f;          // chunks closer than this are loaded
+		float EvictRadius = 640.0f;         // chunks farther than this are dropped
+		uint32 MaxResidentChunks = 512;
+		uint32 MaxPendingChunks = 8;        // builds in flight at once
+
+		// Distance to the eye below which chunks use LOD 0; each doubling of the
+		// distance drops one level.
+		float LodDistance = 128.0f;
+	};
+
+	// A resident chunk and how to draw it this frame.
+	struct DrawChunk
+	{
+		const TerrainGenerator::Chunk* Chunk = nullptr;
+		uint32 Lod = 0;
+		uint32 StitchMask = 0;
+		IndexPatternCache::Region Indices;     // in Patterns()
+	};
+
+	struct Stats
+	{
+		uint32 ResidentChunks = 0;
+		uint32 PendingChunks = 0;
+		uint32 LoadedChunks = 0;        // during the last Update
+		uint32 EvictedChunks = 0;       // during the last Update
+		size_t ResidentBytes = 0;
+	};
+
+	TerrainStreamer(const Settings& settings, TerrainGenerator::HeightFunction height, ThreadPool& pool);
+	TerrainStreamer(const TerrainStreamer& rhs) = delete;
+	TerrainStreamer& operator=(const TerrainStreamer& rhs) = delete;
+	~TerrainStreamer();
+
+	///<summary>
+	/// Collects finished chunks, drops far ones, queues the nearest missing
+	/// ones and picks the LOD and stitching of every resident chunk for eyePos.
+	/// Never waits for a build.
+	///</summary>
+	void Update(const DirectX::XMFLOAT3& eyePos);
+
+	// Resident chunks within LoadRadius, nearest first.
+	const std::vector<DrawChunk>& DrawList()const { return mDrawList; }
+
+	// Chunks that became resident in the last Update, to upload.  Valid until
+	// the next Update.
+	const std::vector<const TerrainGenerator::Chunk*>& LoadedChunks()const { return mLoaded; }
+
+	// Keys (see Key) of the chunks evicted in the last Update, to release.
+	const std::vector<std::uint64_t>& EvictedChunks()const { return mEvicted; }
+
+	// Index patterns of every LOD and stitch mask, skirts included, complete
+	// from construction on.
+	const IndexPatternCache& Patterns()const { return mPatterns; }
+
+	const Stats& GetStats()const { return mStats; }
+	const Settings& GetSettings()const { return mSettings; }
+
+	static std::uint64_t Key(int x, int z) { return ((std::uint64_t)(uint32)x << 32) | (uint32)z; }
+
+private:
+	float DistanceToChunk(const DirectX::XMFLOAT3& eyePos, int x, int z)const;
+	void SelectLods(const DirectX::XMFLOAT3& eyePos);
+
+private:
+	Settings mSettings;
+	TerrainGenerator::HeightFunction mHeight;
+	ThreadPool& mPool;
+	IndexPatternCache mPatterns;
+
+	std::unordered_map<std::uint64_t, std::unique_ptr<TerrainGenerator::Chunk>> mResident;
+	std::unordered_map<std::uint64_t, std::future<std::unique_ptr<TerrainGenerator::Chunk>>> mPending;
+
+	std::vector<DrawChunk> mDrawList;
+	std::vector<const TerrainGenerator::Chunk*> mLoaded;
+	std::vector<std::uint64_t> mEvicted;
+	Stats mStats;
+};
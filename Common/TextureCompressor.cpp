@@ -0,0 +1,508 @@
+//***************************************************************************************
+// TextureCompressor.cpp
+//***************************************************************************************
+
+#include "TextureCompressor.h"
+#include "DDSParser.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace
+{
+	using uint8 = TextureCompressor::uint8;
+	using uint16 = std::uint16_t;
+	using uint32 = TextureCompressor::uint32;
+	using uint64 = std::uint64_t;
+	using Image = TextureCompressor::Image;
+	using Format = TextureCompressor::Format;
+
+	// DDS_HEADER flags and caps DDSParser.h doesn't define.
+	const uint32 DDSD_CAPS = 0x00000001;
+	const uint32 DDSD_PIXELFORMAT = 0x00001000;
+	const uint32 DDSD_MIPMAPCOUNT = 0x00020000;
+	const uint32 DDSD_LINEARSIZE = 0x00080000;
+	const uint32 DDSCAPS_COMPLEX = 0x00000008;
+	const uint32 DDSCAPS_TEXTURE = 0x00001000;
+	const uint32 DDSCAPS_MIPMAP = 0x00400000;
+
+	const uint32 BI_RGB = 0;
+	const uint32 BI_BITFIELDS = 3;
+
+	// D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION.
+	const uint32 MaxDimension = 16384;
+
+	bool Fail(std::string* error, const char* message)
+	{
+		if (error != nullptr)
+			*error = message;
+		return false;
+	}
+
+	uint16 Read16(const uint8* p)
+	{
+		return (uint16)(p[0] | (p[1] << 8));
+	}
+
+	uint32 Read32(const uint8* p)
+	{
+		return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32)p[3] << 24);
+	}
+
+	// Bit position of an 8 bit wide channel mask; -1 for any other mask.
+	int MaskShift(uint32 mask)
+	{
+		for (int shift = 0; shift <= 24; shift += 8)
+		{
+			if (mask == 0xffu << shift)
+				return shift;
+		}
+
+		return -1;
+	}
+
+	float SRGBToLinear(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSRGB(float c)
+	{
+		return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+	}
+
+	// Halves image in each dimension, down to 1.  Odd edges repeat their last
+	// texel.  Colour is averaged in the space toLinear maps to, weighted by
+	// alpha; where all four texels are transparent, unweighted.
+	Image Downsample(const Image& image, const float toLinear[256], bool srgb)
+	{
+		Image mip;
+		mip.Width = std::max(image.Width / 2, 1u);
+		mip.Height = std::max(image.Height / 2, 1u);
+		mip.Pixels.resize((size_t)mip.Width * mip.Height * 4);
+
+		for (uint32 y = 0; y < mip.Height; ++y)
+		{
+			uint32 y0 = std::min(2*y, image.Height - 1);
+			uint32 y1 = std::min(2*y + 1, image.Height - 1);
+
+			for (uint32 x = 0; x < mip.Width; ++x)
+			{
+				uint32 x0 = std::min(2*x, image.Width - 1);
+				uint32 x1 = std::min(2*x + 1, image.Width - 1);
+
+				const uint8* texels[4] =
+				{
+					&image.Pixels[((size_t)y0*image.Width + x0) * 4],
+					&image.Pixels[((size_t)y0*image.Width + x1) * 4],
+					&image.Pixels[((size_t)y1*image.Width + x0) * 4],
+					&image.Pixels[((size_t)y1*image.Width + x1) * 4]
+				};
+
+				float weighted[3] = {}, plain[3] = {};
+				float alpha = 0.0f;
+				for (const uint8* t : texels)
+				{
+					float a = t[3] / 255.0f;
+					alpha += a;
+					for (int ch = 0; ch < 3; ++ch)
+					{
+						weighted[ch] += a * toLinear[t[ch]];
+						plain[ch] += toLinear[t[ch]];
+					}
+				}
+
+				uint8* out = &mip.Pixels[((size_t)y*mip.Width + x) * 4];
+				for (int ch = 0; ch < 3; ++ch)
+				{
+					float c = alpha > 0.0f ? weighted[ch] / alpha : plain[ch] / 4.0f;
+					if (srgb)
+						c = LinearToSRGB(c) * 255.0f;
+					out[ch] = (uint8)std::min(std::max(c + 0.5f, 0.0f), 255.0f);
+				}
+				out[3] = (uint8)std::min(alpha * (255.0f / 4.0f) + 0.5f, 255.0f);
+			}
+		}
+
+		return mip;
+	}
+
+	// Squared errors and how many channel samples they cover.
+	struct ErrorSum
+	{
+		double Color = 0.0;
+		double ColorSamples = 0.0;
+		double Alpha = 0.0;
+		double AlphaSamples = 0.0;
+	};
+
+	double Psnr(double mse)
+	{
+		return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : std::numeric_limits<double>::infinity();
+	}
+
+	// Encodes the blocks of row blockY of image to out, and adds the error of
+	// the decoded texels inside the image.
+	void EncodeRow(const Image& image, uint32 blockY, const TextureCompressor::Options& options,
+		uint8* out, ErrorSum& error)
+	{
+		const uint32 blocksX = std::max((image.Width + 3) / 4, 1u);
+		const uint32 blockBytes = TextureCompressor::BlockBytes(options.Target);
+
+		uint8 texels[64], decoded[64];
+		for (uint32 blockX = 0; blockX < blocksX; ++blockX, out += blockBytes)
+		{
+			// Blocks over the edge repeat the last row and column.
+			for (uint32 py = 0; py < 4; ++py)
+			{
+				uint32 y = std::min(blockY*4 + py, image.Height - 1);
+				for (uint32 px = 0; px < 4; ++px)
+				{
+					uint32 x = std::min(blockX*4 + px, image.Width - 1);
+					std::memcpy(&texels[(py*4 + px) * 4], &image.Pixels[((size_t)y*image.Width + x) * 4], 4);
+				}
+			}
+
+			switch (options.Target)
+			{
+			case Format::BC1:
+				BCEncoder::EncodeBC1(texels, options.Quality, options.AlphaThreshold, out);
+				BCEncoder::DecodeBC1(out, decoded);
+				break;
+			case Format::BC3:
+				BCEncoder::EncodeBC3(texels, options.Quality, out);
+				BCEncoder::DecodeBC3(out, decoded);
+				break;
+			case Format::BC5:
+				BCEncoder::EncodeBC5(texels, options.Quality, out);
+				BCEncoder::DecodeBC5(out, decoded);
+				break;
+			}
+
+			for (uint32 py = 0; py < 4 && blockY*4 + py < image.Height; ++py)
+			{
+				for (uint32 px = 0; px < 4 && blockX*4 + px < image.Width; ++px)
+				{
+					const uint8* source = &texels[(py*4 + px) * 4];
+					const uint8* result = &decoded[(py*4 + px) * 4];
+
+					int colorChannels = options.Target == Format::BC5 ? 2 : 3;
+					bool alpha = options.Target == Format::BC3 ||
+						(options.Target == Format::BC1 && options.AlphaThreshold > 0);
+
+					if (options.Target == Format::BC1 && source[3] < options.AlphaThreshold)
+						colorChannels = 0;
+
+					for (int ch = 0; ch < colorChannels; ++ch)
+					{
+						double d = (double)result[ch] - source[ch];
+						error.Color += d*d;
+					}
+					error.ColorSamples += colorChannels;
+
+					if (alpha)
+					{
+						double d = (double)result[3] - source[3];
+						error.Alpha += d*d;
+						error.AlphaSamples += 1.0;
+					}
+				}
+			}
+		}
+	}
+}
+
+bool TextureCompressor::ParseBMP(const uint8* data, size_t size, Image& image, std::string* error)
+{
+	if (data == nullptr || size < 54 || data[0] != 'B' || data[1] != 'M')
+		return Fail(error, "not a BMP file");
+
+	uint32 pixelOffset = Read32(data + 10);
+	uint32 infoSize = Read32(data + 14);
+	if (infoSize < 40)
+		return Fail(error, "OS/2 BMP headers are not supported");
+
+	int width = (int)Read32(data + 18);
+	int height = (int)Read32(data + 22);
+	uint32 bitCount = Read16(data + 28);
+	uint32 compression = Read32(data + 30);
+
+	if (width <= 0 || height == 0 || (uint32)width > MaxDimension || (uint32)std::abs(height) > MaxDimension)
+		return Fail(error, "invalid image size");
+	if (bitCount != 24 && bitCount != 32)
+		return Fail(error, "only 24 and 32 bit BMP files are supported");
+
+	// Masks of the alpha, red, green and blue bits of a 32 bit texel.
+	uint32 masks[4] = { 0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff };
+	if (compression == BI_BITFIELDS && bitCount == 32)
+	{
+		// Right after a 40 byte header, or inside a larger one: either way at 54.
+		if (size < 66)
+			return Fail(error, "truncated BMP header");
+
+		masks[1] = Read32(data + 54);
+		masks[2] = Read32(data + 58);
+		masks[3] = Read32(data + 62);
+		masks[0] = infoSize >= 56 && size >= 70 ? Read32(data + 66) : 0;
+	}
+	else if (compression != BI_RGB)
+	{
+		return Fail(error, "compressed BMP files are not supported");
+	}
+
+	int shifts[4];
+	for (int ch = 0; ch < 4; ++ch)
+	{
+		shifts[ch] = masks[ch] != 0 ? MaskShift(masks[ch]) : 0;
+		if (shifts[ch] < 0)
+			return Fail(error, "only 8 bit BMP channel masks are supported");
+	}
+
+	bool topDown = height < 0;
+	image.Width = (uint32)width;
+	image.Height = (uint32)std::abs(height);
+
+	uint64 stride = ((uint64)image.Width * bitCount + 31) / 32 * 4;
+	if (pixelOffset > size || stride * image.Height > size - pixelOffset)
+		return Fail(error, "truncated BMP pixel data");
+
+	image.Pixels.resize((size_t)image.Width * image.Height * 4);
+
+	bool anyAlpha = false;
+	for (uint32 y = 0; y < image.Height; ++y)
+	{
+		const uint8* row = data + pixelOffset + stride * (topDown ? y : image.Height - 1 - y);
+		uint8* out = &image.Pixels[(size_t)y * image.Width * 4];
+
+		for (uint32 x = 0; x < image.Width; ++x, out += 4)
+		{
+			if (bitCount == 24)
+			{
+				const uint8* bgr = row + x*3;
+				out[0] = bgr[2];
+				out[1] = bgr[1];
+				out[2] = bgr[0];
+				out[3] = 255;
+				continue;
+			}
+
+			uint32 texel = Read32(row + x*4);
+			out[0] = (uint8)((texel & masks[1]) >> shifts[1]);
+			out[1] = (uint8)((texel & masks[2]) >> shifts[2]);
+			out[2] = (uint8)((texel & masks[3]) >> shifts[3]);
+			out[3] = masks[0] != 0 ? (uint8)((texel & masks[0]) >> shifts[0]) : 255;
+			anyAlpha |= out[3] != 0;
+		}
+	}
+
+	// Written without alpha.
+	if (bitCount == 32 && !anyAlpha)
+	{
+		for (size_t i = 3; i < image.Pixels.size(); i += 4)
+			image.Pixels[i] = 255;
+	}
+
+	return true;
+}
+
+bool TextureCompressor::LoadBMP(const std::string& filename, Image& image, std::string* error)
+{
+	MappedFile file;
+	if (!file.Open(filename))
+		return Fail(error, "cannot open file");
+
+	return ParseBMP(file.Data(), file.Size(), image, error);
+}
+
+std::vector<TextureCompressor::Image> TextureCompressor::GenerateMips(const Image& image, bool srgb)
+{
+	float toLinear[256];
+	for (int i = 0; i < 256; ++i)
+		toLinear[i] = srgb ? SRGBToLinear(i / 255.0f) : (float)i;
+
+	std::vector<Image> mips;
+	mips.push_back(image);
+	while (mips.back().Width > 1 || mips.back().Height > 1)
+		mips.push_back(Downsample(mips.back(), toLinear, srgb));
+
+	return mips;
+}
+
+void TextureCompressor::Compress(const Image& image, const Options& options, Compressed& result, ThreadPool& pool)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	bool srgb = options.SRGB && options.Target != Format::BC5;
+
+	std::vector<Image> mips;
+	if (options.GenerateMips)
+		mips = GenerateMips(image, srgb);
+	else
+		mips.push_back(image);
+
+	result.Target = options.Target;
+	result.SRGB = srgb;
+	result.Width = image.Width;
+	result.Height = image.Height;
+	result.MipOffsets.clear();
+	result.Mips.clear();
+
+	// One task per row of blocks, over every mip.
+	struct Row
+	{
+		uint32 Mip;
+		uint32 BlockY;
+	};
+	std::vector<Row> rows;
+
+	const uint32 blockBytes = BlockBytes(options.Target);
+	size_t size = 0;
+	for (uint32 mip = 0; mip < (uint32)mips.size(); ++mip)
+	{
+		uint32 blocksX = std::max((mips[mip].Width + 3) / 4, 1u);
+		uint32 blocksY = std::max((mips[mip].Height + 3) / 4, 1u);
+
+		result.MipOffsets.push_back(size);
+		size += (size_t)blocksX * blocksY * blockBytes;
+
+		for (uint32 y = 0; y < blocksY; ++y)
+			rows.push_back(Row{ mip, y });
+	}
+	result.Data.assign(size, 0);
+
+	std::vector<ErrorSum> rowErrors(rows.size());
+	pool.ParallelFor((uint32)rows.size(), [&](uint32 i)
+	{
+		const Row& row = rows[i];
+		const Image& mip = mips[row.Mip];
+		size_t rowBytes = (size_t)std::max((mip.Width + 3) / 4, 1u) * blockBytes;
+
+		EncodeRow(mip, row.BlockY, options, &result.Data[result.MipOffsets[row.Mip] + row.BlockY * rowBytes],
+			rowErrors[i]);
+	});
+
+	std::vector<ErrorSum> mipErrors(mips.size());
+	for (size_t i = 0; i < rows.size(); ++i)
+	{
+		ErrorSum& sum = mipErrors[rows[i].Mip];
+		sum.Color += rowErrors[i].Color;
+		sum.ColorSamples += rowErrors[i].ColorSamples;
+		sum.Alpha += rowErrors[i].Alpha;
+		sum.AlphaSamples += rowErrors[i].AlphaSamples;
+	}
+
+	result.Mips.resize(mips.size());
+	for (uint32 mip = 0; mip < (uint32)mips.size(); ++mip)
+	{
+		const ErrorSum& sum = mipErrors[mip];
+		MipStats& stats = result.Mips[mip];
+		stats.Width = mips[mip].Width;
+		stats.Height = mips[mip].Height;
+		stats.ColorMse = sum.ColorSamples > 0.0 ? sum.Color / sum.ColorSamples : 0.0;
+		stats.ColorPsnr = Psnr(stats.ColorMse);
+		stats.AlphaMse = sum.AlphaSamples > 0.0 ? sum.Alpha / sum.AlphaSamples : 0.0;
+		stats.AlphaPsnr = Psnr(stats.AlphaMse);
+	}
+
+	result.Milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+void TextureCompressor::Compress(const Image& image, const Options& options, Compressed& result)
+{
+	Compress(image, options, result, ThreadPool::Default());
+}
+
+std::vector<TextureCompressor::uint8> TextureCompressor::WriteDDS(const Compressed& compressed)
+{
+	const uint32 mipCount = (uint32)compressed.MipOffsets.size();
+	const bool extended = compressed.SRGB;
+
+	DDS_HEADER header = {};
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDSD_CAPS | DDS_HEIGHT | DDS_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE;
+	header.height = compressed.Height;
+	header.width = compressed.Width;
+	header.pitchOrLinearSize = (uint32)(mipCount > 1 ? compressed.MipOffsets[1] : compressed.Data.size());
+	header.mipMapCount = mipCount;
+	header.caps = DDSCAPS_TEXTURE;
+	if (mipCount > 1)
+	{
+		header.flags |= DDSD_MIPMAPCOUNT;
+		header.caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+	}
+
+	header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+	header.ddspf.flags = DDS_FOURCC;
+	if (extended)
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+	else if (compressed.Target == Format::BC1)
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', 'T', '1');
+	else if (compressed.Target == Format::BC3)
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', 'T', '5');
+	else
+		header.ddspf.fourCC = MAKEFOURCC('A', 'T', 'I', '2');
+
+	DDS_HEADER_DXT10 extension = {};
+	extension.dxgiFormat = GetDXGIFormat(compressed.Target, compressed.SRGB);
+	extension.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+	extension.arraySize = 1;
+
+	std::vector<uint8> file(sizeof(uint32) + sizeof(DDS_HEADER) +
+		(extended ? sizeof(DDS_HEADER_DXT10) : 0) + compressed.Data.size());
+
+	uint8* out = file.data();
+	std::memcpy(out, &DDS_MAGIC, sizeof(uint32));
+	out += sizeof(uint32);
+	std::memcpy(out, &header, sizeof(DDS_HEADER));
+	out += sizeof(DDS_HEADER);
+	if (extended)
+	{
+		std::memcpy(out, &extension, sizeof(DDS_HEADER_DXT10));
+		out += sizeof(DDS_HEADER_DXT10);
+	}
+	if (!compressed.Data.empty())
+		std::memcpy(out, compressed.Data.data(), compressed.Data.size());
+
+	return file;
+}
+
+bool TextureCompressor::SaveDDS(const std::string& filename, const Compressed& compressed)
+{
+	std::vector<uint8> file = WriteDDS(compressed);
+
+	std::ofstream stream(filename, std::ios::binary);
+	stream.write(reinterpret_cast<const char*>(file.data()), (std::streamsize)file.size());
+
+	return stream.good();
+}
+
+DXGI_FORMAT TextureCompressor::GetDXGIFormat(Format format, bool srgb)
+{
+	switch (format)
+	{
+	case Format::BC1: return srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+	case Format::BC3: return srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+	case Format::BC5: return DXGI_FORMAT_BC5_UNORM;
+	}
+
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+TextureCompressor::uint32 TextureCompressor::BlockBytes(Format format)
+{
+	switch (format)
+	{
+	case Format::BC1: return BCEncoder::BC1BlockBytes;
+	case Format::BC3: return BCEncoder::BC3BlockBytes;
+	case Format::BC5: return BCEncoder::BC5BlockBytes;
+	}
+
+	return 0;
+}
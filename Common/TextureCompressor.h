@@ -0,0 +1,122 @@
+//***************************************************************************************
+// TextureCompressor.h
+//
+// Offline texture pipeline: turns an RGBA8 image, e.g. one of the .bmp files in
+// Textures/, into a block compressed DDS file with a full mip chain, which
+// DDSTextureLoader then loads like any other.
+//
+// Mips are box filtered, in linear space for sRGB images.  Colour is weighted
+// by alpha, so fully transparent texels (the background of the tree
+// billboards) don't bleed into the mips.  The blocks of every mip are encoded
+// by BCEncoder, a row of blocks per task on a ThreadPool.  Every block is also
+// decoded again to measure the error, reported as PSNR per mip.
+//
+// DDS files get the legacy DXT1, DXT5 and ATI2 pixel formats, so any DDS reader
+// that maps them (DDSParser::GetDXGIFormat included) reads them.  sRGB output
+// needs the DX10 header extension, which has the _SRGB formats.
+//***************************************************************************************
+
+#pragma once
+
+#include "BCEncoder.h"
+#include <cstdint>
+#include <dxgiformat.h>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+class TextureCompressor
+{
+public:
+
+	using uint8 = std::uint8_t;
+	using uint32 = std::uint32_t;
+
+	enum class Format
+	{
+		BC1,            // RGB, 1-bit alpha; 4 bits per texel
+		BC3,            // RGBA; 8 bits per texel
+		BC5             // RG, e.g. tangent space normals; 8 bits per texel
+	};
+
+	// RGBA8, rows top to bottom, tightly packed.
+	struct Image
+	{
+		uint32 Width = 0;
+		uint32 Height = 0;
+		std::vector<uint8> Pixels;
+	};
+
+	struct Options
+	{
+		Format Target = Format::BC1;
+		BCEncoder::Quality Quality = BCEncoder::Quality::Normal;
+		bool GenerateMips = true;
+
+		// The image holds sRGB colours: filter them in linear space and write
+		// an _SRGB format.  Not for BC5.
+		bool SRGB = false;
+
+		// BC1 only: texels with less alpha become transparent.  0 ignores alpha.
+		uint8 AlphaThreshold = 128;
+	};
+
+	// The error of one mip, per channel sample.  Colour covers RGB, or RG for
+	// BC5, of every texel BC1 keeps opaque; alpha covers every texel for BC3,
+	// and for BC1 with an AlphaThreshold.  PSNR is infinite where there is no
+	// error, or nothing to measure.
+	struct MipStats
+	{
+		uint32 Width = 0;
+		uint32 Height = 0;
+		double ColorMse = 0.0;
+		double ColorPsnr = 0.0;
+		double AlphaMse = 0.0;
+		double AlphaPsnr = 0.0;
+	};
+
+	struct Compressed
+	{
+		Format Target = Format::BC1;
+		bool SRGB = false;
+		uint32 Width = 0;
+		uint32 Height = 0;
+		std::vector<size_t> MipOffsets;     // into Data, one per mip
+		std::vector<uint8> Data;            // the blocks of every mip, largest first
+		std::vector<MipStats> Mips;
+		double Milliseconds = 0.0;          // filtering and encoding
+	};
+
+	///<summary>
+	/// Reads an uncompressed 24 or 32 bit BMP file held in memory.  32 bit files
+	/// whose alpha is 0 throughout were written without alpha and load opaque.
+	///</summary>
+	static bool ParseBMP(const uint8* data, size_t size, Image& image, std::string* error = nullptr);
+
+	static bool LoadBMP(const std::string& filename, Image& image, std::string* error = nullptr);
+
+	///<summary>
+	/// The image followed by every mip down to 1x1.
+	///</summary>
+	static std::vector<Image> GenerateMips(const Image& image, bool srgb);
+
+	///<summary>
+	/// Filters and encodes image on pool.
+	///</summary>
+	static void Compress(const Image& image, const Options& options, Compressed& result, ThreadPool& pool);
+
+	// Same, on ThreadPool::Default().
+	static void Compress(const Image& image, const Options& options, Compressed& result);
+
+	///<summary>
+	/// The whole DDS file for compressed, headers included.
+	///</summary>
+	static std::vector<uint8> WriteDDS(const Compressed& compressed);
+
+	static bool SaveDDS(const std::string& filename, const Compressed& compressed);
+
+	static DXGI_FORMAT GetDXGIFormat(Format format, bool srgb);
+
+	static uint32 BlockBytes(Format format);
+};
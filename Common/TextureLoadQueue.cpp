@@ -0,0 +1,230 @@
+//***************************************************************************************
+// TextureLoadQueue.cpp
+//***************************************************************************************
+
+#include "TextureLoadQueue.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	using uint64 = TextureLoadQueue::uint64;
+	using LoadedTexture = TextureLoadQueue::LoadedTexture;
+
+	const size_t PageSize = 4096;
+
+	struct Request
+	{
+		TextureLoadQueue::Path Filename;
+		int Priority = 0;
+		uint64 Sequence = 0;
+		TextureLoadQueue::Callback OnLoaded;
+		std::promise<TextureLoadQueue::LoadedTexturePtr> Promise;
+	};
+
+	// Heap order: highest priority on top, the oldest request among equals.
+	bool RunsAfter(const std::unique_ptr<Request>& a, const std::unique_ptr<Request>& b)
+	{
+		if (a->Priority != b->Priority)
+			return a->Priority < b->Priority;
+		return a->Sequence > b->Sequence;
+	}
+
+	// Reads a byte of every page so the file comes in on this thread rather
+	// than when the upload first touches it.
+	void TouchPages(const std::uint8_t* data, size_t size)
+	{
+		volatile std::uint8_t sink = 0;
+		for (size_t i = 0; i < size; i += PageSize)
+			sink ^= data[i];
+	}
+}
+
+// Shared with the queued tasks and with the deleters of the results, which
+// may outlive the queue.
+struct TextureLoadQueue::State : std::enable_shared_from_this<State>
+{
+	ThreadPool* Pool = nullptr;
+	Options Settings;
+	uint32 MaxConcurrentLoads = 1;
+
+	mutable std::mutex Mutex;
+	std::condition_variable Idle;
+	std::vector<std::unique_ptr<Request>> Pending;     // a heap, see RunsAfter
+	uint64 NextSequence = 0;
+	Stats Counters;
+
+	// Starts the best pending requests while loads and budget allow.  Mutex is
+	// held.
+	void Dispatch()
+	{
+		while (!Pending.empty() && Counters.Loading < MaxConcurrentLoads &&
+			(Counters.StagedBytes < Settings.StagingBudget || (Counters.StagedBytes == 0 && Counters.Loading == 0)))
+		{
+			std::pop_heap(Pending.begin(), Pending.end(), RunsAfter);
+			std::unique_ptr<Request> request = std::move(Pending.back());
+			Pending.pop_back();
+
+			Start(std::move(request));
+		}
+	}
+
+	// Mutex is held.
+	void Start(std::unique_ptr<Request> request)
+	{
+		--Counters.Queued;
+		++Counters.Loading;
+
+		std::shared_ptr<State> self = shared_from_this();
+		std::shared_ptr<Request> task(std::move(request));
+		Pool->Submit([self, task]() { self->Run(*task); });
+	}
+
+	// Starts the request with sequence number id now if it is still queued.
+	// Mutex is held.
+	void Expedite(uint64 id)
+	{
+		auto it = std::find_if(Pending.begin(), Pending.end(),
+			[id](const std::unique_ptr<Request>& request) { return request->Sequence == id; });
+		if (it == Pending.end())
+			return;
+
+		std::unique_ptr<Request> request = std::move(*it);
+		Pending.erase(it);
+		std::make_heap(Pending.begin(), Pending.end(), RunsAfter);
+
+		Start(std::move(request));
+	}
+
+	void Release(uint64 bytes)
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Counters.StagedBytes -= bytes;
+		Dispatch();
+	}
+
+	void Run(Request& request)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		std::unique_ptr<LoadedTexture> texture(new LoadedTexture());
+		texture->Filename = request.Filename;
+		texture->Priority = request.Priority;
+		texture->FileFound = texture->File.Open(request.Filename);
+		if (texture->FileFound)
+		{
+			texture->Status = DDSParser::Parse(texture->File.Data(), texture->File.Size(), 0, texture->Texture);
+			if (texture->Status != DDSParser::Status::Ok)
+				texture->File.Close();
+			else if (Settings.TouchPages)
+				TouchPages(texture->File.Data(), texture->File.Size());
+		}
+
+		texture->LoadMilliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+
+		uint64 bytes = texture->File.Size();
+		bool succeeded = texture->Succeeded();
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Counters.StagedBytes += bytes;
+			Counters.PeakStagedBytes = std::max(Counters.PeakStagedBytes, Counters.StagedBytes);
+			Counters.LoadedBytes += bytes;
+			if (succeeded)
+				++Counters.Completed;
+			else
+				++Counters.Failed;
+		}
+
+		std::shared_ptr<State> self = shared_from_this();
+		LoadedTexturePtr result(texture.release(), [self, bytes](const LoadedTexture* t)
+		{
+			delete t;
+			self->Release(bytes);
+		});
+
+		try
+		{
+			if (request.OnLoaded)
+				request.OnLoaded(result);
+			request.Promise.set_value(std::move(result));
+		}
+		catch (...)
+		{
+			request.Promise.set_exception(std::current_exception());
+		}
+		result.reset();
+
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			--Counters.Loading;
+			Dispatch();
+		}
+		Idle.notify_all();
+	}
+};
+
+TextureLoadQueue::TextureLoadQueue(ThreadPool& pool, const Options& options)
+	: mState(std::make_shared<State>())
+{
+	mState->Pool = &pool;
+	mState->Settings = options;
+	mState->MaxConcurrentLoads = options.MaxConcurrentLoads != 0 ?
+		options.MaxConcurrentLoads : std::max(pool.ThreadCount(), 1u);
+}
+
+TextureLoadQueue::~TextureLoadQueue()
+{
+	std::unique_lock<std::mutex> lock(mState->Mutex);
+	mState->Counters.Queued -= (uint32)mState->Pending.size();
+	mState->Pending.clear();
+
+	mState->Idle.wait(lock, [this]() { return mState->Counters.Loading == 0; });
+}
+
+TextureLoadQueue::Ticket TextureLoadQueue::Load(const Path& filename, int priority, Callback callback)
+{
+	std::unique_ptr<Request> request(new Request());
+	request->Filename = filename;
+	request->Priority = priority;
+	request->OnLoaded = std::move(callback);
+
+	Ticket ticket;
+	ticket.Future = request->Promise.get_future();
+
+	std::lock_guard<std::mutex> lock(mState->Mutex);
+	ticket.Id = request->Sequence = mState->NextSequence++;
+	mState->Pending.push_back(std::move(request));
+	std::push_heap(mState->Pending.begin(), mState->Pending.end(), RunsAfter);
+	++mState->Counters.Queued;
+
+	mState->Dispatch();
+
+	return ticket;
+}
+
+TextureLoadQueue::LoadedTexturePtr TextureLoadQueue::Get(Ticket& ticket)
+{
+	{
+		std::lock_guard<std::mutex> lock(mState->Mutex);
+		mState->Expedite(ticket.Id);
+	}
+
+	return ticket.Future.get();
+}
+
+void TextureLoadQueue::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(mState->Mutex);
+	mState->Idle.wait(lock, [this]() { return mState->Pending.empty() && mState->Counters.Loading == 0; });
+}
+
+TextureLoadQueue::Stats TextureLoadQueue::GetStats()const
+{
+	std::lock_guard<std::mutex> lock(mState->Mutex);
+	return mState->Counters;
+}
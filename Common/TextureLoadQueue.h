@@ -0,0 +1,128 @@
+//***************************************************************************************
+// TextureLoadQueue.h
+//
+// Loads DDS files on a ThreadPool ahead of their upload.  Each request maps the
+// file, parses it with DDSParser and touches its pages, so the disk reads and
+// parsing of several files overlap with each other and with the caller.  The
+// caller still creates the D3D12 resources on its own thread, from the parsed
+// file.
+//
+// Requests start in priority order, highest first, equal priorities in the
+// order they were made.  Loaded files count against a staging budget until the
+// last reference to them is dropped; no new load starts while the budget is
+// used up, so at most budget plus the files in flight is held at once.  Drop
+// each result once it is uploaded.  Get starts a request that is still queued
+// right away, budget or not, so a caller waiting on one texture while holding
+// others never stalls; waiting on the future directly has no such guarantee.
+//
+// Nothing here touches Direct3D: the queue can run headless, e.g. to validate
+// every texture of a level.
+//***************************************************************************************
+
+#pragma once
+
+#include "DDSParser.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+
+class ThreadPool;
+
+class TextureLoadQueue
+{
+public:
+
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+#ifdef _WIN32
+	using Path = std::wstring;
+#else
+	using Path = std::string;
+#endif
+
+	struct Options
+	{
+		uint64 StagingBudget = 256ull << 20;
+
+		// Requests loading at once; 0 uses every worker of the pool.
+		uint32 MaxConcurrentLoads = 0;
+
+		// Read the whole file on the worker rather than on first access.
+		bool TouchPages = true;
+	};
+
+	struct LoadedTexture
+	{
+		Path Filename;
+		int Priority = 0;
+
+		bool FileFound = false;
+		DDSParser::Status Status = DDSParser::Status::InvalidArgument;
+		DDSParser::Texture Texture;     // offsets into Data()
+		MappedFile File;                // closed unless the file parsed
+
+		double LoadMilliseconds = 0.0;
+
+		bool Succeeded()const { return FileFound && Status == DDSParser::Status::Ok; }
+		const std::uint8_t* Data()const { return File.Data(); }
+		size_t Size()const { return File.Size(); }
+	};
+
+	using LoadedTexturePtr = std::shared_ptr<const LoadedTexture>;
+
+	// Runs on the worker that loaded the texture, failed loads included.
+	using Callback = std::function<void(const LoadedTexturePtr&)>;
+
+	struct Stats
+	{
+		uint32 Queued = 0;
+		uint32 Loading = 0;
+		uint32 Completed = 0;
+		uint32 Failed = 0;
+		uint64 StagedBytes = 0;         // held by results not yet dropped
+		uint64 PeakStagedBytes = 0;
+		uint64 LoadedBytes = 0;
+	};
+
+	struct Ticket
+	{
+		std::future<LoadedTexturePtr> Future;
+		uint64 Id = 0;
+	};
+
+	TextureLoadQueue(ThreadPool& pool, const Options& options);
+	TextureLoadQueue(const TextureLoadQueue& rhs) = delete;
+	TextureLoadQueue& operator=(const TextureLoadQueue& rhs) = delete;
+
+	///<summary>
+	/// Drops requests that have not started (their futures report a broken
+	/// promise) and waits for those loading.  Results already handed out stay
+	/// valid.
+	///</summary>
+	~TextureLoadQueue();
+
+	///<summary>
+	/// Queues filename.  The ticket's future is ready once the file is loaded or
+	/// failed to; callback, if any, has run by then.  An exception thrown by
+	/// callback is passed on through the future.
+	///</summary>
+	Ticket Load(const Path& filename, int priority, Callback callback = nullptr);
+
+	///<summary>
+	/// Waits for the ticket's texture, first starting it if it is still queued.
+	///</summary>
+	LoadedTexturePtr Get(Ticket& ticket);
+
+	// Returns once every request made so far has finished.
+	void WaitIdle();
+
+	Stats GetStats()const;
+
+private:
+	struct State;
+	std::shared_ptr<State> mState;
+};
@@ -0,0 +1,275 @@
+//***************************************************************************************
+// TextureResidency.cpp
+//***************************************************************************************
+
+#include "TextureResidency.h"
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+TextureResidency::TextureResidency(const Options& options)
+	: mOptions(options)
+{
+	mStats.Budget = options.Budget;
+}
+
+TextureResidency::uint32 TextureResidency::Add(const DDSParser::TextureDesc& desc)
+{
+	Texture texture;
+	texture.MipBytes.resize(std::max(desc.MipLevels, 1u));
+	texture.TailMip = (uint32)texture.MipBytes.size() - 1;
+
+	for (uint32 mip = 0; mip < (uint32)texture.MipBytes.size(); ++mip)
+	{
+		uint32 width = std::max(desc.Width >> mip, 1u);
+		uint32 height = std::max(desc.Height >> mip, 1u);
+		uint32 depth = std::max(desc.Depth >> mip, 1u);
+
+		texture.MipBytes[mip] = DDSParser::GetSurfaceInfo(width, height, desc.Format).NumBytes * depth * desc.ArraySize;
+
+		if (width <= mOptions.TailSize && height <= mOptions.TailSize)
+			texture.TailMip = std::min(texture.TailMip, mip);
+	}
+
+	texture.ResidentMip = (uint32)texture.MipBytes.size();
+	texture.RequestedMip = texture.TailMip;
+
+	mTextures.push_back(texture);
+	mStats.TextureCount = (uint32)mTextures.size();
+
+	return (uint32)mTextures.size() - 1;
+}
+
+void TextureResidency::RequestMip(uint32 texture, uint32 mip, uint64 frame)
+{
+	Texture& t = mTextures[texture];
+	mip = std::min(mip, t.TailMip);
+
+	if (!t.Requested || t.LastRequestFrame != frame)
+		t.RequestedMip = mip;
+	else
+		t.RequestedMip = std::min(t.RequestedMip, mip);
+
+	t.LastRequestFrame = frame;
+	t.Requested = true;
+}
+
+void TextureResidency::SetBusy(uint32 texture, bool busy)
+{
+	mTextures[texture].Busy = busy;
+}
+
+void TextureResidency::SetBudget(uint64 budget)
+{
+	mOptions.Budget = budget;
+	mStats.Budget = budget;
+}
+
+bool TextureResidency::IsWanted(const Texture& texture, uint64 frame)const
+{
+	return texture.Requested && texture.LastRequestFrame == frame;
+}
+
+// Drops finest mips until bytes are freed.  Textures not wanted this frame go
+// first, least recently requested first, down to their tail; then mips finer
+// than this frame's requests.  Unless partial, nothing is dropped when bytes
+// can't be freed in full.  Returns whether they were.
+bool TextureResidency::EvictFor(uint64 bytes, uint64 frame, bool partial)
+{
+	std::vector<uint32> victims;
+	for (uint32 i = 0; i < (uint32)mTextures.size(); ++i)
+	{
+		const Texture& t = mTextures[i];
+		uint32 keepFrom = IsWanted(t, frame) ? t.RequestedMip : t.TailMip;
+		if (!t.Busy && t.ResidentMip < keepFrom)
+			victims.push_back(i);
+	}
+
+	std::sort(victims.begin(), victims.end(), [this, frame](uint32 a, uint32 b)
+	{
+		const Texture& ta = mTextures[a];
+		const Texture& tb = mTextures[b];
+		bool wantedA = IsWanted(ta, frame);
+		bool wantedB = IsWanted(tb, frame);
+		if (wantedA != wantedB)
+			return !wantedA;
+		if (ta.Requested != tb.Requested)
+			return !ta.Requested;
+		return ta.LastRequestFrame < tb.LastRequestFrame;
+	});
+
+	if (!partial)
+	{
+		uint64 evictable = 0;
+		for (uint32 index : victims)
+		{
+			const Texture& t = mTextures[index];
+			uint32 keepFrom = IsWanted(t, frame) ? t.RequestedMip : t.TailMip;
+			for (uint32 mip = t.ResidentMip; mip < keepFrom; ++mip)
+				evictable += t.MipBytes[mip];
+		}
+
+		if (evictable < bytes)
+			return false;
+	}
+
+	uint64 freed = 0;
+	for (uint32 i = 0; i < (uint32)victims.size() && freed < bytes; ++i)
+	{
+		Texture& t = mTextures[victims[i]];
+		uint32 keepFrom = IsWanted(t, frame) ? t.RequestedMip : t.TailMip;
+		while (t.ResidentMip < keepFrom && freed < bytes)
+		{
+			uint64 mipBytes = t.MipBytes[t.ResidentMip++];
+			freed += mipBytes;
+			mStats.ResidentBytes -= mipBytes;
+			mStats.EvictedBytes += mipBytes;
+			++mStats.Evictions;
+		}
+	}
+
+	return freed >= bytes;
+}
+
+void TextureResidency::Update(uint64 frame, std::vector<Change>& changes)
+{
+	std::vector<uint32> before(mTextures.size());
+	for (uint32 i = 0; i < (uint32)mTextures.size(); ++i)
+		before[i] = mTextures[i].ResidentMip;
+
+	// Tails of new textures come in regardless of the budget.
+	for (Texture& t : mTextures)
+	{
+		if (t.ResidentMip != (uint32)t.MipBytes.size())
+			continue;
+
+		for (uint32 mip = t.TailMip; mip < (uint32)t.MipBytes.size(); ++mip)
+		{
+			mStats.ResidentBytes += t.MipBytes[mip];
+			mStats.StreamedInBytes += t.MipBytes[mip];
+		}
+		t.ResidentMip = t.TailMip;
+	}
+
+	// One level at a time, the texture furthest from its request first, so
+	// everything wanted sharpens evenly.
+	std::priority_queue<std::pair<uint32, uint32>> starved;     // (levels missing, -index)
+	for (uint32 i = 0; i < (uint32)mTextures.size(); ++i)
+	{
+		const Texture& t = mTextures[i];
+		if (!t.Busy && IsWanted(t, frame) && t.RequestedMip < t.ResidentMip)
+			starved.push(std::make_pair(t.ResidentMip - t.RequestedMip, ~i));
+	}
+
+	uint64 uploadLeft = mOptions.MaxStreamInBytes;
+	bool streamedAny = false;
+	while (!starved.empty())
+	{
+		uint32 index = ~starved.top().second;
+		starved.pop();
+
+		Texture& t = mTextures[index];
+		uint64 bytes = t.MipBytes[t.ResidentMip - 1];
+
+		// A mip larger than the cap still goes, alone, so it isn't stuck forever.
+		if (bytes > uploadLeft && streamedAny)
+			continue;
+
+		if (mStats.ResidentBytes + bytes > mOptions.Budget &&
+			!EvictFor(mStats.ResidentBytes + bytes - mOptions.Budget, frame, false))
+		{
+			continue;
+		}
+
+		--t.ResidentMip;
+		mStats.ResidentBytes += bytes;
+		mStats.StreamedInBytes += bytes;
+		++mStats.StreamIns;
+		uploadLeft -= std::min(bytes, uploadLeft);
+		streamedAny = true;
+
+		if (t.RequestedMip < t.ResidentMip)
+			starved.push(std::make_pair(t.ResidentMip - t.RequestedMip, ~index));
+	}
+
+	// The budget may have shrunk, or new tails pushed it over.
+	if (mStats.ResidentBytes > mOptions.Budget)
+		EvictFor(mStats.ResidentBytes - mOptions.Budget, frame, true);
+
+	// Still over: this frame's requests alone don't fit.  Take the largest
+	// resident mips back, whoever asked for them; only tails are kept.
+	while (mStats.ResidentBytes > mOptions.Budget)
+	{
+		Texture* largest = nullptr;
+		for (Texture& t : mTextures)
+		{
+			if (!t.Busy && t.ResidentMip < t.TailMip &&
+				(largest == nullptr || t.MipBytes[t.ResidentMip] > largest->MipBytes[largest->ResidentMip]))
+			{
+				largest = &t;
+			}
+		}
+
+		if (largest == nullptr)
+			break;
+
+		uint64 mipBytes = largest->MipBytes[largest->ResidentMip++];
+		mStats.ResidentBytes -= mipBytes;
+		mStats.EvictedBytes += mipBytes;
+		++mStats.Evictions;
+	}
+
+	mStats.StarvedTextures = 0;
+	mStats.RequestedBytes = 0;
+	for (uint32 i = 0; i < (uint32)mTextures.size(); ++i)
+	{
+		const Texture& t = mTextures[i];
+		uint32 wantedMip = IsWanted(t, frame) ? t.RequestedMip : t.TailMip;
+		for (uint32 mip = wantedMip; mip < (uint32)t.MipBytes.size(); ++mip)
+			mStats.RequestedBytes += t.MipBytes[mip];
+
+		if (IsWanted(t, frame) && t.RequestedMip < t.ResidentMip)
+			++mStats.StarvedTextures;
+
+		if (t.ResidentMip != before[i])
+		{
+			Change change;
+			change.Texture = i;
+			change.FromMip = before[i];
+			change.ToMip = t.ResidentMip;
+			changes.push_back(change);
+		}
+	}
+
+	mStats.PeakResidentBytes = std::max(mStats.PeakResidentBytes, mStats.ResidentBytes);
+}
+
+void TextureResidency::Revert(const Change& change)
+{
+	Texture& t = mTextures[change.Texture];
+	uint32 mipCount = (uint32)t.MipBytes.size();
+
+	if (change.ToMip < change.FromMip)
+	{
+		for (uint32 mip = change.ToMip; mip < std::min(change.FromMip, mipCount); ++mip)
+		{
+			mStats.ResidentBytes -= t.MipBytes[mip];
+			mStats.StreamedInBytes -= t.MipBytes[mip];
+		}
+
+		// Tails of new textures come in without being counted as stream-ins.
+		if (change.FromMip < mipCount)
+			mStats.StreamIns -= change.FromMip - change.ToMip;
+	}
+	else
+	{
+		for (uint32 mip = change.FromMip; mip < change.ToMip; ++mip)
+		{
+			mStats.ResidentBytes += t.MipBytes[mip];
+			mStats.EvictedBytes -= t.MipBytes[mip];
+			--mStats.Evictions;
+		}
+	}
+
+	t.ResidentMip = change.FromMip;
+}
@@ -0,0 +1,128 @@
+//***************************************************************************************
+// TextureResidency.h
+//
+// Decides which mips of a set of streamed textures are resident under a memory
+// budget.  Device independent: it only tracks bytes and mip levels and hands
+// back the changes for something like TextureStreamer to carry out.
+//
+// Every texture always keeps its mip tail, the mips no larger than TailSize;
+// finer mips come and go one level at a time.  Each frame the renderer reports
+// the finest mip it wants per texture (RequestMip).  Update then streams in
+// towards those requests, most starved texture first, within a per-update
+// upload cap.  When that would exceed the budget it evicts finest mips first:
+// mips above what their texture asked for, then textures unused for longest
+// (LRU).  Mips requested this frame only go when the requests alone exceed the
+// budget, largest first.  The budget is a hard limit except for the tails;
+// Stats counts the textures it leaves short of their request as starved.
+//
+// Sizes are the tightly packed texel bytes of every array slice of a mip, as
+// stored in the DDS file; the allocation behind them is a little larger.
+//***************************************************************************************
+
+#pragma once
+
+#include "DDSParser.h"
+#include <cstdint>
+#include <vector>
+
+class TextureResidency
+{
+public:
+
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	struct Options
+	{
+		uint64 Budget = 64ull << 20;
+
+		// Mips at most this wide and high are always resident.
+		uint32 TailSize = 64;
+
+		// Bytes streamed in per Update at most; evictions are free.
+		uint64 MaxStreamInBytes = 8ull << 20;
+	};
+
+	// A texture's resident mips going from [FromMip, last] to [ToMip, last].
+	struct Change
+	{
+		uint32 Texture = 0;
+		uint32 FromMip = 0;         // MipCount for a texture with nothing resident yet
+		uint32 ToMip = 0;
+	};
+
+	struct Stats
+	{
+		uint32 TextureCount = 0;
+		uint32 StarvedTextures = 0;     // asked for finer mips than resident, last Update
+		uint64 Budget = 0;
+		uint64 ResidentBytes = 0;
+		uint64 PeakResidentBytes = 0;
+		uint64 RequestedBytes = 0;      // needed to meet every request of the last Update
+		uint64 StreamedInBytes = 0;
+		uint64 EvictedBytes = 0;
+		uint32 StreamIns = 0;           // mip levels, counted per texture
+		uint32 Evictions = 0;
+	};
+
+	explicit TextureResidency(const Options& options);
+
+	///<summary>
+	/// Starts tracking a texture with the given layout; its mip tail becomes
+	/// resident on the next Update.  Returns the texture's index.
+	///</summary>
+	uint32 Add(const DDSParser::TextureDesc& desc);
+
+	///<summary>
+	/// Feedback: texture is wanted down to mip this frame.  Several requests in
+	/// one frame keep the finest.
+	///</summary>
+	void RequestMip(uint32 texture, uint32 mip, uint64 frame);
+
+	///<summary>
+	/// A busy texture is left alone by Update, e.g. while the previous change to
+	/// it is still being carried out.
+	///</summary>
+	void SetBusy(uint32 texture, bool busy);
+
+	///<summary>
+	/// Works out the residency for frame and appends one change per texture whose
+	/// resident mips differ from before.  Frames must increase.
+	///</summary>
+	void Update(uint64 frame, std::vector<Change>& changes);
+
+	///<summary>
+	/// Takes back a change of the last Update that could not be carried out:
+	/// the texture's resident mips return to FromMip and the bytes and counters
+	/// to what they were.  The next Update tries again.
+	///</summary>
+	void Revert(const Change& change);
+
+	void SetBudget(uint64 budget);
+
+	uint32 ResidentMip(uint32 texture)const { return mTextures[texture].ResidentMip; }
+	uint32 TailMip(uint32 texture)const { return mTextures[texture].TailMip; }
+	uint32 MipCount(uint32 texture)const { return (uint32)mTextures[texture].MipBytes.size(); }
+	uint64 MipBytes(uint32 texture, uint32 mip)const { return mTextures[texture].MipBytes[mip]; }
+
+	const Stats& GetStats()const { return mStats; }
+
+private:
+	struct Texture
+	{
+		std::vector<uint64> MipBytes;   // all array slices of the mip
+		uint32 TailMip = 0;
+		uint32 ResidentMip = 0;         // finest resident mip; MipBytes.size() before the first Update
+		uint32 RequestedMip = 0;
+		uint64 LastRequestFrame = 0;
+		bool Requested = false;         // ever
+		bool Busy = false;
+	};
+
+	bool IsWanted(const Texture& texture, uint64 frame)const;
+	bool EvictFor(uint64 bytes, uint64 frame, bool partial);
+
+	Options mOptions;
+	std::vector<Texture> mTextures;
+	Stats mStats;
+};
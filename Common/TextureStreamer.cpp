@@ -0,0 +1,280 @@
+//***************************************************************************************
+// TextureStreamer.cpp
+//***************************************************************************************
+
+#include "TextureStreamer.h"
+#include <algorithm>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	bool IsBlockCompressed(DXGI_FORMAT format)
+	{
+		return (format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM) ||
+			(format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+	}
+
+	UINT64 AlignUp(UINT64 value, UINT64 alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+TextureStreamer::TextureStreamer(ID3D12Device* device, const Options& options)
+	: mDevice(device), mResidency(options.Residency), mTailSize(options.Residency.TailSize)
+{
+}
+
+HRESULT TextureStreamer::Add(const Path& filename, uint32& id)
+{
+	Texture texture;
+	if (!texture.File.Open(filename))
+		return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+
+	if (DDSParser::Parse(texture.File.Data(), texture.File.Size(), 0, texture.Layout) != DDSParser::Status::Ok)
+		return E_FAIL;
+
+	const DDSParser::TextureDesc& desc = texture.Layout.Desc;
+	if (desc.Dimension != DDSParser::ResourceDimension::Texture2D)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	// The top mip of a block compressed resource must be a whole number of
+	// blocks, and any mip down to the tail may end up on top.
+	if (IsBlockCompressed(desc.Format))
+	{
+		for (uint32 mip = 0; mip < desc.MipLevels; ++mip)
+		{
+			uint32 width = std::max(desc.Width >> mip, 1u);
+			uint32 height = std::max(desc.Height >> mip, 1u);
+			if (width % 4 != 0 || height % 4 != 0)
+				return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+			if (width <= mTailSize && height <= mTailSize)
+				break;
+		}
+	}
+
+	uint32 index = mResidency.Add(desc);
+	texture.ResidentMip = mResidency.MipCount(index);
+	mTextures.push_back(std::move(texture));
+
+	id = index;
+	return S_OK;
+}
+
+void TextureStreamer::SetDescriptorHeap(ID3D12DescriptorHeap* heap, UINT firstHeapIndex, UINT descriptorSize)
+{
+	mHeap = heap;
+	mFirstHeapIndex = firstHeapIndex;
+	mDescriptorSize = descriptorSize;
+
+	for (uint32 id = 0; id < (uint32)mTextures.size(); ++id)
+	{
+		if (mTextures[id].Resource != nullptr)
+			WriteSrv(id);
+	}
+}
+
+UINT TextureStreamer::SrvHeapIndex(uint32 id)const
+{
+	return mFirstHeapIndex + 2 * id + mTextures[id].Slot;
+}
+
+void TextureStreamer::RequestMip(uint32 id, uint32 mip)
+{
+	mResidency.RequestMip(id, mip, mFrame);
+}
+
+HRESULT TextureStreamer::Update(ID3D12GraphicsCommandList* cmdList, UINT64 frameFence, UINT64 completedFence)
+{
+	auto done = std::remove_if(mRetired.begin(), mRetired.end(), [completedFence](const Retired& retired)
+	{
+		return retired.Fence <= completedFence;
+	});
+	for (auto it = done; it != mRetired.end(); ++it)
+		mResidency.SetBusy(it->Texture, false);
+	mRetired.erase(done, mRetired.end());
+
+	mChanges.clear();
+	mResidency.Update(mFrame++, mChanges);
+
+	// A change that fails, and every one after it, is taken back so the
+	// residency keeps matching the resources; the next Update retries them.
+	for (size_t i = 0; i < mChanges.size(); ++i)
+	{
+		HRESULT hr = Apply(cmdList, mChanges[i], frameFence);
+		if (FAILED(hr))
+		{
+			for (size_t j = i; j < mChanges.size(); ++j)
+				mResidency.Revert(mChanges[j]);
+			mChanges.resize(i);
+			return hr;
+		}
+	}
+
+	return S_OK;
+}
+
+HRESULT TextureStreamer::Apply(ID3D12GraphicsCommandList* cmdList, const TextureResidency::Change& change, UINT64 frameFence)
+{
+	Texture& texture = mTextures[change.Texture];
+	const DDSParser::TextureDesc& desc = texture.Layout.Desc;
+
+	const uint32 mipCount = desc.MipLevels;
+	const uint32 oldMips = mipCount - change.FromMip;     // 0 for the first upload
+	const uint32 newMips = mipCount - change.ToMip;
+
+	D3D12_RESOURCE_DESC texDesc = CD3DX12_RESOURCE_DESC::Tex2D(desc.Format,
+		std::max(desc.Width >> change.ToMip, 1u), std::max(desc.Height >> change.ToMip, 1u),
+		(UINT16)desc.ArraySize, (UINT16)newMips);
+
+	ComPtr<ID3D12Resource> resource;
+	HRESULT hr = mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&texDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&resource));
+	if (FAILED(hr))
+		return hr;
+
+	// Everything that can fail without touching cmdList comes first.
+	ComPtr<ID3D12Resource> upload;
+	UINT64 sliceBytes = 0;
+	uint32 uploadMips = change.ToMip < change.FromMip ? std::min(change.FromMip, mipCount) - change.ToMip : 0;
+	if (uploadMips > 0)
+	{
+		sliceBytes = AlignUp(GetRequiredIntermediateSize(resource.Get(), 0, uploadMips),
+			D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+		hr = mDevice->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(sliceBytes * desc.ArraySize),
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&upload));
+		if (FAILED(hr))
+			return hr;
+	}
+
+	// Mips the old resource already holds are copied over on the GPU.
+	if (oldMips > 0)
+	{
+		ID3D12Resource* old = texture.Resource.Get();
+		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(old,
+			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE));
+
+		uint32 firstShared = std::max(change.FromMip, change.ToMip);
+		for (uint32 slice = 0; slice < desc.ArraySize; ++slice)
+		{
+			for (uint32 mip = firstShared; mip < mipCount; ++mip)
+			{
+				CD3DX12_TEXTURE_COPY_LOCATION dst(resource.Get(), (mip - change.ToMip) + slice * newMips);
+				CD3DX12_TEXTURE_COPY_LOCATION src(old, (mip - change.FromMip) + slice * oldMips);
+				cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+			}
+		}
+	}
+
+	// Mips new to the GPU come from the mapped file, one run per array slice.
+	std::vector<D3D12_SUBRESOURCE_DATA> data(uploadMips);
+	for (uint32 slice = 0; slice < desc.ArraySize && uploadMips > 0; ++slice)
+	{
+		for (uint32 i = 0; i < uploadMips; ++i)
+		{
+			const DDSParser::Subresource& subresource =
+				texture.Layout.Subresources[texture.Layout.SubresourceIndex(change.ToMip + i, slice)];
+			data[i].pData = texture.File.Data() + subresource.Offset;
+			data[i].RowPitch = static_cast<LONG_PTR>(subresource.RowPitch);
+			data[i].SlicePitch = static_cast<LONG_PTR>(subresource.SlicePitch);
+		}
+
+		if (UpdateSubresources(cmdList, resource.Get(), upload.Get(), sliceBytes * slice,
+			slice * newMips, uploadMips, data.data()) == 0)
+		{
+			// cmdList already refers to the new resources: keep them until the
+			// fence, and hand the old one back to the shaders unchanged.
+			if (oldMips > 0)
+			{
+				cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(texture.Resource.Get(),
+					D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+			}
+
+			Retired retired;
+			retired.Texture = change.Texture;
+			retired.Fence = frameFence;
+			retired.Resource = std::move(resource);
+			retired.Upload = std::move(upload);
+			mRetired.push_back(std::move(retired));
+			mResidency.SetBusy(change.Texture, true);
+			return E_FAIL;
+		}
+	}
+
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+	// Frames already submitted keep reading the old resource through the old
+	// descriptor; both stay until this frame's fence.
+	Retired retired;
+	retired.Texture = change.Texture;
+	retired.Fence = frameFence;
+	retired.Resource = std::move(texture.Resource);
+	retired.Upload = std::move(upload);
+	mRetired.push_back(std::move(retired));
+	mResidency.SetBusy(change.Texture, true);
+
+	texture.Resource = std::move(resource);
+	texture.ResidentMip = change.ToMip;
+	if (oldMips > 0)
+		texture.Slot ^= 1;
+	WriteSrv(change.Texture);
+
+	return S_OK;
+}
+
+void TextureStreamer::WriteSrv(uint32 id)
+{
+	if (mHeap == nullptr)
+		return;
+
+	const Texture& texture = mTextures[id];
+	const DDSParser::TextureDesc& desc = texture.Layout.Desc;
+	const UINT mipLevels = desc.MipLevels - texture.ResidentMip;
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = desc.Format;
+
+	if (desc.IsCubeMap)
+	{
+		if (desc.ArraySize > 6)
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBEARRAY;
+			srvDesc.TextureCubeArray.MipLevels = mipLevels;
+			srvDesc.TextureCubeArray.NumCubes = desc.ArraySize / 6;
+		}
+		else
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+			srvDesc.TextureCube.MipLevels = mipLevels;
+		}
+	}
+	else if (desc.ArraySize > 1)
+	{
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+		srvDesc.Texture2DArray.MipLevels = mipLevels;
+		srvDesc.Texture2DArray.ArraySize = desc.ArraySize;
+	}
+	else
+	{
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MipLevels = mipLevels;
+	}
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE handle(mHeap->GetCPUDescriptorHandleForHeapStart(),
+		(INT)SrvHeapIndex(id), mDescriptorSize);
+	mDevice->CreateShaderResourceView(texture.Resource.Get(), &srvDesc, handle);
+}
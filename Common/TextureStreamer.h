@@ -0,0 +1,125 @@
+//***************************************************************************************
+// TextureStreamer.h
+//
+// Carries out TextureResidency's decisions on D3D12 textures.  Each texture is
+// added from a DDS file, which stays mapped so any of its mips can be uploaded
+// again later; only its mip tail goes to the GPU at first.  The renderer reports
+// the finest mip it wants per texture each frame and calls Update once per
+// frame, which records the uploads and evictions on the frame's command list.
+//
+// A texture's resident mips live in one committed resource holding just those
+// mips.  A change creates a new resource, copies the mips the two share from the
+// old one, uploads the new ones from the file and points the texture's SRV at
+// it.  The old resource, the upload buffer and the descriptor the GPU may still
+// read are kept until the fence value of the frame that made the change has
+// completed; the texture is left alone until then.  Each texture has two
+// descriptors in the caller's heap which its SRV alternates between, so always
+// look the index up with SrvHeapIndex when binding.
+//
+// 2D textures, 2D arrays and cube maps are supported.  Block compressed ones
+// need whole blocks in every mip down to the tail, as any of them may become a
+// resource's top mip.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "DDSParser.h"
+#include "MappedFile.h"
+#include "TextureResidency.h"
+#include <vector>
+
+class TextureStreamer
+{
+public:
+
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+#ifdef _WIN32
+	using Path = std::wstring;
+#else
+	using Path = std::string;
+#endif
+
+	struct Options
+	{
+		TextureResidency::Options Residency;
+	};
+
+	TextureStreamer(ID3D12Device* device, const Options& options);
+	TextureStreamer(const TextureStreamer& rhs) = delete;
+	TextureStreamer& operator=(const TextureStreamer& rhs) = delete;
+
+	///<summary>
+	/// Maps and parses filename and starts streaming it; nothing is resident
+	/// until the next Update.  id is the texture's index, also used for its
+	/// descriptors.
+	///</summary>
+	HRESULT Add(const Path& filename, uint32& id);
+
+	///<summary>
+	/// Descriptors of texture id go at firstHeapIndex + 2 * id and the one after
+	/// it.  heap must hold two per texture and stay alive while streaming.
+	///</summary>
+	void SetDescriptorHeap(ID3D12DescriptorHeap* heap, UINT firstHeapIndex, UINT descriptorSize);
+
+	// Heap index of texture id's current SRV.
+	UINT SrvHeapIndex(uint32 id)const;
+
+	// Feedback for the frame about to be recorded: id is wanted down to mip.
+	void RequestMip(uint32 id, uint32 mip);
+
+	///<summary>
+	/// Releases what frames up to completedFence were using, decides this
+	/// frame's residency and records the changes on cmdList.  frameFence is the
+	/// value the caller signals once cmdList has executed.  On failure the
+	/// changes not carried out are taken back from the residency and retried
+	/// on a later Update.
+	///</summary>
+	HRESULT Update(ID3D12GraphicsCommandList* cmdList, UINT64 frameFence, UINT64 completedFence);
+
+	void SetBudget(uint64 budget) { mResidency.SetBudget(budget); }
+
+	// nullptr until the texture's first Update.
+	ID3D12Resource* Resource(uint32 id)const { return mTextures[id].Resource.Get(); }
+
+	uint32 ResidentMip(uint32 id)const { return mResidency.ResidentMip(id); }
+
+	const TextureResidency::Stats& GetStats()const { return mResidency.GetStats(); }
+
+private:
+	struct Texture
+	{
+		MappedFile File;
+		DDSParser::Texture Layout;      // offsets into File
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		uint32 ResidentMip = 0;         // file mip held as mip 0 of Resource
+		UINT Slot = 0;                  // which of the two descriptors is current
+	};
+
+	// Kept until the GPU has passed Fence.
+	struct Retired
+	{
+		uint32 Texture = 0;
+		UINT64 Fence = 0;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Upload;
+	};
+
+	HRESULT Apply(ID3D12GraphicsCommandList* cmdList, const TextureResidency::Change& change, UINT64 frameFence);
+	void WriteSrv(uint32 id);
+
+	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+	TextureResidency mResidency;
+	uint32 mTailSize = 0;
+	std::vector<Texture> mTextures;
+	std::vector<Retired> mRetired;
+	std::vector<TextureResidency::Change> mChanges;
+
+	ID3D12DescriptorHeap* mHeap = nullptr;
+	UINT mFirstHeapIndex = 0;
+	UINT mDescriptorSize = 0;
+
+	uint64 mFrame = 0;
+};
@@ -0,0 +1,135 @@
+//***************************************************************************************
+// ThreadPool.cpp
+//***************************************************************************************
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace
+{
+	// Shared between the caller of ParallelFor and the helper tasks it queued.
+	// Helpers may start after the loop is already finished, so they hold their
+	// own reference and never touch fn once every index has been claimed.
+	struct ParallelForState
+	{
+		std::atomic<std::uint32_t> Next{ 0 };
+		std::atomic<std::uint32_t> Done{ 0 };
+		std::uint32_t Count = 0;
+		const std::function<void(std::uint32_t)>* Fn = nullptr;
+
+		std::mutex Mutex;
+		std::condition_variable Finished;
+		std::exception_ptr Error;
+
+		void Run()
+		{
+			for(;;)
+			{
+				std::uint32_t i = Next.fetch_add(1);
+				if(i >= Count)
+					return;
+
+				try
+				{
+					(*Fn)(i);
+				}
+				catch(...)
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					if(!Error)
+						Error = std::current_exception();
+				}
+
+				if(Done.fetch_add(1) + 1 == Count)
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					Finished.notify_all();
+				}
+			}
+		}
+	};
+}
+
+ThreadPool::ThreadPool(std::uint32_t threadCount)
+{
+	if(threadCount == 0)
+	{
+		std::uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	mThreads.reserve(threadCount);
+	for(std::uint32_t i = 0; i < threadCount; ++i)
+		mThreads.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mWakeUp.notify_all();
+
+	for(std::thread& t : mThreads)
+		t.join();
+}
+
+ThreadPool& ThreadPool::Default()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::ParallelFor(std::uint32_t count, const std::function<void(std::uint32_t)>& fn)
+{
+	if(count == 0)
+		return;
+
+	auto state = std::make_shared<ParallelForState>();
+	state->Count = count;
+	state->Fn = &fn;
+
+	std::uint32_t helpers = std::min<std::uint32_t>(count - 1, ThreadCount());
+	for(std::uint32_t i = 0; i < helpers; ++i)
+		Enqueue([state]() { state->Run(); });
+
+	state->Run();
+
+	std::unique_lock<std::mutex> lock(state->Mutex);
+	state->Finished.wait(lock, [&state]() { return state->Done.load() == state->Count; });
+
+	if(state->Error)
+		std::rethrow_exception(state->Error);
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTasks.push(std::move(task));
+	}
+	mWakeUp.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	for(;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWakeUp.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+
+			if(mStopping && mTasks.empty())
+				return;
+
+			task = std::move(mTasks.front());
+			mTasks.pop();
+		}
+
+		task();
+	}
+}
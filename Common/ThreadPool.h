@@ -0,0 +1,62 @@
+//***************************************************************************************
+// ThreadPool.h
+//
+// A fixed set of worker threads for load-time jobs (mesh generation, model
+// parsing, texture decoding).  Work is either submitted as individual tasks that
+// return a std::future, or spread over an index range with ParallelFor.
+//***************************************************************************************
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	// threadCount == 0 uses one worker per hardware thread, minus the caller's.
+	explicit ThreadPool(std::uint32_t threadCount = 0);
+	ThreadPool(const ThreadPool& rhs) = delete;
+	ThreadPool& operator=(const ThreadPool& rhs) = delete;
+	~ThreadPool();
+
+	// Process-wide pool shared by the Common helpers.
+	static ThreadPool& Default();
+
+	std::uint32_t ThreadCount()const { return (std::uint32_t)mThreads.size(); }
+
+	// Queues fn on a worker and returns a future for its result.
+	template<typename Fn>
+	auto Submit(Fn&& fn) -> std::future<decltype(fn())>
+	{
+		using Result = decltype(fn());
+
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+		std::future<Result> result = task->get_future();
+		Enqueue([task]() { (*task)(); });
+
+		return result;
+	}
+
+	// Calls fn(i) for every i in [0, count) and returns once all calls are done.
+	// The calling thread takes part, so this is safe to use from inside a task.
+	// The first exception thrown by fn is rethrown here.
+	void ParallelFor(std::uint32_t count, const std::function<void(std::uint32_t)>& fn);
+
+private:
+	void Enqueue(std::function<void()> task);
+	void WorkerLoop();
+
+	std::vector<std::thread> mThreads;
+	std::queue<std::function<void()>> mTasks;
+	std::mutex mMutex;
+	std::condition_variable mWakeUp;
+	bool mStopping = false;
+};
@@ -0,0 +1,407 @@
+//***************************************************************************************
+// VertexQuantizer.cpp
+//***************************************************************************************
+
+#include "VertexQuantizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+using uint8 = VertexQuantizer::uint8;
+using uint16 = VertexQuantizer::uint16;
+using uint32 = VertexQuantizer::uint32;
+
+namespace
+{
+	template<typename T>
+	T ReadAttribute(const void* vertices, uint32 stride, int offset, size_t i)
+	{
+		T value;
+		std::memcpy(&value, static_cast<const char*>(vertices) + i*stride + offset, sizeof(T));
+		return value;
+	}
+
+	template<typename T>
+	void WriteAttribute(std::vector<uint8>& data, uint32 stride, int offset, size_t i, const T& value)
+	{
+		std::memcpy(data.data() + i*stride + offset, &value, sizeof(T));
+	}
+
+	// Sign that treats +0 and -0 as positive, as the octahedral fold needs.
+	float SignNotZero(float v)
+	{
+		return v >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	// atan2 of |a x b| and a.b stays accurate for the tiny angles 16-bit
+	// normals produce, where acos of the dot product bottoms out near 0.02 deg.
+	float AngleDegrees(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		XMVECTOR A = XMLoadFloat3(&a);
+		XMVECTOR B = XMLoadFloat3(&b);
+
+		float sine = XMVectorGetX(XMVector3Length(XMVector3Cross(A, B)));
+		float cosine = XMVectorGetX(XMVector3Dot(A, B));
+		if(sine == 0.0f && cosine == 0.0f)
+			return 0.0f;
+
+		return XMConvertToDegrees(atan2f(sine, cosine));
+	}
+
+	float Distance(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMVectorGetX(XMVector3Length(XMLoadFloat3(&a) - XMLoadFloat3(&b)));
+	}
+
+	// Tries the four grid points around the exact octahedral coordinates and
+	// keeps the one whose decode is closest to n.  SnormT is int16 or int8.
+	template<typename SnormT, typename EncodeFn, typename DecodeFn>
+	void OctEncodePrecise(const XMFLOAT3& n, float maxValue, SnormT out[2], EncodeFn encode, DecodeFn decode)
+	{
+		XMFLOAT2 e = VertexQuantizer::OctEncode(n);
+
+		float x0 = floorf(e.x*maxValue);
+		float y0 = floorf(e.y*maxValue);
+
+		XMVECTOR N = XMVector3Normalize(XMLoadFloat3(&n));
+		float bestDot = -FLT_MAX;
+
+		for(int i = 0; i < 4; ++i)
+		{
+			float x = (x0 + (i & 1)) / maxValue;
+			float y = (y0 + (i >> 1)) / maxValue;
+
+			SnormT candidate[2] = { encode(x), encode(y) };
+			XMFLOAT3 d = decode(candidate);
+
+			float dot = XMVectorGetX(XMVector3Dot(N, XMLoadFloat3(&d)));
+			if(dot > bestDot)
+			{
+				bestDot = dot;
+				out[0] = candidate[0];
+				out[1] = candidate[1];
+			}
+		}
+	}
+}
+
+VertexQuantizer::EncodedVertices VertexQuantizer::Encode(const void* vertices, size_t vertexCount,
+	const GeometryGenerator::VertexLayout& sourceLayout, const Options& options,
+	const std::vector<VertexRange>& ranges)
+{
+	assert(sourceLayout.PositionOffset >= 0 && sourceLayout.NormalOffset >= 0);
+
+	EncodedVertices result;
+	result.Normals = options.Normals;
+
+	//
+	// Lay out the encoded vertex.  Positions take 8 bytes, each octahedral
+	// vector 4 or 2, and the texcoords start on a 4 byte boundary as the
+	// input assembler wants.
+	//
+
+	bool tangentUs = options.TangentUs && sourceLayout.TangentUOffset >= 0;
+	bool texCs = options.TexCs && sourceLayout.TexCOffset >= 0;
+	uint32 octSize = options.Normals == NormalBits::Oct16 ? 4 : 2;
+
+	GeometryGenerator::VertexLayout& layout = result.Layout;
+	uint32 offset = 0;
+
+	layout.PositionOffset = offset;
+	offset += 4*sizeof(uint16);
+
+	layout.NormalOffset = offset;
+	offset += octSize;
+
+	if(tangentUs)
+	{
+		layout.TangentUOffset = offset;
+		offset += octSize;
+	}
+
+	offset = (offset + 3) & ~3u;
+
+	if(texCs)
+	{
+		layout.TexCOffset = offset;
+		offset += 2*sizeof(HALF);
+	}
+
+	layout.Stride = offset;
+
+	result.Data.assign(vertexCount*layout.Stride, 0);
+
+	std::vector<VertexRange> allRanges = ranges;
+	if(allRanges.empty())
+		allRanges.push_back({ 0, (uint32)vertexCount });
+
+	const uint32 sourceStride = sourceLayout.Stride;
+
+	ErrorReport& errors = result.Errors;
+	errors.SourceBytes = vertexCount*sourceStride;
+	errors.EncodedBytes = result.Data.size();
+
+	for(const VertexRange& range : allRanges)
+	{
+		assert((size_t)range.FirstVertex + range.VertexCount <= vertexCount);
+
+		//
+		// Bounding box of the range, and the transform that maps it onto [0, 1].
+		//
+
+		XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+		XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+		for(size_t i = range.FirstVertex; i < range.FirstVertex + range.VertexCount; ++i)
+		{
+			XMFLOAT3 p = ReadAttribute<XMFLOAT3>(vertices, sourceStride, sourceLayout.PositionOffset, i);
+			vMin = XMVectorMin(vMin, XMLoadFloat3(&p));
+			vMax = XMVectorMax(vMax, XMLoadFloat3(&p));
+		}
+
+		XMFLOAT3 boundsMin(0.0f, 0.0f, 0.0f);
+		XMFLOAT3 boundsMax(0.0f, 0.0f, 0.0f);
+		if(range.VertexCount > 0)
+		{
+			XMStoreFloat3(&boundsMin, vMin);
+			XMStoreFloat3(&boundsMax, vMax);
+		}
+
+		PositionTransform transform = MakeTransform(boundsMin, boundsMax);
+		result.Transforms.push_back(transform);
+
+		const float offsets[3] = { transform.Offset.x, transform.Offset.y, transform.Offset.z };
+		const float scales[3] = { transform.Scale.x, transform.Scale.y, transform.Scale.z };
+
+		//
+		// Encode, then decode again to measure what was lost.
+		//
+
+		for(size_t i = range.FirstVertex; i < range.FirstVertex + range.VertexCount; ++i)
+		{
+			XMFLOAT3 p = ReadAttribute<XMFLOAT3>(vertices, sourceStride, sourceLayout.PositionOffset, i);
+			const float coords[3] = { p.x, p.y, p.z };
+
+			uint16 q[4] = { 0, 0, 0, 0 };
+			for(int c = 0; c < 3; ++c)
+				q[c] = scales[c] > 0.0f ? FloatToUnorm16((coords[c] - offsets[c]) / scales[c]) : 0;
+			WriteAttribute(result.Data, layout.Stride, layout.PositionOffset, i, q);
+
+			XMFLOAT3 n = ReadAttribute<XMFLOAT3>(vertices, sourceStride, sourceLayout.NormalOffset, i);
+			XMFLOAT3 t(0.0f, 0.0f, 0.0f);
+			if(tangentUs)
+				t = ReadAttribute<XMFLOAT3>(vertices, sourceStride, sourceLayout.TangentUOffset, i);
+
+			if(options.Normals == NormalBits::Oct16)
+			{
+				std::int16_t e[2];
+				OctEncode16(n, e);
+				WriteAttribute(result.Data, layout.Stride, layout.NormalOffset, i, e);
+
+				if(tangentUs)
+				{
+					OctEncode16(t, e);
+					WriteAttribute(result.Data, layout.Stride, layout.TangentUOffset, i, e);
+				}
+			}
+			else
+			{
+				std::int8_t e[2];
+				OctEncode8(n, e);
+				WriteAttribute(result.Data, layout.Stride, layout.NormalOffset, i, e);
+
+				if(tangentUs)
+				{
+					OctEncode8(t, e);
+					WriteAttribute(result.Data, layout.Stride, layout.TangentUOffset, i, e);
+				}
+			}
+
+			errors.MaxPositionError = std::max(errors.MaxPositionError, Distance(p, DecodePosition(result, i, transform)));
+			errors.MaxNormalAngle = std::max(errors.MaxNormalAngle, AngleDegrees(n, DecodeNormal(result, i)));
+			if(tangentUs)
+				errors.MaxTangentAngle = std::max(errors.MaxTangentAngle, AngleDegrees(t, DecodeTangentU(result, i)));
+
+			if(texCs)
+			{
+				XMFLOAT2 uv = ReadAttribute<XMFLOAT2>(vertices, sourceStride, sourceLayout.TexCOffset, i);
+				HALF h[2] = { XMConvertFloatToHalf(uv.x), XMConvertFloatToHalf(uv.y) };
+				WriteAttribute(result.Data, layout.Stride, layout.TexCOffset, i, h);
+
+				XMFLOAT2 decoded = DecodeTexC(result, i);
+				errors.MaxTexCError = std::max(errors.MaxTexCError,
+					std::max(fabsf(decoded.x - uv.x), fabsf(decoded.y - uv.y)));
+			}
+		}
+	}
+
+	return result;
+}
+
+VertexQuantizer::EncodedVertices VertexQuantizer::Encode(const GeometryGenerator::MeshData& meshData, const Options& options,
+	const std::vector<VertexRange>& ranges)
+{
+	GeometryGenerator::VertexLayout layout;
+	layout.Stride = sizeof(GeometryGenerator::Vertex);
+	layout.PositionOffset = offsetof(GeometryGenerator::Vertex, Position);
+	layout.NormalOffset = offsetof(GeometryGenerator::Vertex, Normal);
+	layout.TangentUOffset = offsetof(GeometryGenerator::Vertex, TangentU);
+	layout.TexCOffset = offsetof(GeometryGenerator::Vertex, TexC);
+
+	return Encode(meshData.Vertices.data(), meshData.Vertices.size(), layout, options, ranges);
+}
+
+VertexQuantizer::PositionTransform VertexQuantizer::MakeTransform(const XMFLOAT3& boundsMin, const XMFLOAT3& boundsMax)
+{
+	PositionTransform transform;
+	transform.Offset = boundsMin;
+	transform.Scale.x = std::max(0.0f, boundsMax.x - boundsMin.x);
+	transform.Scale.y = std::max(0.0f, boundsMax.y - boundsMin.y);
+	transform.Scale.z = std::max(0.0f, boundsMax.z - boundsMin.z);
+	return transform;
+}
+
+uint16 VertexQuantizer::FloatToUnorm16(float v)
+{
+	v = std::min(1.0f, std::max(0.0f, v));
+	return (uint16)(v*65535.0f + 0.5f);
+}
+
+float VertexQuantizer::Unorm16ToFloat(uint16 v)
+{
+	return v / 65535.0f;
+}
+
+std::int16_t VertexQuantizer::FloatToSnorm16(float v)
+{
+	v = std::min(1.0f, std::max(-1.0f, v));
+	return (std::int16_t)roundf(v*32767.0f);
+}
+
+float VertexQuantizer::Snorm16ToFloat(std::int16_t v)
+{
+	// -32768 and -32767 both map to -1.
+	return std::max(-1.0f, v / 32767.0f);
+}
+
+std::int8_t VertexQuantizer::FloatToSnorm8(float v)
+{
+	v = std::min(1.0f, std::max(-1.0f, v));
+	return (std::int8_t)roundf(v*127.0f);
+}
+
+float VertexQuantizer::Snorm8ToFloat(std::int8_t v)
+{
+	return std::max(-1.0f, v / 127.0f);
+}
+
+XMFLOAT2 VertexQuantizer::OctEncode(const XMFLOAT3& n)
+{
+	float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	if(l1 <= 0.0f)
+		return XMFLOAT2(0.0f, 0.0f);
+
+	float x = n.x / l1;
+	float y = n.y / l1;
+
+	// Fold the lower hemisphere over the diagonals.
+	if(n.z < 0.0f)
+	{
+		float fx = (1.0f - fabsf(y)) * SignNotZero(x);
+		float fy = (1.0f - fabsf(x)) * SignNotZero(y);
+		x = fx;
+		y = fy;
+	}
+
+	return XMFLOAT2(x, y);
+}
+
+XMFLOAT3 VertexQuantizer::OctDecode(const XMFLOAT2& e)
+{
+	XMFLOAT3 n(e.x, e.y, 1.0f - fabsf(e.x) - fabsf(e.y));
+
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+
+	XMStoreFloat3(&n, XMVector3Normalize(XMLoadFloat3(&n)));
+	return n;
+}
+
+void VertexQuantizer::OctEncode16(const XMFLOAT3& n, std::int16_t out[2])
+{
+	OctEncodePrecise(n, 32767.0f, out, FloatToSnorm16,
+		[](const std::int16_t e[2]) { return OctDecode16(e); });
+}
+
+void VertexQuantizer::OctEncode8(const XMFLOAT3& n, std::int8_t out[2])
+{
+	OctEncodePrecise(n, 127.0f, out, FloatToSnorm8,
+		[](const std::int8_t e[2]) { return OctDecode8(e); });
+}
+
+XMFLOAT3 VertexQuantizer::OctDecode16(const std::int16_t e[2])
+{
+	return OctDecode(XMFLOAT2(Snorm16ToFloat(e[0]), Snorm16ToFloat(e[1])));
+}
+
+XMFLOAT3 VertexQuantizer::OctDecode8(const std::int8_t e[2])
+{
+	return OctDecode(XMFLOAT2(Snorm8ToFloat(e[0]), Snorm8ToFloat(e[1])));
+}
+
+XMFLOAT3 VertexQuantizer::DecodePosition(const EncodedVertices& encoded, size_t i, const PositionTransform& transform)
+{
+	const GeometryGenerator::VertexLayout& layout = encoded.Layout;
+
+	uint16 q[4];
+	std::memcpy(q, encoded.Data.data() + i*layout.Stride + layout.PositionOffset, sizeof(q));
+
+	return XMFLOAT3(
+		transform.Offset.x + Unorm16ToFloat(q[0])*transform.Scale.x,
+		transform.Offset.y + Unorm16ToFloat(q[1])*transform.Scale.y,
+		transform.Offset.z + Unorm16ToFloat(q[2])*transform.Scale.z);
+}
+
+XMFLOAT3 VertexQuantizer::DecodeNormal(const EncodedVertices& encoded, size_t i)
+{
+	return DecodeOct(encoded, encoded.Layout.NormalOffset, i);
+}
+
+XMFLOAT3 VertexQuantizer::DecodeTangentU(const EncodedVertices& encoded, size_t i)
+{
+	assert(encoded.Layout.TangentUOffset >= 0);
+	return DecodeOct(encoded, encoded.Layout.TangentUOffset, i);
+}
+
+XMFLOAT3 VertexQuantizer::DecodeOct(const EncodedVertices& encoded, int offset, size_t i)
+{
+	const uint8* src = encoded.Data.data() + i*encoded.Layout.Stride + offset;
+
+	if(encoded.Normals == NormalBits::Oct16)
+	{
+		std::int16_t e[2];
+		std::memcpy(e, src, sizeof(e));
+		return OctDecode16(e);
+	}
+
+	std::int8_t e[2];
+	std::memcpy(e, src, sizeof(e));
+	return OctDecode8(e);
+}
+
+XMFLOAT2 VertexQuantizer::DecodeTexC(const EncodedVertices& encoded, size_t i)
+{
+	assert(encoded.Layout.TexCOffset >= 0);
+
+	HALF h[2];
+	std::memcpy(h, encoded.Data.data() + i*encoded.Layout.Stride + encoded.Layout.TexCOffset, sizeof(h));
+
+	return XMFLOAT2(XMConvertHalfToFloat(h[0]), XMConvertHalfToFloat(h[1]));
+}
@@ -0,0 +1,145 @@
+//***************************************************************************************
+// VertexQuantizer.h
+//
+// Compresses vertices for the GPU.  Each attribute gets the smallest encoding
+// the input assembler can expand back to floats on its own:
+//
+//   position  4 x 16-bit UNORM inside the AABB of its submesh, w unused
+//             (R16G16B16A16_UNORM); pos = Offset + q*Scale
+//   normal,   octahedral in 2 x 16-bit SNORM (R16G16_SNORM) or
+//   tangent   2 x 8-bit SNORM (R8G8_SNORM); the shader unfolds it as OctDecode
+//   texcoord  2 x half float (R16G16_FLOAT)
+//
+// A 32 byte pos/normal/uv vertex becomes 16 bytes, a 44 byte GeometryGenerator
+// vertex 20 bytes (16 with 8-bit normals).  Offset/Scale of each submesh must
+// reach the vertex shader, e.g. through the object constants.
+//
+// Every encode comes with an ErrorReport measured by decoding the result with
+// the helpers below, so the numbers are what the shader will see.
+//***************************************************************************************
+
+#pragma once
+
+#include "GeometryGenerator.h"
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+class VertexQuantizer
+{
+public:
+
+	using uint8 = std::uint8_t;
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+
+	enum class NormalBits
+	{
+		Oct16,
+		Oct8
+	};
+
+	struct Options
+	{
+		NormalBits Normals = NormalBits::Oct16;
+		bool TangentUs = false;     // only read if the source layout has them
+		bool TexCs = true;          // likewise
+	};
+
+	// A run of vertices quantized against one bounding box, usually a submesh.
+	struct VertexRange
+	{
+		uint32 FirstVertex = 0;
+		uint32 VertexCount = 0;
+	};
+
+	// Dequantization constants of one VertexRange: pos = Offset + q*Scale with q
+	// the UNORM value in [0, 1].
+	struct PositionTransform
+	{
+		DirectX::XMFLOAT3 Offset = { 0.0f, 0.0f, 0.0f };
+		DirectX::XMFLOAT3 Scale = { 1.0f, 1.0f, 1.0f };
+	};
+
+	struct ErrorReport
+	{
+		float MaxPositionError = 0.0f;      // object-space distance
+		float MaxNormalAngle = 0.0f;        // degrees
+		float MaxTangentAngle = 0.0f;       // degrees
+		float MaxTexCError = 0.0f;          // absolute, per component
+		size_t SourceBytes = 0;
+		size_t EncodedBytes = 0;
+	};
+
+	struct EncodedVertices
+	{
+		// Byte offsets inside one encoded vertex, -1 for attributes left out.
+		GeometryGenerator::VertexLayout Layout;
+		NormalBits Normals = NormalBits::Oct16;
+		std::vector<PositionTransform> Transforms;  // one per VertexRange
+		std::vector<uint8> Data;
+		ErrorReport Errors;
+
+		size_t VertexCount()const { return Layout.Stride ? Data.size() / Layout.Stride : 0; }
+	};
+
+	///<summary>
+	/// Encodes vertexCount interleaved vertices described by sourceLayout, which
+	/// must have a position and a normal.  Each range is quantized against its
+	/// own bounding box; pass no ranges to treat all vertices as one.  The
+	/// ranges must not overlap and every vertex must be in one.
+	///</summary>
+	static EncodedVertices Encode(const void* vertices, size_t vertexCount,
+		const GeometryGenerator::VertexLayout& sourceLayout, const Options& options,
+		const std::vector<VertexRange>& ranges = std::vector<VertexRange>());
+
+	static EncodedVertices Encode(const GeometryGenerator::MeshData& meshData, const Options& options,
+		const std::vector<VertexRange>& ranges = std::vector<VertexRange>());
+
+	///<summary>
+	/// Offset and Scale that map [boundsMin, boundsMax] onto [0, 1].  Flat axes
+	/// get a zero scale and decode to the bound itself.
+	///</summary>
+	static PositionTransform MakeTransform(const DirectX::XMFLOAT3& boundsMin, const DirectX::XMFLOAT3& boundsMax);
+
+	//
+	// Scalar encodings.  The snorm/unorm conversions round to nearest and match
+	// the D3D conversion rules, so decoding here agrees with the hardware.
+	//
+
+	static uint16 FloatToUnorm16(float v);
+	static float Unorm16ToFloat(uint16 v);
+	static std::int16_t FloatToSnorm16(float v);
+	static float Snorm16ToFloat(std::int16_t v);
+	static std::int8_t FloatToSnorm8(float v);
+	static float Snorm8ToFloat(std::int8_t v);
+
+	///<summary>
+	/// Maps a unit vector onto the octahedron unfolded into [-1, 1]^2.
+	///</summary>
+	static DirectX::XMFLOAT2 OctEncode(const DirectX::XMFLOAT3& n);
+	static DirectX::XMFLOAT3 OctDecode(const DirectX::XMFLOAT2& e);
+
+	///<summary>
+	/// Octahedral encode into snorm pairs.  Of the four neighbouring grid points
+	/// the one that decodes closest to n is kept, which cuts the worst error of
+	/// plain rounding by about a third.
+	///</summary>
+	static void OctEncode16(const DirectX::XMFLOAT3& n, std::int16_t out[2]);
+	static void OctEncode8(const DirectX::XMFLOAT3& n, std::int8_t out[2]);
+	static DirectX::XMFLOAT3 OctDecode16(const std::int16_t e[2]);
+	static DirectX::XMFLOAT3 OctDecode8(const std::int8_t e[2]);
+
+	//
+	// Decoders for one vertex of an EncodedVertices.  transform is the
+	// PositionTransform of the vertex's range.
+	//
+
+	static DirectX::XMFLOAT3 DecodePosition(const EncodedVertices& encoded, size_t i, const PositionTransform& transform);
+	static DirectX::XMFLOAT3 DecodeNormal(const EncodedVertices& encoded, size_t i);
+	static DirectX::XMFLOAT3 DecodeTangentU(const EncodedVertices& encoded, size_t i);
+	static DirectX::XMFLOAT2 DecodeTexC(const EncodedVertices& encoded, size_t i);
+
+private:
+	static DirectX::XMFLOAT3 DecodeOct(const EncodedVertices& encoded, int offset, size_t i);
+};
@@ -52,6 +52,9 @@ protected:
 
     virtual void OnKeyboardInput(WPARAM wParam) { }
 
+    // Extra statistics appended to the window caption after fps and mspf.
+    virtual std::wstring FrameStatsText() const { return std::wstring(); }
+
 protected:
     bool InitMainWindow();
     bool InitDirect3D();
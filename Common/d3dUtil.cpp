@@ -111,6 +111,24 @@ ComPtr<ID3DBlob> d3dUtil::CompileShader(
     return byteCode;
 }
 
+void MeshGeometry::SetIndices(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList,
+    const IndexPacker::PackedIndices& packed)
+{
+    IndexFormat = packed.Use16Bit ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    IndexBufferByteSize = packed.ByteSize();
+
+    ThrowIfFailed(D3DCreateBlob(IndexBufferByteSize, &IndexBufferCPU));
+    CopyMemory(IndexBufferCPU->GetBufferPointer(), packed.Data(), IndexBufferByteSize);
+
+    IndexBufferGPU = d3dUtil::CreateDefaultBuffer(device, cmdList, packed.Data(),
+        IndexBufferByteSize, IndexBufferUploader);
+
+    for (const IndexPacker::PackedSubmesh& range : packed.Submeshes) {
+        SubmeshGeometry submesh(range.IndexCount, range.StartIndexLocation, range.BaseVertexLocation);
+        DrawArgs[range.Name] = submesh;
+    }
+}
+
 std::wstring DxException::ToString() const
 {
     // Get the string description of the error code.
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "DDSTextureLoader.h"
+#include "IndexPacker.h"
 #include "MathHelper.h"
 #include "d3dx12.h"
 #include <D3Dcompiler.h>
@@ -156,6 +157,14 @@ struct SubmeshGeometry {
     // Bounding box of the geometry defined by this submesh.
     // This is used in later chapters of the book.
     DirectX::BoundingBox Bounds;
+
+    // Tighter volumes of the same geometry, filled by BoundsBuilder.
+    DirectX::BoundingSphere SphereBounds;
+    DirectX::BoundingOrientedBox OrientedBounds;
+
+    // For a simplified level of detail: how far, in object space, its surface
+    // may stray from the full-detail mesh.  Zero for full-detail submeshes.
+    float GeometricError = 0.0f;
 };
 
 struct MeshGeometry {
@@ -203,6 +212,11 @@ struct MeshGeometry {
         return ibv;
     }
 
+    // Copies packed indices to the CPU blob and a new default-heap index buffer,
+    // and fills IndexFormat, IndexBufferByteSize and DrawArgs from them.
+    void SetIndices(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList,
+        const IndexPacker::PackedIndices& packed);
+
     // We can free this memory after we finish upload to the GPU.
     void DisposeUploaders()
     {
@@ -29,6 +29,12 @@ cbuffer cbPerObject : register(b0)
 {
     float4x4 gWorld;
     float4x4 gTexTransform;
+
+    // Dequantization of QUANTIZED_VERTEX positions: posL = gPosOffset + q*gPosScale.
+    float3 gPosOffset;
+    float cbPerObjectPad3;
+    float3 gPosScale;
+    float cbPerObjectPad4;
 }
 
 cbuffer cbPass : register(b1)
@@ -67,12 +73,32 @@ cbuffer cbMaterial : register(b2)
     float4x4 gMatTransform;
 };
 
+#ifdef QUANTIZED_VERTEX
+// See VertexQuantizer.h: 16-bit UNORM position inside the mesh's box,
+// octahedral SNORM normal and half float texcoords, expanded by the input
+// assembler.
+struct VertexIn
+{
+    float4 PosQ : POSITION;
+    float2 NormalOct : NORMAL;
+    float2 TexC : TEXCOORD;
+};
+
+float3 OctDecode(float2 e)
+{
+    float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
+#else
 struct VertexIn
 {
     float3 PosL : POSITION;
     float3 NormalL : NORMAL;
     float2 TexC : TEXCOORD;
 };
+#endif
 
 struct VertexOut
 {
@@ -85,13 +111,21 @@ struct VertexOut
 VertexOut VS(VertexIn vin)
 {
     VertexOut vout = (VertexOut) 0.0f;
+
+#ifdef QUANTIZED_VERTEX
+    float3 posL = gPosOffset + vin.PosQ.xyz * gPosScale;
+    float3 normalL = OctDecode(vin.NormalOct);
+#else
+    float3 posL = vin.PosL;
+    float3 normalL = vin.NormalL;
+#endif
 	
     // Transform to world space.
-    float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 posW = mul(float4(posL, 1.0f), gWorld);
     vout.PosW = posW.xyz;
 
     // Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
-    vout.NormalW = mul(vin.NormalL, (float3x3) gWorld);
+    vout.NormalW = mul(normalL, (float3x3) gWorld);
 
     // Transform to homogeneous clip space.
     vout.PosH = mul(posW, gViewProj);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../Common/GeometryGenerator.h"
 #include "../Common/MathHelper.h"
 #include "../Common/UploadBuffer.h"
 #include "../Common/d3dUtil.h"
@@ -9,6 +10,12 @@ struct ObjectConstants {
     DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
     // 任 ?
     DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+
+    // Read only by the QUANTIZED_VERTEX shaders; see VertexQuantizer::PositionTransform.
+    DirectX::XMFLOAT3 PositionOffset = { 0.0f, 0.0f, 0.0f };
+    float cbPerObjectPad3 = 0.0f;
+    DirectX::XMFLOAT3 PositionScale = { 1.0f, 1.0f, 1.0f };
+    float cbPerObjectPad4 = 0.0f;
 };
 
 struct PassConstants {
@@ -52,6 +59,17 @@ struct Vertex {
     DirectX::XMFLOAT2 TexC; // 
 };
 
+// Where the GeometryGenerator::MeshDataSoA streams land inside Vertex.
+inline GeometryGenerator::VertexLayout VertexInterleaveLayout()
+{
+    GeometryGenerator::VertexLayout layout;
+    layout.Stride = sizeof(Vertex);
+    layout.PositionOffset = offsetof(Vertex, Pos);
+    layout.NormalOffset = offsetof(Vertex, Normal);
+    layout.TexCOffset = offsetof(Vertex, TexC);
+    return layout;
+}
+
 struct FrameResource {
     FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount)
     {
@@ -1,7 +1,18 @@
 
+#include "../Common/BoundsBuilder.h"
 #include "../Common/GeometryGenerator.h"
+#include "../Common/LodSelector.h"
 #include "../Common/MathHelper.h"
+#include "../Common/MeshCache.h"
+#include "../Common/MeshletBuilder.h"
+#include "../Common/ModelReader.h"
+#include "../Common/MeshOptimizer.h"
+#include "../Common/MeshSimplifier.h"
+#include "../Common/MeshWelder.h"
+#include "../Common/TextureLoadQueue.h"
+#include "../Common/ThreadPool.h"
 #include "../Common/UploadBuffer.h"
+#include "../Common/VertexQuantizer.h"
 #include "../Common/d3dApp.h"
 
 #include "FrameResource.h"
@@ -34,6 +45,19 @@ struct RenderItem {
     UINT IndexCount = 0;
     UINT StartIndexLocation = 0;
     int BaseVertexLocation = 0;
+
+    // Dequantization of the positions of a quantized Geo; identity otherwise.
+    VertexQuantizer::PositionTransform PositionTransform;
+
+    // Optional cluster data.  When set, only the index ranges the cluster
+    // culler left in DrawRanges are drawn.
+    const MeshletBuilder::MeshletData* Meshlets = nullptr;
+    std::vector<ClusterCuller::DrawRange> DrawRanges;
+
+    // Optional levels of detail.  When set, the per-frame LOD selection copies
+    // level LodLevel into IndexCount/StartIndexLocation/BaseVertexLocation.
+    const LodSelector::LodSet* Lods = nullptr;
+    int LodLevel = -1;
 };
 
 enum class RenderLayer : int {
@@ -42,6 +66,10 @@ enum class RenderLayer : int {
     Reflected, // 
     Transparent, // ͸
     Shadow, // Ӱ
+    // The same passes for meshes stored with VertexQuantizer.
+    OpaqueQuantized,
+    ReflectedQuantized,
+    ShadowQuantized,
     Count // õ
 };
 
@@ -58,6 +86,7 @@ private:
     virtual void OnResize() override;
     virtual void Update(const GameTimer& gt) override;
     virtual void Draw(const GameTimer& gt) override;
+    virtual std::wstring FrameStatsText() const override;
 
     virtual void OnMouseDown(WPARAM btnState, int x, int y) override;
     virtual void OnMouseUp(WPARAM btnState, int x, int y) override;
@@ -66,6 +95,8 @@ private:
     virtual void OnKeyboardInput(WPARAM wParam) override;
 
     void UpdateSkull(const GameTimer& gt);
+    void SelectLods();
+    void CullSkullClusters();
     void UpdateCamera(const GameTimer& gt);
     void AnimateMaterials(const GameTimer& gt);
     void UpdateObjectCBs(const GameTimer& gt);
@@ -79,6 +110,8 @@ private:
     void BuildShadersAndInputLayout();
     void BuildRoomGeometry();
     void BuildSkullGeometry();
+    bool LoadSkullText(std::vector<Vertex>& vertices, std::vector<std::uint32_t>& indices,
+        XMFLOAT3& boundsMin, XMFLOAT3& boundsMax);
     void BuildPSOs();
     void BuildFrameResources();
     void BuildMaterials();
@@ -106,12 +139,28 @@ private:
     std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> mPSOs;
 
     std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
+    std::vector<D3D12_INPUT_ELEMENT_DESC> mQuantizedInputLayout;
 
     // Cache render items of interest.
     RenderItem* mSkullRitem = nullptr; // ָȾָ
     RenderItem* mReflectedSkullRitem = nullptr; // ָȾָ
     RenderItem* mShadowedSkullRitem = nullptr; // ָӰȾָ
 
+    // Clusters of the skull mesh, in the order of its index buffer.
+    MeshletBuilder::MeshletData mSkullMeshlets;
+
+    // Dequantization of the skull's vertex buffer.
+    VertexQuantizer::PositionTransform mSkullPositionTransform;
+
+    // The skull and its simplified levels, shared by all three skull items.
+    LodSelector::LodSet mSkullLods;
+    LodSelector::Settings mLodSettings;
+    LodSelector::Stats mLodStats;
+
+    // What the last frame submitted, over all passes.
+    UINT mFrameDrawCalls = 0;
+    UINT mFrameTriangles = 0;
+
     // List of all the render items.
     std::vector<std::unique_ptr<RenderItem>> mAllRitems;
 
@@ -127,6 +176,8 @@ private:
     XMFLOAT4X4 mView = MathHelper::Identity4x4();
     XMFLOAT4X4 mProj = MathHelper::Identity4x4();
 
+    BoundingFrustum mCamFrustum;
+
     float mTheta = 1.24f * XM_PI;
     float mPhi = 0.42f * XM_PI;
     float mRadius = 12.0f;
@@ -142,6 +193,18 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+    // -benchmark-models times the model text reader against the old
+    // std::ifstream loop and reports the throughput instead of running the demo.
+    if (strstr(cmdLine, "-benchmark-models") != nullptr) {
+        std::string report;
+        for (const char* model : { "Models/skull.txt", "Models/car.txt" })
+            report += ModelReader::ToString(model, ModelReader::Benchmark(model)) + "\n";
+
+        ::OutputDebugStringA(report.c_str());
+        MessageBoxA(nullptr, report.c_str(), "Model reader benchmark", MB_OK);
+        return 0;
+    }
+
     try {
         StencilApp theApp(hInstance);
         if (!theApp.Initialize())
@@ -205,12 +268,16 @@ void StencilApp::OnResize()
     // The window resized, so update the aspect ratio and recompute the projection matrix.
     XMMATRIX P = XMMatrixPerspectiveFovLH(0.25f * MathHelper::Pi, AspectRatio(), 1.0f, 1000.0f);
     XMStoreFloat4x4(&mProj, P);
+
+    BoundingFrustum::CreateFromMatrix(mCamFrustum, P);
 }
 
 void StencilApp::Update(const GameTimer& gt)
 {
     UpdateCamera(gt);
     UpdateSkull(gt);
+    SelectLods();
+    CullSkullClusters();
     // Cycle through the circular frame resource array.
     mCurrFrameResourceIndex = (mCurrFrameResourceIndex + 1) % gNumFrameResources;
     mCurrFrameResource = mFrameResources[mCurrFrameResourceIndex].get();
@@ -237,6 +304,9 @@ void StencilApp::Draw(const GameTimer& gt)
     ThrowIfFailed(cmdListAlloc->Reset());
     ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), mPSOs["opaque"].Get()));
 
+    mFrameDrawCalls = 0;
+    mFrameTriangles = 0;
+
     mCommandList->RSSetViewports(1, &mScreenViewport); // ӿ
     mCommandList->RSSetScissorRects(1, &mScissorRect); // òü
 
@@ -257,6 +327,9 @@ void StencilApp::Draw(const GameTimer& gt)
     mCommandList->SetGraphicsRootConstantBufferView(2, passCB->GetGPUVirtualAddress()); // ø
     DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
 
+    mCommandList->SetPipelineState(mPSOs["opaqueQuantized"].Get());
+    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::OpaqueQuantized]);
+
     // 1ģ建ǾءһҪƶֻ
     mCommandList->OMSetStencilRef(1);
     mCommandList->SetPipelineState(mPSOs["markStencilMirrors"].Get());
@@ -267,6 +340,9 @@ void StencilApp::Draw(const GameTimer& gt)
     mCommandList->SetPipelineState(mPSOs["drawStencilReflections"].Get());
     DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Reflected]);
 
+    mCommandList->SetPipelineState(mPSOs["drawStencilReflectionsQuantized"].Get());
+    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::ReflectedQuantized]);
+
     //  CBģ建
     mCommandList->SetGraphicsRootConstantBufferView(2, passCB->GetGPUVirtualAddress());
     mCommandList->OMSetStencilRef(0);
@@ -279,6 +355,9 @@ void StencilApp::Draw(const GameTimer& gt)
     mCommandList->SetPipelineState(mPSOs["shadow"].Get());
     DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Shadow]);
 
+    mCommandList->SetPipelineState(mPSOs["shadowQuantized"].Get());
+    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::ShadowQuantized]);
+
     mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
 
     ThrowIfFailed(mCommandList->Close());
@@ -381,6 +460,68 @@ void StencilApp::UpdateSkull(const GameTimer& gt)
     mShadowedSkullRitem->NumFramesDirty = gNumFrameResources;
 }
 
+void StencilApp::SelectLods()
+{
+    // Every item is measured in the main pass; the reflected skull's world
+    // matrix already places it behind the mirror where it is seen.
+    XMMATRIX view = XMLoadFloat4x4(&mView);
+    float projScale = LodSelector::ProjectionScale(mProj, (float)mClientHeight);
+
+    mLodStats.Reset();
+    for (auto& e : mAllRitems) {
+        if (e->Lods == nullptr)
+            continue;
+
+        XMMATRIX world = XMLoadFloat4x4(&e->World);
+        int level = LodSelector::SelectLevel(*e->Lods, e->LodLevel, world, view, projScale, mLodSettings);
+        LodSelector::Record(*e->Lods, e->LodLevel, level, mLodStats);
+        if (level < 0)
+            continue;
+
+        const SubmeshGeometry& submesh = e->Lods->Levels[level];
+        e->LodLevel = level;
+        e->IndexCount = submesh.IndexCount;
+        e->StartIndexLocation = submesh.StartIndexLocation;
+        e->BaseVertexLocation = submesh.BaseVertexLocation;
+    }
+}
+
+std::wstring StencilApp::FrameStatsText() const
+{
+    std::wstring text = L"   draws: " + std::to_wstring(mFrameDrawCalls)
+        + L"   tris: " + std::to_wstring(mFrameTriangles)
+        + L" (full detail " + std::to_wstring(mLodStats.FullDetailTriangles)
+        + L" in " + std::to_wstring(mLodStats.Objects) + L" lod objects)   lods:";
+    for (int i = 0; i < LodSelector::MaxLevels && i < (int)mSkullLods.Levels.size(); ++i)
+        text += L" " + std::to_wstring(mLodStats.ObjectsPerLevel[i]);
+    return text;
+}
+
+void StencilApp::CullSkullClusters()
+{
+    // The clusters only describe the full-detail level.  Simplified levels are
+    // drawn whole.
+    if (mSkullRitem->LodLevel > 0)
+        return;
+
+    // The cluster bounds live in the skull's local space, so bring the camera
+    // frustum and eye there.  Only the unmirrored skull is culled this way: the
+    // reflection flips the winding and the shadow projection is degenerate.
+    XMMATRIX view = XMLoadFloat4x4(&mView);
+    XMMATRIX world = XMLoadFloat4x4(&mSkullRitem->World);
+    XMMATRIX invView = XMMatrixInverse(&XMMatrixDeterminant(view), view);
+    XMMATRIX invWorld = XMMatrixInverse(&XMMatrixDeterminant(world), world);
+
+    BoundingFrustum localFrustum;
+    mCamFrustum.Transform(localFrustum, invView * invWorld);
+
+    XMFLOAT3 localEyePos;
+    XMStoreFloat3(&localEyePos, XMVector3TransformCoord(XMLoadFloat3(&mEyePos), invWorld));
+
+    ClusterCuller::Cull(*mSkullRitem->Meshlets, localFrustum, localEyePos,
+        mSkullRitem->StartIndexLocation, mSkullRitem->DrawRanges);
+}
+
 void StencilApp::UpdateCamera(const GameTimer& gt)
 {
 
@@ -410,6 +551,8 @@ void StencilApp::UpdateObjectCBs(const GameTimer& gt)
             ObjectConstants objConstants;
             XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
             XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(texTransform));
+            objConstants.PositionOffset = e->PositionTransform.Offset;
+            objConstants.PositionScale = e->PositionTransform.Scale;
 
             currObjectCB->CopyData(e->ObjCBIndex, objConstants);
 
@@ -497,39 +640,39 @@ void StencilApp::UpdateReflectedPassCB(const GameTimer& gt)
 
 void StencilApp::LoadTextures()
 {
-    // ש
-    auto bricksTex = std::make_unique<Texture>();
-    bricksTex->Name = "bricksTex"; // 
-    bricksTex->Filename = L"../Textures/bricks3.dds"; // ·
-    // 
-    ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(), mCommandList.Get(), bricksTex->Filename.c_str(), bricksTex->Resource, bricksTex->UploadHeap));
-
-    // 
-    auto checkboardTex = std::make_unique<Texture>();
-    checkboardTex->Name = "checkboardTex"; // 
-    checkboardTex->Filename = L"../Textures/checkboard.dds"; // ·
-    // 
-    ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(), mCommandList.Get(), checkboardTex->Filename.c_str(), checkboardTex->Resource, checkboardTex->UploadHeap));
-
-    // 
-    auto iceTex = std::make_unique<Texture>();
-    iceTex->Name = "iceTex"; // 
-    iceTex->Filename = L"../Textures/ice.dds"; // ·
-    // 
-    ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(), mCommandList.Get(), iceTex->Filename.c_str(), iceTex->Resource, iceTex->UploadHeap));
-
-    // ɫ
-    auto white1x1Tex = std::make_unique<Texture>();
-    white1x1Tex->Name = "white1x1Tex"; // 
-    white1x1Tex->Filename = L"../Textures/white1x1.dds"; // ·
-    // 
-    ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(md3dDevice.Get(), mCommandList.Get(), white1x1Tex->Filename.c_str(), white1x1Tex->Resource, white1x1Tex->UploadHeap));
-
-    // ָƶ
-    mTextures[bricksTex->Name] = std::move(bricksTex);
-    mTextures[checkboardTex->Name] = std::move(checkboardTex);
-    mTextures[iceTex->Name] = std::move(iceTex);
-    mTextures[white1x1Tex->Name] = std::move(white1x1Tex);
+    // The files are read and parsed on the thread pool, most needed first; only
+    // the uploads run on this thread, each as soon as its file is in.
+    struct TextureFile {
+        const char* Name;
+        const wchar_t* Filename;
+        int Priority;
+    };
+    const TextureFile textureFiles[] = {
+        { "bricksTex", L"../Textures/bricks3.dds", 3 }, // walls
+        { "checkboardTex", L"../Textures/checkboard.dds", 2 }, // floor
+        { "iceTex", L"../Textures/ice.dds", 1 }, // mirror
+        { "white1x1Tex", L"../Textures/white1x1.dds", 0 }, // skull
+    };
+
+    TextureLoadQueue loadQueue(ThreadPool::Default(), TextureLoadQueue::Options());
+
+    std::vector<TextureLoadQueue::Ticket> tickets;
+    for (const TextureFile& file : textureFiles)
+        tickets.push_back(loadQueue.Load(file.Filename, file.Priority));
+
+    for (size_t i = 0; i < tickets.size(); ++i) {
+        auto tex = std::make_unique<Texture>();
+        tex->Name = textureFiles[i].Name;
+        tex->Filename = textureFiles[i].Filename;
+
+        // The upload copies out of the mapped file while it is recorded, so the
+        // file is released, and its staging budget returned, right after.
+        TextureLoadQueue::LoadedTexturePtr loaded = loadQueue.Get(tickets[i]);
+        ThrowIfFailed(DirectX::CreateDDSTextureFromMemory12(md3dDevice.Get(), mCommandList.Get(),
+            loaded->Data(), loaded->Size(), tex->Resource, tex->UploadHeap));
+
+        mTextures[tex->Name] = std::move(tex);
+    }
 }
 
 void StencilApp::BuildRootSignature()
@@ -646,6 +789,21 @@ void StencilApp::BuildShadersAndInputLayout()
         { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
         { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
     };
+
+    // Vertices encoded by VertexQuantizer with 16-bit normals: the input
+    // assembler expands every attribute, the VS applies the position transform.
+    const D3D_SHADER_MACRO quantizedDefines[] = {
+        "QUANTIZED_VERTEX", "1",
+        NULL, NULL
+    };
+
+    mShaders["quantizedVS"] = d3dUtil::CompileShader(L"Default.hlsl", quantizedDefines, "VS", "vs_5_0");
+
+    mQuantizedInputLayout = {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
 }
 
 void StencilApp::BuildRoomGeometry()
@@ -718,6 +876,15 @@ void StencilApp::BuildRoomGeometry()
     SubmeshGeometry wallSubmesh(18, 6, 0);
     SubmeshGeometry mirrorSubmesh(6, 24, 0);
 
+    // Culling volumes of each part, from the vertices its indices reference.
+    const std::uint16_t* indices16 = reinterpret_cast<const std::uint16_t*>(indices.data());
+    for (SubmeshGeometry* submesh : { &floorSubmesh, &wallSubmesh, &mirrorSubmesh }) {
+        BoundsBuilder::Volumes volumes = BoundsBuilder::Compute(&vertices[0].Pos, sizeof(Vertex), vertices.size(),
+            indices16 + submesh->StartIndexLocation, submesh->IndexCount, submesh->BaseVertexLocation,
+            BoundsBuilder::Options());
+        BoundsBuilder::Assign(volumes, *submesh);
+    }
+
     const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
     const UINT ibByteSize = (UINT)indices.size() * sizeof(std::int16_t);
 
@@ -755,75 +922,231 @@ void StencilApp::BuildRoomGeometry()
 
 void StencilApp::BuildSkullGeometry()
 {
-    std::ifstream fin("Models/skull.txt");
+    const std::string sourceFile = "Models/skull.txt";
+    const std::string cacheFile = "Models/skull.mesh";
 
-    if (!fin) {
-        MessageBox(0, L"Models/skull.txt not found.", 0, 0);
-        return;
-    }
+    // Bump when the processing below changes, so old caches are rebuilt.
+    const std::uint32_t skullCacheVersion = 3;
 
-    UINT vcount = 0;
-    UINT tcount = 0;
-    std::string ignore;
+    // Triangle ratios of the simplified levels, drawn as "skull_lod1", "skull_lod2", ...
+    const std::vector<float> skullLodRatios = { 0.5f, 0.25f, 0.125f, 0.0625f };
 
-    fin >> ignore >> vcount;
-    fin >> ignore >> tcount;
-    fin >> ignore >> ignore >> ignore >> ignore;
+    std::vector<Vertex> vertices;
+    std::vector<std::uint32_t> indices;
 
-    std::vector<Vertex> vertices(vcount);
-    for (UINT i = 0; i < vcount; ++i) {
-        fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-        fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
+    //
+    // The binary cache holds the skull already optimized and in cluster order,
+    // followed by its simplified levels.  It is used while it still matches the
+    // text file it was built from; with no text file at all, any cache in the
+    // right format is accepted.
+    //
 
-        // Model does not have texture coordinates, so just zero them out.
-        vertices[i].TexC = { 0.0f, 0.0f };
+    std::uint64_t sourceHash = 0;
+    bool haveSource = MeshCache::HashFile(sourceFile, sourceHash);
+
+    MeshCache::Mesh cache;
+    bool cacheValid = MeshCache::Load(cacheFile, cache)
+        && cache.VertexStride == sizeof(Vertex)
+        && cache.IndexSize == sizeof(std::uint32_t)
+        && cache.ContentVersion == skullCacheVersion
+        && !cache.Submeshes.empty()
+        && (!haveSource || cache.SourceHash == sourceHash);
+
+    if (cacheValid) {
+        vertices.resize(cache.VertexCount());
+        CopyMemory(vertices.data(), cache.VertexData.data(), cache.VertexData.size());
+
+        indices.resize(cache.IndexCount());
+        CopyMemory(indices.data(), cache.IndexData.data(), cache.IndexData.size());
+
+        // These are the indices the clusters were built from when the cache
+        // was written, so this finds the same clusters.
+        mSkullMeshlets = MeshletBuilder::Build(indices.data(), cache.Submeshes[0].IndexCount,
+            &vertices[0].Pos, sizeof(Vertex), vertices.size());
+    } else {
+        XMFLOAT3 boundsMin;
+        XMFLOAT3 boundsMax;
+        if (!LoadSkullText(vertices, indices, boundsMin, boundsMax))
+            return;
+
+        // Merge duplicate vertices first so the passes below see the real
+        // connectivity.  Normal and UV seams stay split.
+        MeshWelder::Stats weld = MeshWelder::Weld(vertices, indices, VertexInterleaveLayout(), MeshWelder::Options());
+
+        std::string weldReport = "skull: welded " + std::to_string(weld.VertexCount) + " -> "
+            + std::to_string(weld.WeldedVertexCount) + " vertices, " + std::to_string(weld.DegenerateTriangles)
+            + " degenerate triangles removed\n";
+        ::OutputDebugStringA(weldReport.c_str());
+
+        //
+        // Reorder the triangles for the post-transform vertex cache, then renumber
+        // the vertices in the order the GPU will fetch them.
+        //
+
+        MeshOptimizer::CacheStats before = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+        MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+
+        std::vector<std::uint32_t> remap;
+        UINT usedVertexCount = MeshOptimizer::OptimizeVertexFetchRemap(indices.data(), indices.size(), vertices.size(), remap);
+        MeshOptimizer::RemapVertices(vertices, remap, usedVertexCount);
+
+        MeshOptimizer::CacheStats after = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+        std::string report = "skull: ACMR " + std::to_string(before.ACMR) + " -> " + std::to_string(after.ACMR)
+            + ", ATVR " + std::to_string(before.ATVR) + " -> " + std::to_string(after.ATVR) + "\n";
+        ::OutputDebugStringA(report.c_str());
+
+        //
+        // Cut the skull into clusters for per-cluster culling.  Each cluster
+        // is a contiguous run of these indices, so they are drawn as they are.
+        //
+
+        mSkullMeshlets = MeshletBuilder::Build(indices.data(), indices.size(),
+            &vertices[0].Pos, sizeof(Vertex), vertices.size());
+
+        //
+        // Write the processed mesh out so the next launch can skip all of the above.
+        //
+
+        cache = MeshCache::Mesh();
+        cache.SourceHash = sourceHash;
+        cache.ContentVersion = skullCacheVersion;
+        cache.VertexStride = sizeof(Vertex);
+        cache.IndexSize = sizeof(std::uint32_t);
+
+        cache.BoundsMin = boundsMin;
+        cache.BoundsMax = boundsMax;
+
+        MeshCache::Submesh submesh;
+        submesh.Name = "skull";
+        submesh.IndexCount = (std::uint32_t)indices.size();
+        submesh.BoundsMin = cache.BoundsMin;
+        submesh.BoundsMax = cache.BoundsMax;
+        cache.Submeshes.push_back(submesh);
+
+        //
+        // Simplified levels of detail.  They reuse the skull's vertices, so each
+        // is just one more index range after the full-detail one.
+        //
+
+        std::vector<MeshSimplifier::Lod> lods = MeshSimplifier::BuildLodChain(indices.data(), indices.size(),
+            vertices.data(), vertices.size(), VertexInterleaveLayout(), skullLodRatios, MeshSimplifier::Options());
+
+        for (size_t i = 0; i < lods.size(); ++i) {
+            std::vector<std::uint32_t>& lodIndices = lods[i].Indices;
+            MeshOptimizer::OptimizeVertexCache(lodIndices.data(), lodIndices.size(), vertices.size());
+
+            submesh.Name = "skull_lod" + std::to_string(i + 1);
+            submesh.IndexCount = (std::uint32_t)lodIndices.size();
+            submesh.StartIndexLocation = (std::uint32_t)indices.size();
+            submesh.GeometricError = lods[i].GeometricError;
+            cache.Submeshes.push_back(submesh);
+
+            indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+
+            std::string lodReport = "skull: " + submesh.Name + " " + std::to_string(lodIndices.size() / 3)
+                + " triangles, geometric error " + std::to_string(lods[i].GeometricError) + "\n";
+            ::OutputDebugStringA(lodReport.c_str());
+        }
+
+        const std::uint8_t* vertexBytes = reinterpret_cast<const std::uint8_t*>(vertices.data());
+        const std::uint8_t* indexBytes = reinterpret_cast<const std::uint8_t*>(indices.data());
+        cache.VertexData.assign(vertexBytes, vertexBytes + vertices.size() * sizeof(Vertex));
+        cache.IndexData.assign(indexBytes, indexBytes + indices.size() * sizeof(std::uint32_t));
+
+        if (!MeshCache::Save(cacheFile, cache))
+            ::OutputDebugStringA("skull: could not write Models/skull.mesh\n");
     }
 
-    fin >> ignore;
-    fin >> ignore;
-    fin >> ignore;
+    //
+    // Pack the index ranges of all the levels into one index buffer.
+    //
 
-    std::vector<std::int32_t> indices(3 * tcount);
-    for (UINT i = 0; i < tcount; ++i) {
-        fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
+    std::vector<IndexPacker::Submesh> packSubmeshes;
+    for (const MeshCache::Submesh& submesh : cache.Submeshes) {
+        IndexPacker::Submesh packSubmesh;
+        packSubmesh.Name = submesh.Name;
+        packSubmesh.IndexCount = submesh.IndexCount;
+        packSubmesh.StartIndexLocation = submesh.StartIndexLocation;
+        packSubmesh.BaseVertexLocation = submesh.BaseVertexLocation;
+        packSubmeshes.push_back(packSubmesh);
     }
 
-    fin.close();
+    IndexPacker::PackedIndices packedIndices = IndexPacker::Pack(indices, packSubmeshes);
 
     //
-    // Pack the indices of all the meshes into one index buffer.
+    // Quantize the vertices for the GPU: 32 bytes become 16 (mQuantizedInputLayout).
     //
 
-    const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
+    VertexQuantizer::EncodedVertices encoded = VertexQuantizer::Encode(vertices.data(), vertices.size(),
+        VertexInterleaveLayout(), VertexQuantizer::Options());
+    mSkullPositionTransform = encoded.Transforms[0];
+
+    const VertexQuantizer::ErrorReport& errors = encoded.Errors;
+    std::string quantReport = "skull: vertices " + std::to_string(errors.SourceBytes) + " -> "
+        + std::to_string(errors.EncodedBytes) + " bytes, max position error " + std::to_string(errors.MaxPositionError)
+        + ", max normal error " + std::to_string(errors.MaxNormalAngle) + " deg\n";
+    ::OutputDebugStringA(quantReport.c_str());
 
-    const UINT ibByteSize = (UINT)indices.size() * sizeof(std::int32_t);
+    const UINT vbByteSize = (UINT)encoded.Data.size();
 
     auto geo = std::make_unique<MeshGeometry>();
     geo->Name = "skullGeo";
 
     ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-    CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-    ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-    CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+    CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), encoded.Data.data(), vbByteSize);
 
     geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-        mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-
-    geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-        mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
+        mCommandList.Get(), encoded.Data.data(), vbByteSize, geo->VertexBufferUploader);
 
-    geo->VertexByteStride = sizeof(Vertex);
+    geo->VertexByteStride = encoded.Layout.Stride;
     geo->VertexBufferByteSize = vbByteSize;
-    geo->IndexFormat = DXGI_FORMAT_R32_UINT;
-    geo->IndexBufferByteSize = ibByteSize;
 
-    SubmeshGeometry submesh((UINT)indices.size(), 0, 0);
-    geo->DrawArgs["skull"] = submesh;
+    geo->SetIndices(md3dDevice.Get(), mCommandList.Get(), packedIndices);
+
+    for (const MeshCache::Submesh& submesh : cache.Submeshes) {
+        SubmeshGeometry& drawArgs = geo->DrawArgs[submesh.Name];
+        drawArgs.GeometricError = submesh.GeometricError;
+
+        // From the vertices each level actually uses, so coarser levels get
+        // volumes of their own.
+        BoundsBuilder::Volumes volumes = BoundsBuilder::Compute(&vertices[0].Pos, sizeof(Vertex), vertices.size(),
+            indices.data() + submesh.StartIndexLocation, submesh.IndexCount, submesh.BaseVertexLocation,
+            BoundsBuilder::Options());
+        BoundsBuilder::Assign(volumes, drawArgs);
+    }
 
     mGeometries[geo->Name] = std::move(geo);
 }
 
+bool StencilApp::LoadSkullText(std::vector<Vertex>& vertices, std::vector<std::uint32_t>& indices,
+    XMFLOAT3& boundsMin, XMFLOAT3& boundsMax)
+{
+    ModelReader::Model model;
+    std::string error;
+    if (!ModelReader::Load("Models/skull.txt", model, &error)) {
+        std::wstring message = L"Models/skull.txt: " + AnsiToWString(error);
+        MessageBox(0, message.c_str(), 0, 0);
+        return false;
+    }
+
+    vertices.resize(model.Positions.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i].Pos = model.Positions[i];
+        vertices[i].Normal = model.Normals[i];
+
+        // Model does not have texture coordinates, so just zero them out.
+        vertices[i].TexC = { 0.0f, 0.0f };
+    }
+
+    indices.swap(model.Indices);
+    boundsMin = model.BoundsMin;
+    boundsMax = model.BoundsMax;
+
+    return true;
+}
+
 void StencilApp::BuildPSOs()
 {
     // Ⱦ˳
@@ -963,6 +1286,30 @@ void StencilApp::BuildPSOs()
     D3D12_GRAPHICS_PIPELINE_STATE_DESC drawShadowsPsoDesc = transparentPsoDesc;
     drawShadowsPsoDesc.DepthStencilState = shadowDSS; // ģ״̬
     ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&drawShadowsPsoDesc, IID_PPV_ARGS(&mPSOs["shadow"])));
+
+    // Quantized vertex PSOs--------------------------
+    // Same states, with the vertex shader and input layout for VertexQuantizer vertices.
+
+    D3D12_SHADER_BYTECODE quantizedVS = {
+        reinterpret_cast<BYTE*>(mShaders["quantizedVS"]->GetBufferPointer()),
+        mShaders["quantizedVS"]->GetBufferSize()
+    };
+    D3D12_INPUT_LAYOUT_DESC quantizedInputLayout = { mQuantizedInputLayout.data(), (UINT)mQuantizedInputLayout.size() };
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC opaqueQuantizedPsoDesc = opaquePsoDesc;
+    opaqueQuantizedPsoDesc.VS = quantizedVS;
+    opaqueQuantizedPsoDesc.InputLayout = quantizedInputLayout;
+    ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&opaqueQuantizedPsoDesc, IID_PPV_ARGS(&mPSOs["opaqueQuantized"])));
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC drawReflectionsQuantizedPsoDesc = drawReflectionsPsoDesc;
+    drawReflectionsQuantizedPsoDesc.VS = quantizedVS;
+    drawReflectionsQuantizedPsoDesc.InputLayout = quantizedInputLayout;
+    ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&drawReflectionsQuantizedPsoDesc, IID_PPV_ARGS(&mPSOs["drawStencilReflectionsQuantized"])));
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC drawShadowsQuantizedPsoDesc = drawShadowsPsoDesc;
+    drawShadowsQuantizedPsoDesc.VS = quantizedVS;
+    drawShadowsQuantizedPsoDesc.InputLayout = quantizedInputLayout;
+    ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&drawShadowsQuantizedPsoDesc, IID_PPV_ARGS(&mPSOs["shadowQuantized"])));
 }
 
 void StencilApp::BuildFrameResources()
@@ -1048,6 +1395,8 @@ void StencilApp::BuildRenderItems()
     wallsRitem->BaseVertexLocation = wallsRitem->Geo->DrawArgs["wall"].BaseVertexLocation;
     mRitemLayer[(int)RenderLayer::Opaque].push_back(wallsRitem.get());
 
+    mSkullLods = LodSelector::MakeLodSet(*mGeometries["skullGeo"], "skull");
+
     auto skullRitem = std::make_unique<RenderItem>();
     skullRitem->World = MathHelper::Identity4x4();
     skullRitem->TexTransform = MathHelper::Identity4x4();
@@ -1058,15 +1407,17 @@ void StencilApp::BuildRenderItems()
     skullRitem->IndexCount = skullRitem->Geo->DrawArgs["skull"].IndexCount;
     skullRitem->StartIndexLocation = skullRitem->Geo->DrawArgs["skull"].StartIndexLocation;
     skullRitem->BaseVertexLocation = skullRitem->Geo->DrawArgs["skull"].BaseVertexLocation;
+    skullRitem->PositionTransform = mSkullPositionTransform;
+    skullRitem->Lods = &mSkullLods;
     mSkullRitem = skullRitem.get();
-    mRitemLayer[(int)RenderLayer::Opaque].push_back(skullRitem.get());
+    mRitemLayer[(int)RenderLayer::OpaqueQuantized].push_back(skullRitem.get());
 
     // Reflected skull will have different world matrix, so it needs to be its own render item.
     auto reflectedSkullRitem = std::make_unique<RenderItem>();
     *reflectedSkullRitem = *skullRitem;
     reflectedSkullRitem->ObjCBIndex = 3;
     mReflectedSkullRitem = reflectedSkullRitem.get();
-    mRitemLayer[(int)RenderLayer::Reflected].push_back(reflectedSkullRitem.get());
+    mRitemLayer[(int)RenderLayer::ReflectedQuantized].push_back(reflectedSkullRitem.get());
 
     // Shadowed skull will have different world matrix, so it needs to be its own render item.
     auto shadowedSkullRitem = std::make_unique<RenderItem>();
@@ -1074,7 +1425,10 @@ void StencilApp::BuildRenderItems()
     shadowedSkullRitem->ObjCBIndex = 4;
     shadowedSkullRitem->Mat = mMaterials["shadowMat"].get();
     mShadowedSkullRitem = shadowedSkullRitem.get();
-    mRitemLayer[(int)RenderLayer::Shadow].push_back(shadowedSkullRitem.get());
+    mRitemLayer[(int)RenderLayer::ShadowQuantized].push_back(shadowedSkullRitem.get());
+
+    // Only the unmirrored skull is cluster culled, so set this after the copies.
+    skullRitem->Meshlets = &mSkullMeshlets;
 
     auto mirrorRitem = std::make_unique<RenderItem>();
     mirrorRitem->World = MathHelper::Identity4x4();
@@ -1123,7 +1477,17 @@ void StencilApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::
         cmdList->SetGraphicsRootConstantBufferView(1, objCBAddress);
         cmdList->SetGraphicsRootConstantBufferView(3, matCBAddress);
 
-        cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+        if (ri->Meshlets != nullptr && ri->LodLevel <= 0) {
+            for (const ClusterCuller::DrawRange& range : ri->DrawRanges) {
+                cmdList->DrawIndexedInstanced(range.IndexCount, 1, range.StartIndexLocation, ri->BaseVertexLocation, 0);
+                mFrameDrawCalls++;
+                mFrameTriangles += range.IndexCount / 3;
+            }
+        } else {
+            cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+            mFrameDrawCalls++;
+            mFrameTriangles += ri->IndexCount / 3;
+        }
     }
 }
 
@@ -0,0 +1,139 @@
+//***************************************************************************************
+// MeshSimplifierErrorTest.cpp
+//
+// Checks that every level MeshSimplifier builds reports a GeometricError no
+// smaller than the brute-force distance from each source vertex to the level's
+// live triangles.  LodSelector trusts that number as an upper bound, so an
+// under-reported error picks levels that are too coarse.
+//
+// Console program; returns 0 when every level passes.  From a Developer
+// Command Prompt in this folder:
+//
+//   cl /EHsc /std:c++17 /O2 /I..\Common MeshSimplifierErrorTest.cpp ..\Common\MeshSimplifier.cpp
+//      ..\Common\GeometryGenerator.cpp ..\Common\ThreadPool.cpp
+//***************************************************************************************
+
+#include "GeometryGenerator.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	XMVECTOR ClosestPointOnTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c)
+	{
+		XMVECTOR ab = b - a;
+		XMVECTOR ac = c - a;
+		XMVECTOR ap = p - a;
+		float d1 = XMVectorGetX(XMVector3Dot(ab, ap));
+		float d2 = XMVectorGetX(XMVector3Dot(ac, ap));
+		if(d1 <= 0.0f && d2 <= 0.0f)
+			return a;
+
+		XMVECTOR bp = p - b;
+		float d3 = XMVectorGetX(XMVector3Dot(ab, bp));
+		float d4 = XMVectorGetX(XMVector3Dot(ac, bp));
+		if(d3 >= 0.0f && d4 <= d3)
+			return b;
+
+		float vc = d1*d4 - d3*d2;
+		if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			return a + ab*(d1 / (d1 - d3));
+
+		XMVECTOR cp = p - c;
+		float d5 = XMVectorGetX(XMVector3Dot(ab, cp));
+		float d6 = XMVectorGetX(XMVector3Dot(ac, cp));
+		if(d6 >= 0.0f && d5 <= d6)
+			return c;
+
+		float vb = d5*d2 - d1*d6;
+		if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			return a + ac*(d2 / (d2 - d6));
+
+		float va = d3*d6 - d5*d4;
+		if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+			return b + (c - b)*((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		float denom = 1.0f / (va + vb + vc);
+		return a + ab*(vb*denom) + ac*(vc*denom);
+	}
+
+	// Largest distance from a vertex the source triangles use to the nearest
+	// triangle of indices.
+	float BruteForceError(const GeometryGenerator::MeshData& mesh, const std::vector<std::uint32_t>& indices)
+	{
+		std::vector<char> used(mesh.Vertices.size(), 0);
+		for(std::uint32_t index : mesh.Indices32)
+			used[index] = 1;
+
+		float worst = 0.0f;
+		for(size_t v = 0; v < mesh.Vertices.size(); ++v)
+		{
+			if(!used[v])
+				continue;
+
+			XMVECTOR p = XMLoadFloat3(&mesh.Vertices[v].Position);
+			float best = FLT_MAX;
+			for(size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				XMVECTOR q = ClosestPointOnTriangle(p,
+					XMLoadFloat3(&mesh.Vertices[indices[i + 0]].Position),
+					XMLoadFloat3(&mesh.Vertices[indices[i + 1]].Position),
+					XMLoadFloat3(&mesh.Vertices[indices[i + 2]].Position));
+				best = std::min(best, XMVectorGetX(XMVector3LengthSq(q - p)));
+			}
+
+			worst = std::max(worst, best);
+		}
+
+		return std::sqrt(worst);
+	}
+
+	bool Check(const std::string& name, const GeometryGenerator::MeshData& mesh, const std::vector<float>& ratios)
+	{
+		std::vector<MeshSimplifier::Lod> lods = MeshSimplifier::BuildLodChain(mesh, ratios, MeshSimplifier::Options());
+
+		// Float round-off of the brute-force search grows with the coordinates.
+		float size = 0.0f;
+		for(const GeometryGenerator::Vertex& vertex : mesh.Vertices)
+		{
+			size = std::max(size, std::max(std::abs(vertex.Position.x),
+				std::max(std::abs(vertex.Position.y), std::abs(vertex.Position.z))));
+		}
+
+		bool ok = true;
+		for(const MeshSimplifier::Lod& lod : lods)
+		{
+			float expected = BruteForceError(mesh, lod.Indices);
+
+			bool pass = lod.GeometricError >= expected*(1.0f - 1e-4f) - 1e-6f*size;
+			std::printf("%-10s %6zu triangles: reported %g, brute force %g  %s\n", name.c_str(),
+				lod.Indices.size() / 3, lod.GeometricError, expected, pass ? "ok" : "FAIL");
+
+			ok = ok && pass;
+		}
+
+		return ok;
+	}
+}
+
+int main()
+{
+	GeometryGenerator geoGen;
+
+	bool ok = true;
+	ok = Check("geosphere", geoGen.CreateGeosphere(1.0f, 4), { 0.5f, 0.1f, 0.02f }) && ok;
+	ok = Check("sphere", geoGen.CreateSphere(1.0f, 40, 40), { 0.5f, 0.1f }) && ok;
+	ok = Check("cylinder", geoGen.CreateCylinder(1.0f, 0.5f, 3.0f, 30, 10), { 0.5f, 0.1f }) && ok;
+	ok = Check("grid", geoGen.CreateGrid(10.0f, 10.0f, 30, 30), { 0.5f, 0.1f }) && ok;
+
+	std::printf(ok ? "passed\n" : "FAILED\n");
+	return ok ? 0 : 1;
+}